@@ -0,0 +1,410 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROOST_LIB_CORE_HPP
+#define ROOST_LIB_CORE_HPP
+
+#include "roost/alias.hpp"
+#include "roost/common.hpp"
+#include "roost/memory_resource.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace roost
+{
+
+/*!
+ * \brief core holds the non-template tree algorithms shared by every StateMachine<CTX, E>
+ *
+ * The typed Node and StateMachine classes are thin wrappers around this namespace.  Everything in
+ * here works on node indices (NodeId) and compact tables, and is compiled once into libroosthsm
+ * instead of being instantiated for every context/event pair.
+ *
+ * A node id is the index of the node in a pre-order walk of the tree starting at Top, so Top is
+ * always id 0.
+ */
+namespace core
+{
+
+using NodeId = u32;
+
+//! Id used for "no node" (i.e. the nullptr of node ids)
+const NodeId INVALID_NODE = 0xFFFFFFFF;
+
+//! Id of the Top region in every Topology
+const NodeId TOP_NODE = 0;
+
+//! Every container of the core allocates from the MemoryResource of its StateMachine
+template <typename T>
+using Vector = std::vector<T, ResourceAllocator<T>>;
+
+//! A Vector whose elements start on a cache line, for the arrays read on every event
+template <typename T>
+using CacheLineVector = std::vector<T, ResourceAllocator<T, CACHE_LINE_SIZE>>;
+
+/*!
+ * \brief TreeAccess lets the core walk a typed node tree without knowing its type
+ *
+ * Every function is handed a node as a void pointer and must interpret it as the typed node.
+ */
+struct TreeAccess
+{
+    size_t (*num_children)(void* node);            //!< Number of children of the node
+    void* (*child)(void* node, size_t idx);        //!< The idx-th child of the node
+    void* (*parent)(void* node);                   //!< The parent of the node, may be nullptr
+    void* (*initial_child)(void* node);            //!< The initial child, may be nullptr
+    NodeType (*type)(void* node);                  //!< The type of the node
+    NodeId (*get_id)(void* node);                  //!< The id stored on the node
+    void (*set_id)(void* node, NodeId id);         //!< Stores an id on the node
+};  // Struct: TreeAccess
+
+/*!
+ * \brief Topology is the flattened, read-only shape of a tree indexed by NodeId
+ *
+ * Children are stored in compressed rows: the children of node n are
+ * children[child_offsets[n]] ... children[child_offsets[n + 1] - 1], in declaration order.
+ *
+ * The ancestors table is a binary lifting index used to find the LCA of two nodes in
+ * O(log(depth)): ancestors[k * size() + n] is the 2^k-th ancestor of n (Top is its own ancestor).
+ *
+ * Only the nodes flagged in records_history have their last active child recorded when exited,
+ * see markHistory().  The flags aren't part of the shape of the tree, they are set from the
+ * transition tables and never saved to a topology cache.
+ */
+struct Topology
+{
+    Vector<NodeId>   parent;           //!< Parent of each node, INVALID_NODE for Top
+    Vector<NodeId>   initial_child;    //!< Initial child of each node or INVALID_NODE
+    Vector<NodeType> type;             //!< Type of each node
+    Vector<NodeId>   region;           //!< Closest region at or above each node
+    Vector<u32>      level;            //!< Level of each region (Top is 1), 0 if not a region
+    Vector<u32>      child_offsets;    //!< Offsets into children, one more than the node count
+    Vector<NodeId>   children;         //!< All children, grouped by parent
+    Vector<u32>      depth;            //!< Depth of each node (Top is 1)
+    Vector<NodeId>   ancestors;        //!< Binary lifting table, lca_levels rows of size()
+    Vector<u8>       records_history;  //!< Non-zero if the node records its last active child
+    u32              lca_levels;       //!< Number of rows in the ancestors table
+
+    size_t max_depth;          //!< The maximum depth of the tree (Top is depth 1)
+    size_t number_of_regions;  //!< The number of regions in the tree (Top included)
+
+    explicit Topology(MemoryResource* resource = defaultResource())
+        : parent(resource),
+          initial_child(resource),
+          type(resource),
+          region(resource),
+          level(resource),
+          child_offsets(resource),
+          children(resource),
+          depth(resource),
+          ancestors(resource),
+          records_history(resource),
+          lca_levels(0),
+          max_depth(0),
+          number_of_regions(0)
+    {
+    }
+
+    size_t size() const
+    {
+        return parent.size();
+    }
+
+    const NodeId* childrenBegin(NodeId node) const
+    {
+        return children.data() + child_offsets[node];
+    }
+
+    const NodeId* childrenEnd(NodeId node) const
+    {
+        return children.data() + child_offsets[node + 1];
+    }
+
+    NodeId ancestor(u32 k, NodeId node) const
+    {
+        return ancestors[k * size() + node];
+    }
+};  // Struct: Topology
+
+/*!
+ * \brief Runtime is the mutable state of a StateMachine indexed by NodeId
+ */
+struct Runtime
+{
+    Vector<NodeId> current;      //!< The current node of each region (only valid for regions)
+    Vector<NodeId> last_active;  //!< The last active child for history
+    Vector<NodeId> entry_path;   //!< Scratch space for entering a transition's destination
+
+    explicit Runtime(MemoryResource* resource = defaultResource())
+        : current(resource), last_active(resource), entry_path(resource)
+    {
+    }
+};  // Struct: Runtime
+
+/*!
+ * \brief History is how a transition enters its destination
+ *
+ * History targets aren't nodes: a transition to the history of a composite node is routed to the
+ * composite node itself and tagged with the kind of history to restore once it is entered.
+ */
+enum class History : u32
+{
+    NONE,     //!< Enter the initial children
+    SHALLOW,  //!< Enter the last active child, then its initial children
+    DEEP      //!< Enter the last active children all the way down
+};
+
+/*!
+ * \brief historyName returns the name history targets are reported with
+ * \return "ShallowHistory", "DeepHistory" or an empty string for History::NONE
+ */
+const char* historyName(History history);
+
+/*!
+ * \brief Hooks calls back into the typed StateMachine whenever a node is entered or exited
+ */
+struct Hooks
+{
+    void* ctx;                              //!< Passed back to each hook
+    void (*on_entry)(void* ctx, NodeId id);  //!< Called when a node is entered
+    void (*on_exit)(void* ctx, NodeId id);   //!< Called when a node is exited
+
+    //! Called when the history of a node is entered, right before its last active child
+    void (*on_history)(void* ctx, NodeId id, History history);
+};  // Struct: Hooks
+
+/*!
+ * \brief Route is the resolved path of a single transition table entry
+ *
+ * If the destination is INVALID_NODE then it is an internal transition and lca and lca_region are
+ * also INVALID_NODE.
+ */
+struct Route
+{
+    NodeId  src;          //!< The source node (may differ from the row's node, see makeRoute())
+    NodeId  src_region;   //!< The closest region of src
+    NodeId  destination;  //!< The destination node or INVALID_NODE
+    NodeId  lca;          //!< The lowest common ancestor of src and destination
+    NodeId  lca_region;   //!< The closest region of lca
+    History history;      //!< How destination is entered, only composite nodes have history
+};  // Struct: Route
+
+/*!
+ * \brief flatten pushes every node in the tree into a vector in pre-order
+ * \param access the accessors of the typed tree
+ * \param node the node to start at
+ * \param all_nodes the vector to push all node pointers to
+ */
+void flatten(TreeAccess const& access, void* node, std::vector<void*>& all_nodes);
+
+/*!
+ * \brief maxDepth returns the maximum depth found in a tree
+ * \param access the accessors of the typed tree
+ * \param node the node to start at
+ * \param depth the depth of node
+ * \return the maximum depth found
+ */
+size_t maxDepth(TreeAccess const& access, void* node, size_t depth = 1);
+
+/*!
+ * \brief findLca finds the lowest common ancestor of two typed nodes
+ *
+ * See Node::findLca() for the definition of the LCA.
+ *
+ * \return the LCA or nullptr if either node is nullptr
+ */
+void* findLca(TreeAccess const& access, void* src, void* dst);
+
+/*!
+ * \brief findLca finds the lowest common ancestor of two nodes in a Topology
+ *
+ * Uses the ancestors index, so this is O(log(depth)) instead of the O(depth^2) pointer walk.
+ *
+ * \return the LCA or INVALID_NODE if either node is INVALID_NODE
+ */
+NodeId findLca(Topology const& topology, NodeId src, NodeId dst);
+
+/*!
+ * \brief buildTopology assigns node ids to a tree and builds its Topology
+ *
+ * This is a single iterative walk of the tree, so it is linear in the number of nodes and
+ * doesn't recurse no matter how deep the tree is.
+ *
+ * \param access the accessors of the typed tree
+ * \param top the Top region of the tree
+ * \param all_nodes filled with every node in the tree, indexed by id
+ * \param topology the topology to build
+ */
+void buildTopology(
+        TreeAccess const& access,
+        void*             top,
+        Vector<void*>&    all_nodes,
+        Topology&         topology);
+
+/*!
+ * \brief makeRoute resolves the LCA and regions of a transition from src to dst
+ *
+ * A transition that has an LCA of an orthogonal node is transformed so that the orthogonal
+ * regions are exited and then default entered, i.e. the source and destination become the
+ * orthogonal node and the LCA becomes its parent.
+ *
+ * A transition to the history of a composite node behaves as if the history was a child of the
+ * composite node, so a transition from within the composite node (or from itself) doesn't exit it.
+ *
+ * \param topology the topology of the tree
+ * \param src the source node
+ * \param dst the destination node or INVALID_NODE for internal transitions
+ * \param history the history of dst to enter, dst must be a composite node if not History::NONE
+ */
+Route makeRoute(
+        Topology const& topology,
+        NodeId          src,
+        NodeId          dst,
+        History         history = History::NONE);
+
+/*!
+ * \brief markHistory makes the nodes a history transition reads record their last active child
+ *
+ * That is the composite node itself for shallow history, and every composite node and region
+ * under it as well for deep history.
+ *
+ * \param topology the topology of the tree
+ * \param node the composite node whose history is the destination of a transition
+ * \param history the history entered, nothing is marked for History::NONE
+ */
+void markHistory(Topology& topology, NodeId node, History history);
+
+/*!
+ * \brief markAllHistory makes every composite node and region record its last active child
+ *
+ * For when the history transitions aren't known up front (i.e. lazily created transition tables).
+ */
+void markAllHistory(Topology& topology);
+
+/*!
+ * \brief reset places every region at itself and resets history to the initial children
+ */
+void reset(Topology const& topology, Runtime& runtime);
+
+/*!
+ * \brief construct enters the initial children of a region, starting at its current node
+ */
+void construct(Topology const& topology, Runtime& runtime, Hooks const& hooks, NodeId region);
+
+/*!
+ * \brief constructFromDeepHistory re-enters the last active children of a region
+ */
+void constructFromDeepHistory(
+        Topology const& topology,
+        Runtime&        runtime,
+        Hooks const&    hooks,
+        NodeId          region);
+
+/*!
+ * \brief destructUntil exits the current nodes of a region until node is the current node
+ *
+ * Orthogonal nodes have their regions destructed first, and the last active children are
+ * recorded for history along the way (only by the nodes marked by markHistory()).
+ */
+void destructUntil(
+        Topology const& topology,
+        Runtime&        runtime,
+        Hooks const&    hooks,
+        NodeId          region,
+        NodeId          node);
+
+/*!
+ * \brief selectTransition applies the region level rule to a transition
+ *
+ * Transitions can make their way outside of their region, and once that happens a transition
+ * from a region that was exited must not fire.
+ *
+ * \param topology the topology of the tree
+ * \param current_level the level of the current step, 0 if not set yet
+ * \param route the route of the transition
+ * \return true if the transition should be taken, otherwise false
+ */
+bool selectTransition(Topology const& topology, u32& current_level, Route const& route);
+
+/*!
+ * \brief transition exits up to the LCA of a route and then enters its destination
+ *
+ * The route must have both a destination and an LCA.
+ */
+void transition(Topology const& topology, Runtime& runtime, Hooks const& hooks, Route const& route);
+
+/*!
+ * \brief flattenTransition lists what transition() does for a route when current is the current
+ * node of the region
+ *
+ * The nodes to exit are appended to steps first, followed by the nodes to enter.  Only valid for
+ * trees without orthogonal nodes and for routes without history, as anything else depends on
+ * more than the current node.
+ */
+void flattenTransition(
+        Topology const& topology,
+        NodeId          current,
+        Route const&    route,
+        Vector<NodeId>& steps,
+        u32&            num_exits,
+        u32&            num_entries);
+
+/*!
+ * \brief runSteps exits and then enters the nodes listed by flattenTransition()
+ *
+ * Has the same effect as transition() on the route that was flattened, including the history.
+ */
+void runSteps(
+        Topology const& topology,
+        Runtime&        runtime,
+        Hooks const&    hooks,
+        NodeId const*   exits,
+        u32             num_exits,
+        NodeId const*   entries,
+        u32             num_entries);
+
+/*!
+ * \brief matchFlags tests flags against count flag guards at once
+ *
+ * Bit i of the result is set if (flags & masks[i]) == expected[i], count must be at most 32.
+ * Four guards are tested per instruction where SSE2 is available.
+ */
+u32 matchFlags(u32 flags, u32 const* masks, u32 const* expected, u32 count);
+
+/*!
+ * \brief lowestBit returns the index of the lowest set bit, bits must not be 0
+ */
+u32 lowestBit(u32 bits);
+
+//! Called by currentNodes() with each node
+using NodeVisitor = void (*)(void* user, NodeId node);
+
+/*!
+ * \brief currentNodes visits the current node of a region and of every nested active region
+ *
+ * The nodes are visited breadth first, without allocating.
+ */
+void currentNodes(
+        Topology const& topology,
+        Runtime const&  runtime,
+        NodeId          region,
+        NodeVisitor     visit,
+        void*           user);
+
+}  // ns: core
+
+}  // ns: roost
+
+#endif  // ROOST_LIB_CORE_HPP
@@ -0,0 +1,224 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROOST_LIB_FIXED_STORAGE_HPP
+#define ROOST_LIB_FIXED_STORAGE_HPP
+
+#include "roost/alias.hpp"
+#include "roost/memory_resource.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/*!
+ * ROOST_NO_HEAP builds roost without any dynamic allocation:
+ * - The children of a node are kept in a FixedVector of ROOST_NO_HEAP_MAX_CHILDREN
+ * - A StateMachine allocates from an InlineResource of ROOST_NO_HEAP_ARENA_SIZE bytes that it
+ *   owns, unless given a resource
+ * - A StateMachine queues events in a RingFifo of ROOST_NO_HEAP_FIFO_SIZE events, unless given
+ *   a queue, and has no spy unless given one
+ *
+ * Define the capacities before including any roost header (or on the command line) to override
+ * them.  Exceeding one is reported to the spy by init() (or handleEvent() for the queue).
+ */
+#ifndef ROOST_NO_HEAP_MAX_CHILDREN
+#define ROOST_NO_HEAP_MAX_CHILDREN 16
+#endif
+
+#ifndef ROOST_NO_HEAP_ARENA_SIZE
+#define ROOST_NO_HEAP_ARENA_SIZE 32768
+#endif
+
+#ifndef ROOST_NO_HEAP_FIFO_SIZE
+#define ROOST_NO_HEAP_FIFO_SIZE 32
+#endif
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define ROOST_HAS_EXCEPTIONS 1
+#else
+#define ROOST_HAS_EXCEPTIONS 0
+#endif
+
+namespace roost
+{
+
+/*!
+ * \brief FixedVector is a vector of pointers (or other trivial values) with inline storage
+ *
+ * Pushing onto a full FixedVector drops the value and marks the vector as overflowed, so the
+ * owner can report it later instead of failing where it happened (i.e. in a constructor).
+ *
+ * \tparam T the value type, must be trivially copyable
+ * \tparam N the capacity
+ */
+template <typename T, size_t N>
+class FixedVector
+{
+public:
+    FixedVector() : m_values(), m_size(0), m_overflowed(false)
+    {
+    }
+
+    bool push_back(T const& value)
+    {
+        if (m_size == N)
+        {
+            m_overflowed = true;
+            return false;
+        }
+
+        m_values[m_size++] = value;
+        return true;
+    }
+
+    void clear()
+    {
+        m_size       = 0;
+        m_overflowed = false;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    //! Returns true if a push_back() was dropped since the last clear()
+    bool overflowed() const
+    {
+        return m_overflowed;
+    }
+
+    T& operator[](size_t idx)
+    {
+        return m_values[idx];
+    }
+
+    T const& operator[](size_t idx) const
+    {
+        return m_values[idx];
+    }
+
+    T* begin()
+    {
+        return m_values;
+    }
+
+    T* end()
+    {
+        return m_values + m_size;
+    }
+
+    T const* begin() const
+    {
+        return m_values;
+    }
+
+    T const* end() const
+    {
+        return m_values + m_size;
+    }
+
+private:
+    T      m_values[N];   //!< The storage
+    size_t m_size;        //!< Number of values in m_values
+    bool   m_overflowed;  //!< True if a value was dropped
+};  // Class: FixedVector
+
+/*!
+ * \brief InlineResource is a MemoryResource over a buffer inside the object itself
+ *
+ * Memory is handed out in order and only given back all at once by release(), which suits the
+ * allocations made by StateMachine::init().  Running out of memory throws std::bad_alloc (or
+ * aborts when built without exceptions), the StateMachine turns that into an init() failure.
+ *
+ * \tparam N the size of the buffer in bytes
+ */
+template <size_t N>
+class InlineResource final : public MemoryResource
+{
+public:
+    InlineResource() : m_used(0), m_peak(0)
+    {
+    }
+
+    InlineResource(InlineResource const&) = delete;
+    InlineResource& operator=(InlineResource const&) = delete;
+
+    //! Makes the whole buffer available again, nothing allocated from it may be used afterwards
+    void release()
+    {
+        m_used = 0;
+    }
+
+    //! Returns the number of bytes handed out since the last release()
+    size_t used() const
+    {
+        return m_used;
+    }
+
+    //! Returns the highest used() seen, useful for sizing N
+    size_t peak() const
+    {
+        return m_peak;
+    }
+
+    size_t capacity() const
+    {
+        return N;
+    }
+
+protected:
+    void* doAllocate(size_t bytes, size_t alignment) override
+    {
+        // Aligned by address, the buffer itself is only aligned to max_align_t
+        uintptr_t base  = reinterpret_cast<uintptr_t>(m_buffer);
+        size_t    start = static_cast<size_t>(
+                (base + m_used + alignment - 1) / alignment * alignment - base);
+
+        if (start > N || bytes > N - start)
+        {
+#if ROOST_HAS_EXCEPTIONS
+            throw std::bad_alloc();
+#else
+            std::abort();
+#endif
+        }
+
+        m_used = start + bytes;
+        m_peak = m_used > m_peak ? m_used : m_peak;
+
+        return m_buffer + start;
+    }
+
+    void doDeallocate(void*, size_t, size_t) override
+    {
+        // Only release() gives memory back
+    }
+
+private:
+    alignas(std::max_align_t) char m_buffer[N];  //!< The memory handed out
+    size_t m_used;                               //!< Bytes handed out
+    size_t m_peak;                               //!< The highest m_used seen
+};  // Class: InlineResource
+
+}  // ns: roost
+
+#endif  // ROOST_LIB_FIXED_STORAGE_HPP
@@ -0,0 +1,112 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROOST_LIB_MEMORY_REPORT_HPP
+#define ROOST_LIB_MEMORY_REPORT_HPP
+
+#include "roost/common.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+namespace roost
+{
+
+/*!
+ * \brief NodeMemory is the memory a single node takes up, in bytes
+ *
+ * The table fields split the block of the transition table of the node, padding included, so
+ * they add up to tableBytes().  Delegates are counted at sizeof(std::function), a closure too
+ * large for it to store inline lives on the heap and isn't counted.
+ */
+struct NodeMemory
+{
+    const char* name;            //!< The name of the node
+    NodeType    type;            //!< The type of the node
+    size_t      object_bytes;    //!< The roost part of the node object, owned by the user
+    size_t      children_bytes;  //!< The child list, unless stored in the object
+    size_t      index_bytes;     //!< The sorted events of the transition table and their offsets
+    size_t      row_bytes;       //!< The rows of the transition table
+    size_t      delegate_bytes;  //!< The guards and actions of the rows
+    size_t      name_bytes;      //!< The names of the guards and actions
+    size_t      num_rows;        //!< Number of rows in the transition table
+    size_t      num_actions;     //!< Number of actions of all rows
+
+    size_t tableBytes() const
+    {
+        return index_bytes + row_bytes + delegate_bytes + name_bytes;
+    }
+};  // Struct: NodeMemory
+
+/*!
+ * \brief MemoryReport is the memory a StateMachine and its nodes take up, in bytes
+ *
+ * Containers are counted by capacity, so the report matches what was allocated rather than what
+ * is used.  See StateMachine::memoryReport().
+ */
+struct MemoryReport
+{
+    std::vector<NodeMemory> nodes;  //!< Every node, indexed by node id (Top first)
+
+    size_t machine_bytes;   //!< The StateMachine object, including anything stored inline
+    size_t node_bytes;      //!< The object and child list of every node
+    size_t table_bytes;     //!< The transition tables of every node
+    size_t topology_bytes;  //!< The shape of the tree
+    size_t history_bytes;   //!< The last active children and the nodes recording them
+    size_t runtime_bytes;   //!< The current node of each region and the entry path
+    size_t dispatch_bytes;  //!< What handling an event reads about each node
+    size_t scratch_bytes;   //!< Selected transitions, node lookup, lazy state and route log
+    size_t spy_bytes;       //!< As reported by Spy::memoryBytes()
+    size_t fifo_bytes;      //!< As reported by IFifo::memoryBytes(), 0 if stored inline
+    size_t total_bytes;     //!< The sum of all of the above
+
+    MemoryReport()
+        : nodes(),
+          machine_bytes(0),
+          node_bytes(0),
+          table_bytes(0),
+          topology_bytes(0),
+          history_bytes(0),
+          runtime_bytes(0),
+          dispatch_bytes(0),
+          scratch_bytes(0),
+          spy_bytes(0),
+          fifo_bytes(0),
+          total_bytes(0)
+    {
+    }
+
+    /*!
+     * \brief toJSON outputs the report as a single JSON object
+     *
+     * Every field of the report is a key, with "nodes" an array of objects keyed by the fields
+     * of NodeMemory plus "table_bytes".
+     *
+     * \param os the ostream to write to
+     */
+    void toJSON(std::ostream& os) const;
+};  // Struct: MemoryReport
+
+//! The bytes allocated for the elements of a vector
+template <typename Vector>
+size_t capacityBytes(Vector const& v)
+{
+    return v.capacity() * sizeof(typename Vector::value_type);
+}
+
+}  // ns: roost
+
+#endif  // ROOST_LIB_MEMORY_REPORT_HPP
@@ -0,0 +1,280 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROOST_LIB_MEMORY_RESOURCE_HPP
+#define ROOST_LIB_MEMORY_RESOURCE_HPP
+
+#include "roost/alias.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace roost
+{
+
+//! The alignment of the arrays read on every event, so they start on a cache line
+static const size_t CACHE_LINE_SIZE = 64;
+
+/*!
+ * \brief MemoryResource is where the containers of a StateMachine get their memory from
+ *
+ * This is a C++11 stand-in for std::pmr::memory_resource: derive from it to hand roost memory
+ * from an arena, a per-core pool, huge pages, etc.  A resource must outlive every StateMachine
+ * (and Node) that uses it.
+ *
+ * Alignments up to CACHE_LINE_SIZE must be honoured, roost asks for it for the arrays it reads
+ * on every event.
+ */
+class MemoryResource
+{
+public:
+    virtual ~MemoryResource() = default;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+    {
+        return doAllocate(bytes, alignment);
+    }
+
+    void deallocate(void* p, size_t bytes, size_t alignment = alignof(std::max_align_t))
+    {
+        doDeallocate(p, bytes, alignment);
+    }
+
+    //! Returns true if memory allocated by one resource can be deallocated by the other
+    bool isEqual(MemoryResource const& other) const noexcept
+    {
+        return this == &other || doIsEqual(other);
+    }
+
+protected:
+    virtual void* doAllocate(size_t bytes, size_t alignment)            = 0;
+    virtual void  doDeallocate(void* p, size_t bytes, size_t alignment) = 0;
+
+    virtual bool doIsEqual(MemoryResource const& other) const noexcept
+    {
+        return this == &other;
+    }
+};  // Class: MemoryResource
+
+/*!
+ * \brief defaultResource returns the resource used when none is given, backed by new/delete
+ *
+ * Like new/delete, it can be used from any number of threads at once.
+ */
+MemoryResource* defaultResource() noexcept;
+
+/*!
+ * \brief ResourceAllocator is a standard allocator that allocates from a MemoryResource
+ *
+ * The resource propagates on copy, move and swap, so a container that is assigned a container
+ * built with another resource switches to that resource.
+ *
+ * \tparam T the type to allocate
+ * \tparam ALIGN the alignment of the memory, at least that of T
+ */
+template <typename T, size_t ALIGN = alignof(T)>
+class ResourceAllocator
+{
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = ResourceAllocator<U, ALIGN>;
+    };
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    ResourceAllocator() noexcept : m_resource(defaultResource())
+    {
+    }
+
+    // Implicit so that a container can be constructed from a resource
+    ResourceAllocator(MemoryResource* resource) noexcept : m_resource(resource)
+    {
+    }
+
+    template <typename U, size_t A>
+    ResourceAllocator(ResourceAllocator<U, A> const& o) noexcept : m_resource(o.resource())
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(m_resource->allocate(n * sizeof(T), alignment()));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        m_resource->deallocate(p, n * sizeof(T), alignment());
+    }
+
+    MemoryResource* resource() const noexcept
+    {
+        return m_resource;
+    }
+
+private:
+    static size_t alignment()
+    {
+        return ALIGN > alignof(T) ? ALIGN : alignof(T);
+    }
+
+    MemoryResource* m_resource;  //!< Never nullptr
+};  // Class: ResourceAllocator
+
+template <typename T, size_t A, typename U, size_t B>
+bool operator==(ResourceAllocator<T, A> const& a, ResourceAllocator<U, B> const& b) noexcept
+{
+    return a.resource()->isEqual(*b.resource());
+}
+
+template <typename T, size_t A, typename U, size_t B>
+bool operator!=(ResourceAllocator<T, A> const& a, ResourceAllocator<U, B> const& b) noexcept
+{
+    return !(a == b);
+}
+
+/*!
+ * \brief ResourceDeleter destroys an object made by allocateUnique()
+ *
+ * A deleter without a resource falls back to delete, so a ResourcePtr can also own an object
+ * made with new (i.e. converted from a std::unique_ptr).
+ */
+template <typename T>
+struct ResourceDeleter
+{
+    MemoryResource* m_resource;   //!< The resource the object came from or nullptr for new
+    void*           m_block;      //!< The address that was allocated
+    size_t          m_size;       //!< The size that was allocated
+    size_t          m_alignment;  //!< The alignment that was allocated
+
+    ResourceDeleter() noexcept : m_resource(nullptr), m_block(nullptr), m_size(0), m_alignment(0)
+    {
+    }
+
+    template <typename U>
+    ResourceDeleter(std::default_delete<U> const&) noexcept : ResourceDeleter()
+    {
+    }
+
+    template <typename U>
+    ResourceDeleter(ResourceDeleter<U> const& o) noexcept
+        : m_resource(o.m_resource), m_block(o.m_block), m_size(o.m_size), m_alignment(o.m_alignment)
+    {
+    }
+
+    void operator()(T* p) const
+    {
+        if (!m_resource)
+        {
+            delete p;
+            return;
+        }
+
+        p->~T();
+        m_resource->deallocate(m_block, m_size, m_alignment);
+    }
+};  // Struct: ResourceDeleter
+
+template <typename T>
+using ResourcePtr = std::unique_ptr<T, ResourceDeleter<T>>;
+
+/*!
+ * \brief allocateUnique constructs an object in memory from a resource
+ * \param resource the resource to allocate from
+ * \param args passed to the constructor of T
+ * \return the owning pointer
+ */
+template <typename T, typename... Args>
+ResourcePtr<T> allocateUnique(MemoryResource* resource, Args&&... args)
+{
+    ResourceDeleter<T> deleter;
+    deleter.m_resource  = resource;
+    deleter.m_size      = sizeof(T);
+    deleter.m_alignment = alignof(T);
+    deleter.m_block     = resource->allocate(sizeof(T), alignof(T));
+
+    T* p = new (deleter.m_block) T(std::forward<Args>(args)...);
+
+    return ResourcePtr<T>(p, deleter);
+}
+
+/*!
+ * \brief MemoryStats are the counters kept by a StatsResource
+ */
+struct MemoryStats
+{
+    size_t bytes_in_use;   //!< Bytes allocated and not deallocated yet
+    size_t peak_bytes;     //!< The highest bytes_in_use seen
+    size_t total_bytes;    //!< Bytes allocated over the lifetime of the resource
+    size_t allocations;    //!< Number of calls to allocate()
+    size_t deallocations;  //!< Number of calls to deallocate()
+};  // Struct: MemoryStats
+
+/*!
+ * \brief StatsResource counts what goes through another resource
+ *
+ * Pass one to a StateMachine to see how many bytes roost uses.  The counters are not atomic, so a
+ * StatsResource must not be shared across threads (just like the StateMachine using it).
+ */
+class StatsResource final : public MemoryResource
+{
+public:
+    explicit StatsResource(MemoryResource* upstream = defaultResource()) noexcept
+        : m_upstream(upstream), m_stats()
+    {
+    }
+
+    MemoryStats const& stats() const noexcept
+    {
+        return m_stats;
+    }
+
+protected:
+    void* doAllocate(size_t bytes, size_t alignment) override
+    {
+        void* p = m_upstream->allocate(bytes, alignment);
+
+        m_stats.bytes_in_use += bytes;
+        m_stats.total_bytes += bytes;
+        m_stats.peak_bytes = m_stats.bytes_in_use > m_stats.peak_bytes ? m_stats.bytes_in_use
+                                                                       : m_stats.peak_bytes;
+        ++m_stats.allocations;
+
+        return p;
+    }
+
+    void doDeallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        m_upstream->deallocate(p, bytes, alignment);
+
+        m_stats.bytes_in_use -= bytes;
+        ++m_stats.deallocations;
+    }
+
+private:
+    MemoryResource* m_upstream;  //!< Where the memory actually comes from
+    MemoryStats     m_stats;     //!< The counters
+};  // Class: StatsResource
+
+}  // ns: roost
+
+#endif  // ROOST_LIB_MEMORY_RESOURCE_HPP
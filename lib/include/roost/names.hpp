@@ -0,0 +1,125 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROOST_LIB_NAMES_HPP
+#define ROOST_LIB_NAMES_HPP
+
+#include "roost/alias.hpp"
+
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+/*
+ * Building with ROOST_STRIP_NAMES replaces the names of nodes, actions and guards with 32 bit ids,
+ * see nameId().  The names given to ROOST_ACTION() and ROOST_GUARD() are then hashed at compile
+ * time and never make it into the binary.  Ids are turned back into names through the symbol
+ * table (see loadSymbolFile()), otherwise they are output as '#' followed by the id in hex.
+ */
+#ifdef ROOST_STRIP_NAMES
+#define ROOST_NAME(s) (std::integral_constant<roost::u32, roost::nameId(s)>::value)
+#define ROOST_NAME_STRING(s) roost::symbolName(ROOST_NAME(s))
+#else
+#define ROOST_NAME(s) (s)
+#define ROOST_NAME_STRING(s) (s)
+#endif
+
+namespace roost
+{
+
+//! The FNV-1a hash of a name, which is its id when building with ROOST_STRIP_NAMES
+constexpr u32 nameId(const char* name, u32 hash = 2166136261u)
+{
+    return *name ? nameId(name + 1, (hash ^ static_cast<u8>(*name)) * 16777619u) : hash;
+}
+
+#ifdef ROOST_STRIP_NAMES
+using Name = u32;
+#else
+using Name = const char*;
+#endif
+
+constexpr Name NO_NAME = Name();  //!< The name of an unnamed guard
+
+/*!
+ * \brief symbolName returns the name of an id from the symbol table
+ *
+ * Ids not found in the table are given a name of '#' followed by the id in hex.  The returned
+ * string is valid until the end of the program.
+ */
+const char* symbolName(u32 id);
+
+/*!
+ * \brief addSymbol adds a name to the symbol table under nameId(name)
+ *
+ * A name already in the table keeps its first entry, collisions are not detected.
+ */
+void addSymbol(const char* name);
+
+/*!
+ * \brief loadSymbolFile adds every name of a symbol file to the symbol table
+ *
+ * A symbol file has a line per name: the id in hex, a space and the name.  See
+ * StateMachine::getSymbolFile() to write one.
+ *
+ * \return false if the file couldn't be read, otherwise true
+ */
+bool loadSymbolFile(std::string const& path);
+
+//! Returns the Name of a string, its id when building with ROOST_STRIP_NAMES
+inline Name makeName(const char* name)
+{
+#ifdef ROOST_STRIP_NAMES
+    return name ? nameId(name) : NO_NAME;
+#else
+    return name;
+#endif
+}
+
+//! Returns the string of a Name, resolved through the symbol table if names are stripped
+inline const char* nameString(Name name)
+{
+#ifdef ROOST_STRIP_NAMES
+    return name == NO_NAME ? nullptr : symbolName(name);
+#else
+    return name;
+#endif
+}
+
+//! Returns the id of a Name, see nameId()
+inline u32 nameIdOf(Name name)
+{
+#ifdef ROOST_STRIP_NAMES
+    return name;
+#else
+    return nameId(name);
+#endif
+}
+
+//! Writes the line of a name to a symbol file
+void writeSymbol(std::ostream& os, u32 id, const char* name);
+
+//! Writes the line of a name to a symbol file, nothing for NO_NAME
+inline void writeSymbol(std::ostream& os, Name name)
+{
+    if (name != NO_NAME)
+    {
+        writeSymbol(os, nameIdOf(name), nameString(name));
+    }
+}
+
+}  // ns: roost
+
+#endif  // ROOST_LIB_NAMES_HPP
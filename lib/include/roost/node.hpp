@@ -17,6 +17,9 @@
 
 #include "roost/alias.hpp"
 #include "roost/common.hpp"
+#include "roost/core.hpp"
+#include "roost/fixed_storage.hpp"
+#include "roost/names.hpp"
 #include "roost/spy.hpp"
 #include "roost/transition_table.hpp"
 
@@ -50,11 +53,76 @@ class OrthogonalNode;
 template <typename CTX, typename E, typename>
 class RegionNode;
 
-template <typename CTX, typename E, typename>
-class ShallowHistoryNode;
+/*!
+ * \brief HistoryTarget is the shallow or deep history of a CompositeNode
+ *
+ * A history target isn't a node: it is not part of the tree and only exists as the destination of
+ * rows (see Node::addRow()).  Such a row enters the composite node and then its last active child
+ * (shallow history) or its last active children all the way down (deep history).
+ */
+template <typename CTX, typename E>
+class HistoryTarget final
+{
+public:
+    const char* getName() const
+    {
+        return core::historyName(m_history);
+    }
 
-template <typename CTX, typename E, typename>
-class DeepHistoryNode;
+    NodeType getType() const
+    {
+        return m_history == core::History::SHALLOW ? NodeType::SHALLOW_HISTORY_NODE
+                                                   : NodeType::DEEP_HISTORY_NODE;
+    }
+
+    //! Returns the composite node this history belongs to
+    Node<CTX, E, void*>* getParent() const
+    {
+        return m_parent;
+    }
+
+    core::History getHistory() const
+    {
+        return m_history;
+    }
+
+private:
+    friend class CompositeNode<CTX, E, void*>;
+
+    // Only composite states have history
+    HistoryTarget(Node<CTX, E, void*>* parent, core::History history)
+        : m_parent(parent), m_history(history)
+    {
+    }
+
+    Node<CTX, E, void*>* m_parent;   //!< The composite node
+    core::History        m_history;  //!< Shallow or deep
+};  // Class: HistoryTarget
+
+/*!
+ * \brief Destination is the destination of a row: a node, the history of a composite node or
+ * nothing at all (ROOST_NO_DEST) for an internal transition
+ */
+template <typename CTX, typename E>
+struct Destination
+{
+    Destination(std::nullptr_t) : node(nullptr), history(core::History::NONE)
+    {
+    }
+
+    Destination(Node<CTX, E, void*>* destination_node)
+        : node(destination_node), history(core::History::NONE)
+    {
+    }
+
+    Destination(HistoryTarget<CTX, E>* target)
+        : node(target->getParent()), history(target->getHistory())
+    {
+    }
+
+    Node<CTX, E, void*>* node;     //!< The destination node, the composite node for a history
+    core::History        history;  //!< The history of node to enter
+};  // Struct: Destination
 
 /*!
  * \brief NodeConfiguration contains the config values supplied when configuring nodes
@@ -62,8 +130,11 @@ class DeepHistoryNode;
 template <typename CTX, typename E>
 struct NodeConfiguration
 {
-    std::shared_ptr<Spy<CTX, E>> spy;
-    StateMachine<CTX, E>*        current_state_machine;
+    std::shared_ptr<Spy<CTX, E>>    spy;
+    StateMachine<CTX, E>*           current_state_machine;
+    const core::Topology*           topology;
+    bool                            lazy;  //!< True to create the transition table on first entry
+    TransitionTableBuilder<CTX, E>* table_builder;  //!< Where the rows go, nullptr if lazy
 
 };  // Struct: NodeConfiguration
 
@@ -94,9 +165,14 @@ template <
 class Node
 {
 public:
-    using CTX_TYPE           = CTX;
-    using EVENT_TYPE         = E;
-    using TransitionTableMap = std::map<E, std::vector<TransitionTableEntry<CTX, E>>>;
+    using CTX_TYPE   = CTX;
+    using EVENT_TYPE = E;
+
+#ifdef ROOST_NO_HEAP
+    using ChildList = FixedVector<Node<CTX, E>*, ROOST_NO_HEAP_MAX_CHILDREN>;
+#else
+    using ChildList = std::vector<Node<CTX, E>*>;
+#endif
 
 private:
     friend class StateMachine<CTX, E>;
@@ -104,14 +180,12 @@ private:
     friend class CompositeNode<CTX, E, void*>;
     friend class OrthogonalNode<CTX, E, void*>;
     friend class RegionNode<CTX, E, void*>;
-    friend class ShallowHistoryNode<CTX, E, void*>;
-    friend class DeepHistoryNode<CTX, E, void*>;
 
-    TransitionTableMap         m_transition_table;   //!< The map of events to transitions
-    Node<CTX, E>*              m_parent;             //!< Parent pointer
-    Node<CTX, E>*              m_initial_child;      //!< Initial child, may be nullptr
-    Node<CTX, E>*              m_last_active_child;  //!< The last active child for history
-    std::vector<Node<CTX, E>*> m_children;           //!< Children
+    TransitionTableBuilder<CTX, E>* m_table_builder;  //!< Where addRow() puts rows, if creating
+    Node<CTX, E>*                   m_parent;         //!< Parent pointer
+    Node<CTX, E>*                   m_initial_child;  //!< Initial child, may be nullptr
+    ChildList                       m_children;       //!< Children
+    core::NodeId                    m_id;             //!< Index of the node in its StateMachine
 
     E m_none_event;  //!< The None or completion event (must be E::ROOST_NONE)
 
@@ -120,24 +194,26 @@ private:
     StateMachine<CTX, E>* m_current_state_machine;  //!< Pointer to current statemachine handler
 
 protected:
-    std::shared_ptr<Spy<CTX, E>> m_spy;   //!< Pointer to spy
-    const char*                  m_name;  //!< Name of node
+    std::shared_ptr<Spy<CTX, E>> m_spy;      //!< Pointer to spy
+    bool                         m_tracing;  //!< True if m_spy wants actions and guards
+    Name                         m_name;     //!< Name of node
 
     CTX& m_ctx;  //!< Reference to context
 
 public:
     Node(const char* name, CTX& ctx, NodeType node_type)
-        : m_transition_table(),
+        : m_table_builder(nullptr),
           m_parent(nullptr),
           m_initial_child(nullptr),
-          m_last_active_child(nullptr),
           m_children(),
+          m_id(core::INVALID_NODE),
           m_none_event(E::ROOST_NONE),
           m_node_type(node_type),
           m_valid_transition_table(false),
           m_current_state_machine(nullptr),
           m_spy(nullptr),
-          m_name(name),
+          m_tracing(false),
+          m_name(makeName(name)),
           m_ctx(ctx)
     {
     }
@@ -149,30 +225,31 @@ public:
     Node& operator=(const Node&) = delete;
 
     Node(Node&& o) noexcept
-        : m_transition_table(std::move(o.m_transition_table)),
+        : m_table_builder(nullptr),
           m_parent(o.m_parent),
           m_initial_child(o.m_initial_child),
-          m_last_active_child(o.m_last_active_child),
           m_children(std::move(o.m_children)),
+          m_id(o.m_id),
           m_none_event(o.m_none_event),
           m_node_type(o.m_node_type),
           m_valid_transition_table(o.m_valid_transition_table),
           m_current_state_machine(o.m_current_state_machine),
           m_spy(std::move(o.m_spy)),
+          m_tracing(o.m_tracing),
           m_name(o.m_name),
           m_ctx(o.m_ctx)
     {
-        o.m_transition_table.clear();
-        o.m_parent            = nullptr;
-        o.m_initial_child     = nullptr;
-        o.m_last_active_child = nullptr;
+        o.m_parent        = nullptr;
+        o.m_initial_child = nullptr;
         o.m_children.clear();
+        o.m_id = core::INVALID_NODE;
         //        o.m_none_event // Do nothing
         //        o.m_node_type  // Do nothing
         o.m_valid_transition_table = false;
         o.m_current_state_machine  = nullptr;
         o.m_spy                    = nullptr;
-        o.m_name                   = "";
+        o.m_tracing                = false;
+        o.m_name                   = makeName("");
         //        o.m_ctx // Do Nothing
     }
 
@@ -180,30 +257,31 @@ public:
     {
         if (this != &o)
         {
-            m_transition_table       = std::move(o.m_transition_table);
+            m_table_builder          = nullptr;
             m_parent                 = o.m_parent;
             m_initial_child          = o.m_initial_child;
-            m_last_active_child      = o.m_last_active_child;
             m_children               = std::move(o.m_children);
+            m_id                     = o.m_id;
             m_none_event             = o.m_none_event;
             m_node_type              = o.m_node_type;
             m_valid_transition_table = o.m_valid_transition_table;
             m_current_state_machine  = o.m_current_state_machine;
             m_spy                    = std::move(o.m_spy);
+            m_tracing                = o.m_tracing;
             m_name                   = o.m_name;
             m_ctx                    = o.m_ctx;
 
-            o.m_transition_table.clear();
-            o.m_parent            = nullptr;
-            o.m_initial_child     = nullptr;
-            o.m_last_active_child = nullptr;
+            o.m_parent        = nullptr;
+            o.m_initial_child = nullptr;
             o.m_children.clear();
+            o.m_id = core::INVALID_NODE;
             //        o.m_none_event // Do nothing
             //        o.m_node_type  // Do nothing
             o.m_valid_transition_table = false;
             o.m_current_state_machine  = nullptr;
             o.m_spy                    = nullptr;
-            o.m_name                   = "";
+            o.m_tracing                = false;
+            o.m_name                   = makeName("");
             //        o.m_ctx // Do Nothing
         }
 
@@ -212,7 +290,7 @@ public:
 
     const char* getName() const
     {
-        return m_name;
+        return nameString(m_name);
     }
 
     E getNoneEvt() const
@@ -250,39 +328,7 @@ public:
      */
     static Node<CTX, E>* findLca(Node<CTX, E>* src, Node<CTX, E>* dst)
     {
-
-        if (src == nullptr || dst == nullptr)
-        {
-            return nullptr;
-        }
-
-        if (src == dst)
-        {
-            // This is a special case, we want to set the LCA
-            // to the parent to make sure our generic algorithm works
-            return src->getParent();
-        }
-
-        Node<CTX, E>* original_src = src;
-
-        while (dst != nullptr)
-        {
-            while (src != nullptr)
-            {
-                if (src == dst)
-                {
-                    return src;
-                }
-
-                src = src->getParent();
-            }
-
-            dst = dst->getParent();
-            src = original_src;
-        }
-
-        // Shouldn't happen
-        return nullptr;
+        return static_cast<Node<CTX, E>*>(core::findLca(treeAccess(), src, dst));
     }
 
 protected:
@@ -307,7 +353,7 @@ protected:
             if (m_spy)
             {
                 m_spy->error(
-                        m_name,
+                        getName(),
                         m_ctx,
                         "Can't call postFifo without calling init() on a state machine");
             }
@@ -345,6 +391,9 @@ protected:
      *
      * You can not have the destination node be of type REGION (aka an orthogonal region).
      *
+     * The destination can also be the shallowHistory or deepHistory of a composite node, which
+     * enters the composite node and then its last active child (or children for deep history).
+     *
      * Example:
      *
      * addRow(Evt::A, ROOST_NO_DEST, ..., ...)
@@ -380,6 +429,11 @@ protected:
      * addRow(Evt::B, ..., ..., ROOST_GUARD(boolA == true)); // Can use boolean logic
      * addRow(Evt::C, ..., ..., ROOST_GUARD(func())); // Can use functions too
      *
+     * A guard that only tests flags can be a flag guard instead, which tests the word given to
+     * StateMachine::setGuardFlags() without calling anything (see ROOST_FLAG_GUARD()):
+     *
+     * addRow(Evt::D, ..., ..., ROOST_FLAG_GUARD(LINK_UP | ARMED, LINK_UP)); // Up and not armed
+     *
      * # ACTIONS
      *
      * Actions are functions which take in the event type as their only parameter
@@ -435,24 +489,80 @@ protected:
      *
      *
      * \param e the event to handle
-     * \param destination the destination node
+     * \param destination the destination node or history
      * \param actions the list of actions
      * \param guard the guard to evaluate
      */
     void addRow(
             E const&                           e,
-            Node<CTX, E>*                      destination,
+            Destination<CTX, E>                destination,
             std::vector<ActionFunctor<CTX, E>> actions,
             GuardFunctor<CTX, E>               guard)
     {
+        priv_addRow(
+                e,
+                destination,
+                std::make_move_iterator(actions.begin()),
+                std::make_move_iterator(actions.end()),
+                std::move(guard));
+    }
 
-        if (destination && destination->m_node_type == NodeType::REGION)
+    /*!
+     * \brief addRow adds a row to the transition table without a temporary std::vector
+     *
+     * This is the overload picked for braced lists (i.e. ROOST_NO_ACTION or
+     * { ROOST_ACTION(act) }), the actions are copied straight into the transition table.  See the
+     * other addRow() for the details.
+     */
+    void addRow(
+            E const&                                     e,
+            Destination<CTX, E>                          destination,
+            std::initializer_list<ActionFunctor<CTX, E>> actions,
+            GuardFunctor<CTX, E>                         guard)
+    {
+        priv_addRow(e, destination, actions.begin(), actions.end(), std::move(guard));
+    }
+
+private:
+    //! Outputs the rows of the node as SCXML transitions, if initialized
+    void priv_outputTransitionsSCXML(std::ostream& os) const
+    {
+        StateMachine<CTX, E>* sm = m_current_state_machine;
+
+        if (sm)
+        {
+            sm->m_tables[m_id].outputSCXML(os, sm->m_all_nodes.data());
+        }
+    }
+
+    template <typename It>
+    void priv_addRow(
+            E const&             e,
+            Destination<CTX, E>  target,
+            It                   first_action,
+            It                   last_action,
+            GuardFunctor<CTX, E> guard)
+    {
+        Node<CTX, E>* destination = target.node;
+
+        if (!m_table_builder)
         {
 
             if (m_spy)
+            {
+                m_spy->error(getName(), m_ctx, "Rows can only be added by createTransitionTable()");
+            }
+
+            return;
+        }
+
+        if (destination && destination->m_node_type == NodeType::REGION)
+        {
+
+            if (m_spy && !m_table_builder->silent)
             {
                 m_spy->error(
-                        m_name,
+                        getName(),
                         m_ctx,
                         "Destination can not be of type region",
                         destination->getName());
@@ -462,22 +572,43 @@ protected:
             return;
         }
 
-        TransitionTableEntry<CTX, E> entry = priv_createTransitionEntry(
-                this, destination, std::move(actions), std::move(guard));
+        if (destination && !m_current_state_machine->priv_isMember(destination))
+        {
+
+            if (m_spy && !m_table_builder->silent)
+            {
+                m_spy->error(
+                        getName(),
+                        m_ctx,
+                        "Destination is not part of the state machine",
+                        destination->getName());
+            }
+
+            m_valid_transition_table = m_valid_transition_table && false;
+            return;
+        }
 
         // If destination is nullptr then it is an internal transition and
         // lca will also be a nullptr
+        core::Route route =
+                m_current_state_machine->priv_makeRoute(this, destination, target.history);
 
-        if (m_transition_table.count(e) == 0)
+        if (!m_table_builder->addRow(e, route, first_action, last_action, std::move(guard)))
         {
-            // New Entry
-            m_transition_table.insert({e, std::vector<TransitionTableEntry<CTX, E>>()});
+
+            if (m_spy && !m_table_builder->silent)
+            {
+                m_spy->error(getName(), m_ctx, "Too many rows in the transition table");
+            }
+
+            m_valid_transition_table = m_valid_transition_table && false;
+            return;
         }
 
-        m_transition_table.at(e).push_back(std::move(entry));
         m_valid_transition_table = m_valid_transition_table && true;
     }
 
+protected:
     /*!
      * \brief createTransitionTable create a transition table for the node
      *
@@ -527,18 +658,12 @@ private:
 
         for (Node<CTX, E>* child : this->m_children)
         {
-            if (child->getType() == NodeType::SHALLOW_HISTORY_NODE ||
-                child->getType() == NodeType::DEEP_HISTORY_NODE)
-            {
-                continue;
-            }
-
             if (child->getType() == NodeType::REGION)
             {
                 os << child->getName() << " [shape=rectangle];" << std::endl;
             }
 
-            os << this->m_name << " -> " << child->getName() << ";" << std::endl;
+            os << this->getName() << " -> " << child->getName() << ";" << std::endl;
 
             if (m_initial_child)
             {
@@ -552,7 +677,7 @@ private:
     virtual void getSCXML(std::ostream& os, bool output_transitions)
     {
 
-        os << "<state id=\"" << this->m_name << "\">" << std::endl;
+        os << "<state id=\"" << this->getName() << "\">" << std::endl;
 
         if (m_initial_child)
         {
@@ -568,21 +693,13 @@ private:
         if (output_transitions)
         {
 
-            auto it = this->m_transition_table.begin();
-
-            while (it != this->m_transition_table.end())
-            {
-
-                E                                          event   = it->first;
-                std::vector<TransitionTableEntry<CTX, E>>& entries = it->second;
-
-                for (TransitionTableEntry<CTX, E>& entry : entries)
-                {
-                    entry.outputSCXML(event, os);
-                }
+            this->priv_outputTransitionsSCXML(os);
+        }
 
-                ++it;
-            }
+        if (output_transitions)
+        {
+            // If we aren't outputing transitions, why clutter up the diagram with history?
+            getHistorySCXML(os);
         }
 
         for (Node<CTX, E>* child : this->m_children)
@@ -593,77 +710,73 @@ private:
         os << "</state>" << std::endl;
     }
 
-    static TransitionTableEntry<CTX, E> priv_createTransitionEntry(
-            Node<CTX, E>*                      src,
-            Node<CTX, E>*                      dst,
-            std::vector<ActionFunctor<CTX, E>> actions,
-            GuardFunctor<CTX, E>               guard)
+    virtual void getHistorySCXML(std::ostream&)
     {
+    }
 
-        TransitionTableEntry<CTX, E> entry;
-        entry.m_src         = std::move(src);
-        entry.m_destination = std::move(dst);
-        entry.m_actions     = std::move(actions);
-        entry.m_guard       = std::move(guard);
-        entry.m_lca         = findLca(entry.m_src, entry.m_destination);
-
-        if (entry.m_lca)
-        {
-
-            if (entry.m_lca->m_node_type == NodeType::ORTHOGONAL_NODE)
-            {
-                // A transition that has an LCA of an orthogonal node will be transformed so that
-                // the orthogonal regions are exited and then default entered
-
-                entry.m_src         = entry.m_lca;
-                entry.m_destination = entry.m_lca;
-
-                // Force the LCA to be parent of "real" LCA so that our algorithm will call
-                // On exit and then on entry of "real" LCA
-
-                entry.m_lca = entry.m_lca->m_parent;
-            }
+    /*!
+     * \brief treeAccess returns the accessors that let the core walk a tree of Node<CTX, E>
+     */
+    static core::TreeAccess const& treeAccess()
+    {
+        static const core::TreeAccess access = {
+                [](void* node) { return static_cast<Node<CTX, E>*>(node)->m_children.size(); },
+                [](void* node, size_t idx) -> void* {
+                    return static_cast<Node<CTX, E>*>(node)->m_children[idx];
+                },
+                [](void* node) -> void* { return static_cast<Node<CTX, E>*>(node)->m_parent; },
+                [](void* node) -> void* {
+                    return static_cast<Node<CTX, E>*>(node)->m_initial_child;
+                },
+                [](void* node) { return static_cast<Node<CTX, E>*>(node)->m_node_type; },
+                [](void* node) { return static_cast<Node<CTX, E>*>(node)->m_id; },
+                [](void* node, core::NodeId id) { static_cast<Node<CTX, E>*>(node)->m_id = id; }};
+
+        return access;
+    }
 
-            Node<CTX, E>* lca = entry.m_lca;
+    virtual bool init(NodeConfiguration<CTX, E> const& config)
+    {
+        m_valid_transition_table = true;
+        m_spy                    = config.spy;
+        m_tracing                = m_spy && m_spy->traces();
+        m_current_state_machine  = config.current_state_machine;
 
-            while (lca->m_node_type != NodeType::REGION)
+        if (priv_childrenOverflowed())
+        {
+            if (m_spy)
             {
-                lca = lca->m_parent;
+                m_spy->error(
+                        getName(), m_ctx, "Too many children, increase ROOST_NO_HEAP_MAX_CHILDREN");
             }
 
-            entry.m_lca_region = static_cast<RegionNode<CTX, E, void*>*>(lca);
-        }
-        else
-        {
-            entry.m_lca_region = nullptr;
+            return false;
         }
 
-        // Important we do this after the orthogonal node lca check above
-        // because we could change the m_src field in the entry
-        Node<CTX, E>* tmp_src = entry.m_src;
-
-        while (tmp_src->m_node_type != NodeType::REGION)
+        if (config.lazy)
         {
-            tmp_src = tmp_src->m_parent;
+            // The StateMachine will call priv_createTransitionTable() when the node is entered
+            return true;
         }
 
-        entry.m_src_region = static_cast<RegionNode<CTX, E, void*>*>(tmp_src);
-
-        return entry;
+        return priv_createTransitionTable(*config.table_builder);
     }
 
-    virtual void setLastVisitedNode(Node<CTX, E>* node)
+    bool priv_childrenOverflowed() const
     {
-        m_last_active_child = node;
+#ifdef ROOST_NO_HEAP
+        return m_children.overflowed();
+#else
+        return false;
+#endif
     }
 
-    virtual bool init(NodeConfiguration<CTX, E> const& config)
+    bool priv_createTransitionTable(TransitionTableBuilder<CTX, E>& builder)
     {
         m_valid_transition_table = true;
-        m_spy                    = config.spy;
-        m_current_state_machine  = config.current_state_machine;
-        m_transition_table.clear();
+        m_table_builder          = &builder;
         createTransitionTable();
+        m_table_builder = nullptr;
 
         // We use a "global" flag instead of returning from createTransitionTable()
         // because we want the addRow syntax to be cleaner
@@ -679,139 +792,14 @@ private:
     virtual void uninit()
     {
         m_valid_transition_table = false;
-        m_transition_table.clear();
+
         m_current_state_machine = nullptr;
         m_spy                   = nullptr;
-    }
-
-    // Returns false if not handled, otherwise true
-    virtual bool handle(
-            E const&                                   event,
-            std::vector<TransitionTableEntry<CTX, E>>* transition_list)
-    {
-        if (m_transition_table.count(event) == 0)
-        {
-            // Not found
-            return false;
-        }
-
-        std::vector<TransitionTableEntry<CTX, E>>& entries = m_transition_table.at(event);
-
-        for (auto& entry : entries)
-        {
-
-            if (entry.m_guard.m_guard_fptr(event))
-            {
-                // Guard returned true
-                transition_list->push_back(entry);
-
-                return true;
-            }
-        }
-
-        // No entries that had a good guard
-        return false;
+        m_tracing               = false;
     }
 
 };  // Class: Node
 
-template <
-        typename CTX,
-        typename E,
-        typename = typename std::enable_if<std::is_enum<E>::value, void*>::type>
-class ShallowHistoryNode final : public Node<CTX, E>
-{
-private:
-    friend class CompositeNode<CTX, E, void*>;
-
-    // We want this private because only composite states can have this kind of node
-    // Additionally all history nodes can not have children
-    ShallowHistoryNode(const char* name, CTX& ctx, Node<CTX, E>* parent)
-        : Node<CTX, E>(name, ctx, NodeType::SHALLOW_HISTORY_NODE)
-    {
-        this->m_parent = parent;
-
-        if (this->m_parent)
-        {
-            this->m_parent->m_children.push_back(this);
-        }
-    }
-
-    void createTransitionTable() override final
-    {
-    }
-
-    void setLastVisitedNode(Node<CTX, E>*) override final
-    {
-        // We don't want to set any node, leave m_last_active_child as nullptr
-    }
-
-    void getSCXML(std::ostream& os, bool output_transitions) override
-    {
-
-        if (!output_transitions)
-        {
-            // If we aren't outputing transitions, why clutter up the diagram with history nodes?
-            return;
-        }
-
-        os << "<history id=\"" << this->m_parent->m_name << "." << this->m_name
-           << "\" type=\"shallow\"/>" << std::endl;
-    }
-
-    void getGraphViz(std::ostream&) override
-    {
-    }
-};
-
-template <
-        typename CTX,
-        typename E,
-        typename = typename std::enable_if<std::is_enum<E>::value, void*>::type>
-class DeepHistoryNode final : public Node<CTX, E>
-{
-private:
-    friend class CompositeNode<CTX, E, void*>;
-
-    // We want this private because only composite states can have this kind of node
-    // Additionally all history nodes can not have children
-    DeepHistoryNode(const char* name, CTX& ctx, Node<CTX, E>* parent)
-        : Node<CTX, E>(name, ctx, NodeType::DEEP_HISTORY_NODE)
-    {
-        this->m_parent = parent;
-
-        if (this->m_parent)
-        {
-            this->m_parent->m_children.push_back(this);
-        }
-    }
-
-    void createTransitionTable() override final
-    {
-    }
-
-    void setLastVisitedNode(Node<CTX, E>*) override final
-    {
-        // We don't want to set any node, leave m_last_active_child as nullptr
-    }
-
-    void getSCXML(std::ostream& os, bool output_transitions) override
-    {
-        if (!output_transitions)
-        {
-            // If we aren't outputing transitions, why clutter up the diagram with history nodes?
-            return;
-        }
-
-        os << "<history id=\"" << this->m_parent->m_name << "." << this->m_name
-           << "\" type=\"deep\"/>" << std::endl;
-    }
-
-    void getGraphViz(std::ostream&) override
-    {
-    }
-};
-
 template <
         typename CTX,
         typename E,
@@ -832,12 +820,6 @@ public:
 
     virtual ~LeafNode() = default;
 
-private:
-    void setLastVisitedNode(Node<CTX, E>*) override
-    {
-        // We don't want to set any node, leave m_last_active_child as nullptr
-    }
-
 };  // Class: LeafNode
 
 template <
@@ -849,12 +831,11 @@ class CompositeNode : public Node<CTX, E>
 public:
     CompositeNode(const char* name, CTX& ctx, Node<CTX, E>* parent, Node<CTX, E>* initial_state)
         : Node<CTX, E>(name, ctx, NodeType::COMPOSITE_NODE),
-          shallowHistory("ShallowHistory", ctx, this),
-          deepHistory("DeepHistory", ctx, this)
+          shallowHistory(this, core::History::SHALLOW),
+          deepHistory(this, core::History::DEEP)
     {
-        this->m_parent            = parent;
-        this->m_initial_child     = initial_state;
-        this->m_last_active_child = initial_state;
+        this->m_parent        = parent;
+        this->m_initial_child = initial_state;
 
         if (this->m_parent)
         {
@@ -864,10 +845,18 @@ public:
 
     virtual ~CompositeNode() = default;
 
-    ShallowHistoryNode<CTX, E> shallowHistory;
-    DeepHistoryNode<CTX, E>    deepHistory;
+    HistoryTarget<CTX, E> shallowHistory;  //!< Destination to enter the last active child
+    HistoryTarget<CTX, E> deepHistory;     //!< Destination to enter the last active children
 
 private:
+    void getHistorySCXML(std::ostream& os) override
+    {
+        os << "<history id=\"" << this->getName() << "." << shallowHistory.getName()
+           << "\" type=\"shallow\"/>" << std::endl;
+        os << "<history id=\"" << this->getName() << "." << deepHistory.getName()
+           << "\" type=\"deep\"/>" << std::endl;
+    }
+
     bool init(NodeConfiguration<CTX, E> const& config) override
     {
 
@@ -882,29 +871,13 @@ private:
             if (this->m_spy)
             {
                 this->m_spy->error(
-                        this->m_name,
+                        this->getName(),
                         this->m_ctx,
                         "Initial child must direct sub-state of parent");
             }
             return false;
         }
 
-        if (this->m_initial_child->m_node_type == NodeType::SHALLOW_HISTORY_NODE ||
-            this->m_initial_child->m_node_type == NodeType::DEEP_HISTORY_NODE)
-        {
-
-            if (this->m_spy)
-            {
-                this->m_spy->error(
-                        this->m_name,
-                        this->m_ctx,
-                        "Can not have children nodes which are history nodes",
-                        this->m_initial_child->getName());
-            }
-
-            return false;
-        }
-
         for (Node<CTX, E>* child : this->m_children)
         {
             if (child->m_node_type == NodeType::REGION)
@@ -913,7 +886,7 @@ private:
                 if (this->m_spy)
                 {
                     this->m_spy->error(
-                            this->m_name,
+                            this->getName(),
                             this->m_ctx,
                             "Can not have children nodes which are regions",
                             child->getName());
@@ -949,11 +922,6 @@ public:
     virtual ~OrthogonalNode() = default;
 
 private:
-    void setLastVisitedNode(Node<CTX, E>*) override
-    {
-        // We don't want to set any node, leave m_last_active_child as nullptr
-    }
-
     // Orthogonal nodes don't have setup() because we just want to call on-entry and let the state
     // machine handle activating default nodes vs non-default nodes
 
@@ -974,7 +942,7 @@ private:
                 if (this->m_spy)
                 {
                     this->m_spy->error(
-                            this->m_name,
+                            this->getName(),
                             this->m_ctx,
                             "All children of orthogonal nodes must be regions",
                             child->getName());
@@ -987,71 +955,15 @@ private:
         return true;
     }
 
-    bool handle(E const& event, std::vector<TransitionTableEntry<CTX, E>>* transition_list)
-            override
-    {
-        bool handled{false};
-
-        for (Node<CTX, E>* child : this->m_children)
-        {
-
-            /*
-             * It is VITAL that the order of this is maintained.  That is because
-             * we must ensure that child->handle(...) is ALWAYS called for each child.
-             *
-             * If we made it like:
-             *  handled = handled || child->handle(...)
-             *
-             * then due to C++ short-circuiting rules, if handled was true then
-             * child-> handle(...) won't be called.
-             *
-             * Another way to think of this is:
-             *
-             * if (child->handle(event, transition_list))
-             * {
-             *     handled = true;
-             * }
-             *
-             * but we can avoid branch predictor misses this way
-             *
-             */
-
-            handled = child->handle(event, transition_list) || handled;
-        }
-
-        // One of the regions handled it
-        if (handled)
-        {
-            return true;
-        }
-
-        // Otherwise lets see if we handle it
-        return Node<CTX, E>::handle(event, transition_list);
-    }
-
     void getSCXML(std::ostream& os, bool output_transitions) override
     {
 
-        os << "<parallel id=\"" << this->m_name << "\">" << std::endl;
+        os << "<parallel id=\"" << this->getName() << "\">" << std::endl;
 
         if (output_transitions)
         {
 
-            auto it = this->m_transition_table.begin();
-
-            while (it != this->m_transition_table.end())
-            {
-
-                E                                          event   = it->first;
-                std::vector<TransitionTableEntry<CTX, E>>& entries = it->second;
-
-                for (TransitionTableEntry<CTX, E>& entry : entries)
-                {
-                    entry.outputSCXML(event, os);
-                }
-
-                ++it;
-            }
+            this->priv_outputTransitionsSCXML(os);
         }
 
         for (Node<CTX, E>* child : this->m_children)
@@ -1071,18 +983,16 @@ template <
 class RegionNode : public Node<CTX, E>
 {
 private:
-    Node<CTX, E>* m_current_node;
-    u32           m_level;
+    u32 m_level;
 
 public:
     friend class StateMachine<CTX, E>;
 
     RegionNode(const char* name, CTX& ctx, Node<CTX, E>* parent, Node<CTX, E>* initial_state)
-        : Node<CTX, E>(name, ctx, NodeType::REGION), m_current_node(this), m_level(0)
+        : Node<CTX, E>(name, ctx, NodeType::REGION), m_level(0)
     {
-        this->m_parent            = parent;
-        this->m_initial_child     = initial_state;
-        this->m_last_active_child = initial_state;
+        this->m_parent        = parent;
+        this->m_initial_child = initial_state;
 
         if (this->m_parent)
         {
@@ -1124,35 +1034,15 @@ private:
             return false;
         }
 
-        // The Top Region is level 1
-        m_level           = 1;
-        Node<CTX, E>* tmp = this->getParent();
-
-        while (tmp != nullptr)
-        {
-            tmp = tmp->getParent();
-            ++m_level;
-
-            // This is an arbitrarily large number to act
-            // as a fail safe for infinite loops.
-            // If you truly have more than 1 million parent nodes
-            // then you are SOL unfortunately
-            if (m_level > 1000000)
-            {
-                if (this->m_spy)
-                {
-                    this->m_spy->error(this->m_name, this->m_ctx, "Can't set level");
-                }
-                return false;
-            }
-        }
+        // The level is computed by the core when the topology is built
+        m_level = config.topology->level[this->m_id];
 
         if (this->m_initial_child->getParent() != this)
         {
             if (this->m_spy)
             {
                 this->m_spy->error(
-                        this->m_name,
+                        this->getName(),
                         this->m_ctx,
                         "Initial child must direct sub-state of parent");
             }
@@ -1167,7 +1057,7 @@ private:
                 if (this->m_spy)
                 {
                     this->m_spy->error(
-                            this->m_name,
+                            this->getName(),
                             this->m_ctx,
                             "Can not have children nodes which are regions",
                             child->getName());
@@ -1180,145 +1070,6 @@ private:
         return true;
     }
 
-    void constructFromDeepHistory()
-    {
-
-        Node<CTX, E>* current_node = this->m_current_node;
-
-        while (current_node != nullptr)
-        {
-
-            // Next node may be nullptr, but we have to check if the current
-            // Node is an orthogonal node because both orthogonal and
-            // leaf nodes have m_last_active_child as nullptr
-
-            Node<CTX, E>* next_node = current_node->m_last_active_child;
-
-            if (current_node->m_node_type == NodeType::ORTHOGONAL_NODE)
-            {
-                // Orthogonal nodes have nullptr for last active childs,
-                // instead activate their children
-
-                for (Node<CTX, E>* child : current_node->m_children)
-                {
-                    // Enforced by init()
-                    RegionNode<CTX, E>* region = static_cast<RegionNode<CTX, E>*>(child);
-                    region->constructFromDeepHistory();
-                }
-
-                return;
-            }
-
-            current_node = next_node;
-
-            if (current_node)
-            {
-
-                if (this->m_spy)
-                {
-                    this->m_spy->on_entry(current_node->getName(), this->m_ctx);
-                }
-
-                current_node->onEntry();
-                this->m_current_node = current_node;
-            }
-        }
-    }
-
-    void construct()
-    {
-
-        Node<CTX, E>* current_node = m_current_node->m_initial_child;
-
-        while (current_node != nullptr)
-        {
-
-            if (this->m_spy)
-            {
-                this->m_spy->on_entry(current_node->getName(), this->m_ctx);
-            }
-
-            current_node->onEntry();
-            m_current_node = current_node;
-
-            if (current_node->m_node_type == NodeType::ORTHOGONAL_NODE)
-            {
-
-                for (Node<CTX, E>* child : current_node->m_children)
-                {
-                    // Enforced by init
-                    RegionNode<CTX, E>* region = static_cast<RegionNode<CTX, E>*>(child);
-                    region->construct();
-                }
-
-                return;
-            }
-
-            current_node = m_current_node->m_initial_child;
-        }
-    }
-
-    void destructUntilNode(Node<CTX, E>* node)
-    {
-
-        while (m_current_node != node)
-        {
-
-            if (m_current_node->m_node_type == NodeType::ORTHOGONAL_NODE)
-            {
-
-                for (Node<CTX, E>* child : m_current_node->m_children)
-                {
-                    // Enforced by init
-                    RegionNode<CTX, E>* region = static_cast<RegionNode<CTX, E>*>(child);
-                    region->destruct();
-                }
-            }
-
-            if (this->m_spy)
-            {
-                this->m_spy->on_exit(m_current_node->getName(), this->m_ctx);
-            }
-
-            m_current_node->onExit();
-
-            // Save the last active child of the region
-
-            this->setLastVisitedNode(m_current_node);
-
-            m_current_node = m_current_node->m_parent;
-
-            // Also inform the composite state of the last active child
-            m_current_node->setLastVisitedNode(this->m_last_active_child);
-        }
-    }
-
-    void destruct()
-    {
-        destructUntilNode(this);
-    }
-
-    bool handle(E const& event, std::vector<TransitionTableEntry<CTX, E>>* transition_list)
-            override
-    {
-        Node<CTX, E>* current_node = m_current_node;
-        bool          rval{false};
-
-        while (current_node != this)
-        {
-            rval = current_node->handle(event, transition_list);
-
-            if (rval)
-            {
-                return true;
-            }
-
-            current_node = current_node->m_parent;
-        }
-
-        return false;
-    }
-
 };  // Class: RegionNode
 
 }  // ns: roost
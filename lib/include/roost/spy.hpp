@@ -132,6 +132,29 @@ public:
             const char* main_error,
             const char* sub_system_error = "") = 0;
 
+    /*!
+     * \brief memoryBytes returns the bytes the spy takes up, counted by memoryReport()
+     *
+     * The default doesn't know the size of the derived class and returns 0.
+     */
+    virtual size_t memoryBytes() const
+    {
+        return 0;
+    }
+
+    /*!
+     * \brief traces returns true if on_entry(), on_exit(), action(), guard() and event() are used
+     *
+     * Those are called for every step of every event, with names that are looked up in the
+     * symbol table when building with ROOST_STRIP_NAMES.  A spy that ignores them returns false
+     * (see IErrorSpy) and the StateMachine doesn't call them, nor looks up their names.  Only
+     * read when the StateMachine is constructed or initialized, so it must not change.
+     */
+    virtual bool traces() const
+    {
+        return true;
+    }
+
 };  // Class: Spy
 
 /*!
@@ -197,6 +220,11 @@ public:
                   << "] [Sub-System Error: " << sub_system_error << "]" << std::endl;
     }
 
+    size_t memoryBytes() const override
+    {
+        return sizeof(*this);
+    }
+
 };  // Class: PrintingSpy
 
 /*!
@@ -230,6 +258,12 @@ public:
 
     // Still have to define error and no transition!
 
+    //! The above are never called, so the names aren't looked up for them
+    bool traces() const override
+    {
+        return false;
+    }
+
 };  // Class: IErrorSpy
 
 /*!
@@ -266,6 +300,12 @@ public:
                   << "[Error] [Event: " << e << "] [Main Error: " << main_error
                   << "] [Sub-System Error: " << sub_system_error << "]" << std::endl;
     }
+
+    size_t memoryBytes() const override
+    {
+        return sizeof(*this);
+    }
+
 };  // Class: StandardErrorSpy
 
 /*!
@@ -327,6 +367,11 @@ public:
                   << "] [Sub-System Error: " << sub_system_error << "]" << std::endl;
     }
 
+    size_t memoryBytes() const override
+    {
+        return sizeof(*this);
+    }
+
     std::vector<std::string>& m_events;
 
 };  // Class: TracingSpy
@@ -396,6 +441,11 @@ public:
         PrintingSpy<CTX, E>::error(node_name, ctx, e, main_error, sub_system_error);
     }
 
+    size_t memoryBytes() const override
+    {
+        return sizeof(*this);
+    }
+
     std::vector<std::string>& m_events;
 
 };  // Class: PrintingTracingSpy
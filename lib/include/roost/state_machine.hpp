@@ -18,16 +18,27 @@
 #include "roost/alias.hpp"
 #include "roost/common.hpp"
 #include "roost/constants.hpp"
+#include "roost/core.hpp"
+#include "roost/fixed_storage.hpp"
+#include "roost/memory_report.hpp"
+#include "roost/memory_resource.hpp"
+#include "roost/names.hpp"
 #include "roost/node.hpp"
 #include "roost/spy.hpp"
+#include "roost/topology_cache.hpp"
 #include "roost/transition_table.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
 #include <functional>  // std::function
 #include <iterator>
 #include <limits>
 #include <queue>
+#include <set>
 #include <string>
+#include <thread>
 
 namespace roost
 {
@@ -40,7 +51,7 @@ namespace roost
  * queue that doesn't allocate (i.e. a pre-allocated ring buffer).
  *
  * The default IFifo concrete class used by the StateMachine class is the QueueFifo class,
- * which uses a std::queue backing.
+ * which uses a std::queue backing that allocates from a MemoryResource.
  *
  * \tparam E the event enum class type
  */
@@ -75,6 +86,16 @@ public:
      * \brief pop_front removes the event enum class at the front of the queue
      */
     virtual void pop_front() = 0;
+
+    /*!
+     * \brief memoryBytes returns the bytes the queue takes up, counted by memoryReport()
+     *
+     * The default doesn't know the size of the derived class and returns 0.
+     */
+    virtual size_t memoryBytes() const
+    {
+        return 0;
+    }
 };
 
 /*!
@@ -86,9 +107,18 @@ template <typename E>
 class QueueFifo final : public IFifo<E>
 {
 private:
-    std::queue<E> m_queue;
+    StatsResource                                      m_stats;  //!< Counts what the queue holds
+    std::queue<E, std::deque<E, ResourceAllocator<E>>> m_queue;
 
 public:
+    explicit QueueFifo(MemoryResource* resource = defaultResource())
+        : m_stats(resource), m_queue(std::deque<E, ResourceAllocator<E>>(&m_stats))
+    {
+    }
+
+    QueueFifo(QueueFifo const&) = delete;
+    QueueFifo& operator=(QueueFifo const&) = delete;
+
     bool push(E const& e) override
     {
         m_queue.push(e);
@@ -109,8 +139,90 @@ public:
     {
         return m_queue.pop();
     }
+
+    size_t memoryBytes() const override
+    {
+        return sizeof(*this) + m_stats.stats().bytes_in_use;
+    }
+};
+
+/*!
+ * \brief A concrete IFifo class that holds up to N events inline and never allocates
+ *
+ * push() returns false when the queue is full.  This is the default queue of a StateMachine
+ * when building with ROOST_NO_HEAP.
+ *
+ * \tparam E the event enum class type
+ * \tparam N the capacity
+ */
+template <typename E, size_t N>
+class RingFifo final : public IFifo<E>
+{
+private:
+    E      m_events[N];  //!< The storage
+    size_t m_head;       //!< Index of the front of the queue
+    size_t m_size;       //!< Number of queued events
+
+public:
+    RingFifo() : m_events(), m_head(0), m_size(0)
+    {
+    }
+
+    bool push(E const& e) override
+    {
+        if (m_size == N)
+        {
+            return false;
+        }
+
+        m_events[(m_head + m_size) % N] = e;
+        ++m_size;
+        return true;
+    }
+
+    bool empty() override
+    {
+        return m_size == 0;
+    }
+
+    E front() override
+    {
+        return m_events[m_head];
+    }
+
+    void pop_front() override
+    {
+        m_head = (m_head + 1) % N;
+        --m_size;
+    }
+
+    size_t memoryBytes() const override
+    {
+        return sizeof(*this);
+    }
 };
 
+//! How often the dispatch cache of a StateMachine was used, see setDispatchCache()
+struct DispatchCacheStats
+{
+    u64 hits;    //!< Dispatches that skipped the walk up from the current node
+    u64 misses;  //!< Dispatches that walked, including the ones that can't be cached
+};  // Struct: DispatchCacheStats
+
+//! How often the result of a pure guard was reused, see ROOST_PURE_GUARD()
+struct PureGuardStats
+{
+    u64 hits;    //!< Pure guards answered from an earlier call in the same dispatch
+    u64 misses;  //!< Pure guards that were called
+};  // Struct: PureGuardStats
+
+//! What became of a batch of events, see StateMachine::handleEvents()
+struct BatchResult
+{
+    size_t handled;  //!< Events dispatched, or queued behind an event in progress
+    size_t dropped;  //!< Events thrown away, see handleEvent() for when that happens
+};  // Struct: BatchResult
+
 /*!
  * \brief StateMachine is responsible for publishing events and handling all user-facing functions
  *
@@ -131,25 +243,162 @@ template <typename CTX, typename E>
 class StateMachine final
 {
 private:
+    friend class Node<CTX, E, void*>;
+
     Node<CTX, E>*
                                  m_original_node;  //!< The node which StateMachine will attach Top as a parent to
-    const char*                  m_name;     //!< The name of the backend
-    CTX&                         m_ctx;      //!< The context reference shared among all nodes
-    std::shared_ptr<Spy<CTX, E>> m_spy;      //!< The spy associated with the StateMachine
-    std::vector<Node<CTX, E>*> m_all_nodes;  //!< A vector that contains all nodes (including top)
-    std::vector<Node<CTX, E>*>
-                       m_on_entry_calls;  //!< A vector that holds pointers to call onEntry in reverse order
-    bool               m_init;            //!< True if successfully initialized, otherwise false
-    RegionNode<CTX, E> m_top;             //!< The Top node to attach to m_original_node
+    const char*                  m_name;       //!< The name of the backend
+    CTX&                         m_ctx;        //!< The context reference shared among all nodes
+    std::shared_ptr<Spy<CTX, E>> m_spy;        //!< The spy associated with the StateMachine
+    bool                         m_tracing;    //!< True if m_spy wants every step, see traces()
+#ifdef ROOST_NO_HEAP
+    InlineResource<ROOST_NO_HEAP_ARENA_SIZE> m_arena;  //!< The resource if none was given
+#endif
+    MemoryResource*              m_resource;   //!< Where every container allocates from
+    core::Vector<Node<CTX, E>*>  m_all_nodes;  //!< All nodes (including top), indexed by node id
+    core::Topology               m_topology;   //!< The shape of the tree, built by init()
+    core::Runtime                m_runtime;    //!< The current nodes and history of the tree
+
+    /*!
+     * \brief DispatchNode is what walking up from a current node reads about each node
+     *
+     * Kept apart from the nodes themselves so handling an event touches small arrays instead of
+     * the user's objects.  The array starts on a cache line, so eight nodes share each line and
+     * none straddles two.  The rows are in m_tables, whose blocks start on a cache line too.
+     */
+    struct alignas(8) DispatchNode
+    {
+        core::NodeId parent;  //!< The parent of the node
+        NodeType     type;    //!< The type of the node
+    };  // Struct: DispatchNode
+
+    static_assert(sizeof(DispatchNode) == 8, "A DispatchNode must not straddle a cache line");
+    static_assert(sizeof(TransitionTableEntry<CTX, E>) == 32, "Two rows must fit a cache line");
+
+    core::CacheLineVector<DispatchNode>   m_dispatch;     //!< Indexed by node id, built by init()
+    core::Vector<TransitionTable<CTX, E>> m_tables;       //!< The rows of each node by node id
+    void*                                 m_table_block;  //!< Holds every table, unless lazy
+    size_t                                m_table_bytes;  //!< The size of m_table_block
+
+    //! The lowest level the rows of an event under a region can be selected at
+    struct RegionLevel
+    {
+        E   event;  //!< The event of the rows
+        u32 level;  //!< The lowest level, 0 if one of the rows is internal
+    };  // Struct: RegionLevel
+
+    core::Vector<u32>         m_region_offsets;  //!< Levels of region r start at offsets[r]
+    core::Vector<RegionLevel> m_region_levels;   //!< By event in a region, see priv_regionLevels()
+
+    core::Hooks                  m_hooks;      //!< Calls back into the nodes from the core
+    bool                         m_init;       //!< True if successfully initialized
+    RegionNode<CTX, E>           m_top;        //!< The Top node to attach to m_original_node
 
     //! A vector that holds all potential transitions to execute
-    std::vector<TransitionTableEntry<CTX, E>> m_transitions;
+    TransitionList<CTX, E> m_transitions;
 
     bool m_event_in_progress;  //!< True if currently handling an event in the StateMachine,
                                //!< otherwise false
     bool m_force_transition_in_progress;  //!< True if force transition in progress, otherwise
                                           //!< false
-    std::unique_ptr<IFifo<E>> m_fifo;     //!< The queue that holds the events
+    ResourcePtr<IFifo<E>> m_fifo;         //!< The queue that holds the events, if given one
+#ifdef ROOST_NO_HEAP
+    RingFifo<E, ROOST_NO_HEAP_FIFO_SIZE> m_inline_fifo;  //!< The queue if none was given
+#endif
+    IFifo<E>* m_queue;  //!< The queue in use, either m_fifo or an inline one
+
+    bool m_lazy;                //!< True if transition tables are created on first entry
+    bool m_warm_in_background;  //!< True if a thread creates the lazy tables after init()
+    MemoryResource* m_warm_given;     //!< The resource given to setLazyInit(), may be nullptr
+    MemoryResource* m_warm_resource;  //!< Where m_warm_thread allocates, see priv_warmResource()
+    core::Vector<std::atomic<u8>> m_table_state;  //!< TableState of each node (lazy only)
+    std::thread                   m_warm_thread;  //!< Creates the lazy tables in background
+    std::atomic<bool>             m_warm_stop;    //!< Tells m_warm_thread to stop early
+
+    std::string    m_topology_cache;  //!< Path of the topology cache file, empty if not used
+    core::RouteLog m_route_log;       //!< Routes replayed from or recorded to the cache
+
+    /*!
+     * \brief FlatCandidate is a row that handles an event in a flattened cell, see priv_flatten()
+     *
+     * The steps are the nodes the row exits and then enters from the node of the cell.
+     */
+    struct FlatCandidate
+    {
+        SelectedTransition<CTX, E> transition;   //!< The row and its table
+        u32                        steps;        //!< Index of the first step in m_flat_steps
+        u32                        num_exits;    //!< FLAT_DYNAMIC if the row has history
+        u32                        num_entries;  //!< Number of nodes entered after the exits
+    };  // Struct: FlatCandidate
+
+    //! The candidates of a node and event, in the order priv_dispatch() would check them
+    struct FlatCell
+    {
+        u32 first;  //!< Index of the first candidate in m_flat_candidates
+        u32 count;  //!< Number of candidates
+    };  // Struct: FlatCell
+
+    bool m_flat_dispatch;  //!< True if init() should flatten the machine
+    bool m_flat;           //!< True if the machine was flattened by init()
+    u32  m_flat_columns;   //!< Number of events with rows
+    core::Vector<u32>           m_flat_column;      //!< Column of each event value, or INVALID
+    core::Vector<u32>           m_flat_row;         //!< Row of each resting node, or INVALID
+    core::Vector<FlatCell>      m_flat_cells;       //!< Row times m_flat_columns cells
+    core::Vector<FlatCandidate> m_flat_candidates;  //!< The candidates of every cell
+    core::Vector<core::NodeId>  m_flat_steps;       //!< The exits and entries of the candidates
+
+    //! Marks a FlatCandidate whose steps depend on the history, so aren't flattened
+    static const u32 FLAT_DYNAMIC = 0xFFFFFFFF;
+
+    //! Event values above this are never flattened, as the columns are indexed by value
+    static const size_t FLAT_MAX_EVENT_VALUE = 1023;
+
+    /*!
+     * \brief DispatchCache is the last dispatch of a region, see setDispatchCache()
+     *
+     * Filled for the current node of the region and an event, so it goes stale as soon as the
+     * region moves to another node.  The handler is the first node up from there with rows for
+     * the event, INVALID_NODE if there is none.
+     */
+    struct DispatchCache
+    {
+        core::NodeId                        node;     //!< The current node when filled
+        E                                   event;    //!< The event dispatched
+        core::NodeId                        handler;  //!< The first node with rows for event
+        TransitionTableEntry<CTX, E> const* first;    //!< The rows of the handler for event
+        TransitionTableEntry<CTX, E> const* last;     //!< One past the last row
+    };  // Struct: DispatchCache
+
+    bool                        m_dispatch_caching;  //!< True if init() should create the caches
+    core::Vector<DispatchCache> m_dispatch_cache;    //!< Indexed by region id, empty if not used
+    DispatchCacheStats          m_cache_stats;       //!< Hits and misses since init()
+
+    //! The result of a pure guard in a dispatch, see ROOST_PURE_GUARD()
+    struct PureGuardResult
+    {
+        uintptr_t    key;       //!< Identifies the guard, see priv_guardKey()
+        core::NodeId owner;     //!< The node of the guard, INVALID_NODE if shared by a tag
+        u32          dispatch;  //!< The dispatch the result is from
+        bool         value;     //!< What the guard returned
+    };  // Struct: PureGuardResult
+
+    //! Number of pure guard results kept, a power of two
+    static const size_t PURE_GUARD_SLOTS = 32;
+
+    core::Vector<PureGuardResult> m_pure_results;  //!< Indexed by a hash of the key, if used
+    u32                           m_dispatches;    //!< Counts the dispatches, never 0
+    PureGuardStats                m_pure_stats;    //!< Hits and misses since init()
+
+    GuardFlags const* m_guard_flags;  //!< Tested by flag guards, nullptr reads as 0
+
+    //! Whether or not the transition table of a node was created (lazy mode only)
+    enum TableState : u8
+    {
+        TABLE_NOT_CREATED,
+        TABLE_CREATING,
+        TABLE_READY,
+        TABLE_WARMED  //!< Ready, and created by the warm thread in m_warm_resource
+    };
 
 public:
     using CTX_TYPE   = CTX;
@@ -164,32 +413,150 @@ public:
      *
      * \param name the name of the StateMachine
      * \param attached_node the node to attach Top as a parent to
-     * \param spy the spy to attach to all nodes
-     * \param fifo the event queue
+     * \param spy the spy to attach to all nodes, may be nullptr
+     * \param fifo the event queue, nullptr for the default one
+     * \param resource where every container of the StateMachine and its nodes allocates from,
+     * nullptr for the default one
      */
     StateMachine(
             const char*                  name,
             Node<CTX, E>*                attached_node,
-            std::shared_ptr<Spy<CTX, E>> spy  = roost::make_unique<StandardErrorSpy<CTX, E>>(),
-            std::unique_ptr<IFifo<E>>    fifo = roost::make_unique<QueueFifo<E>>())
+            std::shared_ptr<Spy<CTX, E>> spy      = defaultSpy(),
+            ResourcePtr<IFifo<E>>        fifo     = defaultFifo(),
+            MemoryResource*              resource = nullptr)
         : m_original_node(attached_node),
           m_name(name),
           m_ctx(m_original_node->m_ctx),
           m_spy(std::move(spy)),
-          m_all_nodes(),
-          m_on_entry_calls(),
+          m_tracing(m_spy && m_spy->traces()),
+          m_resource(resource ? resource : priv_ownResource()),
+          m_all_nodes(m_resource),
+          m_topology(m_resource),
+          m_runtime(m_resource),
+          m_dispatch(m_resource),
+          m_tables(m_resource),
+          m_table_block(nullptr),
+          m_table_bytes(0),
+          m_region_offsets(m_resource),
+          m_region_levels(m_resource),
+          m_hooks{this,
+                  &StateMachine::priv_onEntry,
+                  &StateMachine::priv_onExit,
+                  &StateMachine::priv_onHistory},
           m_init(false),
           m_top("Top", m_ctx, nullptr, m_original_node),
-          m_transitions(),
+          m_transitions(m_resource),
           m_event_in_progress(false),
           m_force_transition_in_progress(false),
-          m_fifo(std::move(fifo))
+          m_fifo(std::move(fifo)),
+          m_queue(m_fifo.get()),
+          m_lazy(false),
+          m_warm_in_background(false),
+          m_warm_given(nullptr),
+          m_warm_resource(nullptr),
+          m_table_state(m_resource),
+          m_warm_thread(),
+          m_warm_stop(false),
+          m_topology_cache(),
+          m_route_log(m_resource),
+          m_flat_dispatch(false),
+          m_flat(false),
+          m_flat_columns(0),
+          m_flat_column(m_resource),
+          m_flat_row(m_resource),
+          m_flat_cells(m_resource),
+          m_flat_candidates(m_resource),
+          m_flat_steps(m_resource),
+          m_dispatch_caching(false),
+          m_dispatch_cache(m_resource),
+          m_cache_stats{0, 0},
+          m_pure_results(m_resource),
+          m_dispatches(1),
+          m_pure_stats{0, 0},
+          m_guard_flags(nullptr)
+    {
+        if (!m_queue)
+        {
+#ifdef ROOST_NO_HEAP
+            m_queue = &m_inline_fifo;
+#else
+            m_fifo  = allocateUnique<QueueFifo<E>>(m_resource, m_resource);
+            m_queue = m_fifo.get();
+#endif
+        }
+    }
+
+    /*!
+     * \brief StateMachine constructs a state machine instance that only allocates from a resource
+     *
+     * The default spy and event queue are allocated from the resource as well, so every byte
+     * allocated by the StateMachine and the transition tables of its nodes comes from it.  The
+     * exceptions are the child lists of the nodes (allocated when the tree is constructed) and the
+     * thread started by setLazyInit().
+     *
+     * \param name the name of the StateMachine
+     * \param attached_node the node to attach Top as a parent to
+     * \param resource where every container of the StateMachine and its nodes allocates from,
+     * must not be nullptr
+     */
+    StateMachine(const char* name, Node<CTX, E>* attached_node, MemoryResource* resource)
+        : StateMachine(
+                  name,
+                  attached_node,
+                  std::allocate_shared<StandardErrorSpy<CTX, E>>(
+                          ResourceAllocator<StandardErrorSpy<CTX, E>>(resource)),
+                  allocateUnique<QueueFifo<E>>(resource, resource),
+                  resource)
+    {
+    }
+
+    /*!
+     * \brief StateMachine constructs a state machine instance without a spy
+     *
+     * Takes StateMachine(name, attached_node, nullptr) away from the resource overload above,
+     * keeping its meaning of "no spy".
+     *
+     * \param name the name of the StateMachine
+     * \param attached_node the node to attach Top as a parent to
+     */
+    StateMachine(const char* name, Node<CTX, E>* attached_node, std::nullptr_t)
+        : StateMachine(name, attached_node, std::shared_ptr<Spy<CTX, E>>())
     {
     }
 
     ~StateMachine()
     {
         uninit();
+        priv_releaseTables();
+    }
+
+    /*!
+     * \brief defaultSpy returns the spy used when none is given to the constructor
+     *
+     * A StandardErrorSpy, or no spy at all when building with ROOST_NO_HEAP.
+     */
+    static std::shared_ptr<Spy<CTX, E>> defaultSpy()
+    {
+#ifdef ROOST_NO_HEAP
+        return nullptr;
+#else
+        return roost::make_unique<StandardErrorSpy<CTX, E>>();
+#endif
+    }
+
+    /*!
+     * \brief defaultFifo returns the queue used when none is given to the constructor
+     *
+     * A QueueFifo, or nullptr when building with ROOST_NO_HEAP which makes the StateMachine use
+     * its inline RingFifo.
+     */
+    static ResourcePtr<IFifo<E>> defaultFifo()
+    {
+#ifdef ROOST_NO_HEAP
+        return nullptr;
+#else
+        return roost::make_unique<QueueFifo<E>>();
+#endif
     }
 
     /*!
@@ -217,6 +584,9 @@ public:
      * It is *highly* recommended to set a Spy that at least records Errors, as this function will
      * record specific errors via the Spy.
      *
+     * Running out of memory (i.e. the inline arena of a ROOST_NO_HEAP build) is reported to the
+     * Spy and fails the init when exceptions are enabled.
+     *
      * \return true if successful, otherwise false
      */
     bool init()
@@ -227,33 +597,143 @@ public:
             uninit();
         }
 
+        // A failed init() may have left some tables behind
+        priv_releaseTables();
+        priv_releaseArena();
+
+#if ROOST_HAS_EXCEPTIONS
+        try
+        {
+            m_init = priv_init();
+        }
+        catch (std::bad_alloc const&)
+        {
+            if (m_spy)
+            {
+                m_spy->error(m_name, m_ctx, "Out of memory, increase the size of the resource");
+            }
+
+            m_init = false;
+        }
+#else
+        m_init = priv_init();
+#endif
+
+        // Started last, so the thread sees a finished init() and none of its scratch
+        if (m_init && m_lazy && m_warm_in_background)
+        {
+            m_warm_resource = priv_warmResource();
+
+            if (m_warm_resource)
+            {
+                m_warm_stop.store(false);
+                m_warm_thread = std::thread([this]() { priv_warm(true); });
+            }
+            else if (m_spy)
+            {
+                m_spy->error(
+                        m_name,
+                        m_ctx,
+                        "Can't warm in background",
+                        "The resource isn't thread-safe, give setLazyInit() one for the thread");
+            }
+        }
+
+        return m_init;
+    }
+
+private:
+    bool priv_init()
+    {
         bool rval{true};
 
         do
         {
 
             m_original_node->m_parent = static_cast<Node<CTX, E>*>(&m_top);
+            m_top.m_children.clear();
             m_top.m_children.push_back(m_original_node);
             m_top.m_initial_child = m_original_node;
 
-            size_t max_depth = compute_max_depth(&m_top);
+            core::Vector<void*> nodes(m_resource);
+            u64                 cache_hash = 0;
+            bool                cache_hit  = false;
+
+            if (!m_topology_cache.empty())
+            {
+                // Only assigns the node ids, everything else comes from the cache
+                cache_hash = core::hashTree(Node<CTX, E>::treeAccess(), &m_top, nodes);
+                cache_hit  = core::loadTopologyCache(
+                        m_topology_cache, cache_hash, nodes.size(), m_topology, m_route_log);
+
+                if (!cache_hit)
+                {
+                    m_route_log.clear();
+                }
+            }
+
+            if (!cache_hit)
+            {
+                // Assigns the node ids and computes depths, levels and regions
+                core::buildTopology(Node<CTX, E>::treeAccess(), &m_top, nodes, m_topology);
+            }
+
+            m_all_nodes.clear();
+            m_dispatch.clear();
+            m_dispatch.reserve(nodes.size());
 
-            get_all_children(&m_top, m_all_nodes);
+            for (void* n : nodes)
+            {
+                Node<CTX, E>* node = static_cast<Node<CTX, E>*>(n);
+                core::NodeId  id   = m_all_nodes.size();
+
+                m_all_nodes.push_back(node);
+                m_dispatch.push_back({m_topology.parent[id], m_topology.type[id]});
+            }
+
+            m_tables.assign(m_all_nodes.size(), TransitionTable<CTX, E>());
 
             NodeConfiguration<CTX, E> config;
             config.spy                   = m_spy;
             config.current_state_machine = this;
+            config.topology              = &m_topology;
+            config.lazy                  = m_lazy;
+
+            if (m_lazy)
+            {
+                m_table_state = core::Vector<std::atomic<u8>>(m_all_nodes.size(), m_resource);
+
+                for (size_t i = 0; i < m_all_nodes.size(); ++i)
+                {
+                    m_table_state[i].store(TABLE_NOT_CREATED, std::memory_order_relaxed);
+                }
+
+                // The history transitions are only known once every table is created
+                core::markAllHistory(m_topology);
+            }
+            else
+            {
+                // Left over from an earlier lazy init(), every table is ready this time
+                m_table_state = core::Vector<std::atomic<u8>>(m_resource);
+            }
 
-            // We always have the top region, so we always have 1 region
-            size_t number_of_regions{1};
+            // Every row is collected first, so the tables can be laid out in a single block
+            core::Vector<TransitionTableBuilder<CTX, E>> builders(m_resource);
 
-            for (auto& n : m_all_nodes)
+            if (!m_lazy)
             {
+                builders.reserve(m_all_nodes.size());
 
-                if (n->m_node_type == NodeType::REGION)
+                for (size_t i = 0; i < m_all_nodes.size(); ++i)
                 {
-                    ++number_of_regions;
+                    builders.emplace_back(m_resource);
                 }
+            }
+
+            for (core::NodeId id = 0; id < m_all_nodes.size(); ++id)
+            {
+                Node<CTX, E>* n      = m_all_nodes[id];
+                config.table_builder = m_lazy ? nullptr : &builders[id];
 
                 if (!n->init(config))
                 {
@@ -270,27 +750,137 @@ public:
                 break;
             }
 
-            // The maximum number of onEntry() calls will be the max depth of the tree
-            m_on_entry_calls.reserve(max_depth);
+            if (!m_lazy)
+            {
+                priv_buildTables(builders);
+            }
 
-            // Only one transition per region can "win", we can always filter down later
-            m_transitions.reserve(number_of_regions);
+            priv_regionLevels();
+
+            m_flat = m_flat_dispatch && !m_lazy && priv_flatten();
+
+            m_cache_stats = DispatchCacheStats{0, 0};
+            m_dispatch_cache.clear();
+
+            if (m_dispatch_caching && !m_flat)
+            {
+                DispatchCache empty{core::INVALID_NODE, E(), core::INVALID_NODE, nullptr, nullptr};
+                m_dispatch_cache.assign(m_topology.size(), empty);
+            }
 
-            // Will cause the state machine to enter the initial state(s)
-            m_top.construct();
+            m_pure_stats = PureGuardStats{0, 0};
+            m_pure_results.clear();
 
-            // Clear transition vector and fire new completion event
-            m_transitions.clear();
+            // Lazy tables aren't there yet, so they might have pure guards
+            if (m_lazy || priv_hasPureGuards())
+            {
+                m_dispatches = 1;
+                PureGuardResult none{0, core::INVALID_NODE, 0, false};
+                m_pure_results.assign(PURE_GUARD_SLOTS, none);
+            }
+
+            if (!m_topology_cache.empty())
+            {
+                if (!cache_hit || m_route_log.dirty ||
+                    m_route_log.next != m_route_log.routes.size())
+                {
+                    if (!core::saveTopologyCache(
+                                m_topology_cache, cache_hash, m_topology, m_route_log) &&
+                        m_spy)
+                    {
+                        m_spy->error(m_name, m_ctx, "Failed to save topology cache");
+                    }
+                }
 
-            m_top.handle(m_original_node->getNoneEvt(), &m_transitions);
-            processTransitions(m_original_node->getNoneEvt(), &m_transitions);
+                // The routes are only replayed during init()
+                m_route_log = core::RouteLog(m_resource);
+            }
+
+            // Only one transition per region can "win", we can always filter down later
+            m_transitions.reserve(m_topology.number_of_regions);
+
+            // Pre-allocates the current nodes and history, then enters the initial state(s)
+            core::reset(m_topology, m_runtime);
+            core::construct(m_topology, m_runtime, m_hooks, core::TOP_NODE);
+
+            // Fire new completion event
+            priv_handle(m_original_node->getNoneEvt());
 
         } while (false);
 
-        m_init = rval;
         return rval;
     }
 
+    /*!
+     * \brief priv_releaseArena gives back everything the previous init() took from the arena
+     *
+     * Only does something when building with ROOST_NO_HEAP and using the inline arena, whose
+     * memory is only reclaimed all at once.
+     */
+    void priv_releaseArena()
+    {
+#ifdef ROOST_NO_HEAP
+        if (m_resource != &m_arena)
+        {
+            return;
+        }
+
+        for (auto& n : m_all_nodes)
+        {
+            n->uninit();
+        }
+
+        m_all_nodes   = core::Vector<Node<CTX, E>*>(m_resource);
+        m_topology    = core::Topology(m_resource);
+        m_runtime     = core::Runtime(m_resource);
+        m_dispatch    = core::CacheLineVector<DispatchNode>(m_resource);
+        m_tables      = core::Vector<TransitionTable<CTX, E>>(m_resource);
+        m_transitions = TransitionList<CTX, E>(m_resource);
+        m_table_state = core::Vector<std::atomic<u8>>(m_resource);
+        m_route_log   = core::RouteLog(m_resource);
+
+        m_region_offsets = core::Vector<u32>(m_resource);
+        m_region_levels  = core::Vector<RegionLevel>(m_resource);
+
+        m_flat_column     = core::Vector<u32>(m_resource);
+        m_flat_row        = core::Vector<u32>(m_resource);
+        m_flat_cells      = core::Vector<FlatCell>(m_resource);
+        m_flat_candidates = core::Vector<FlatCandidate>(m_resource);
+        m_flat_steps      = core::Vector<core::NodeId>(m_resource);
+
+        m_dispatch_cache = core::Vector<DispatchCache>(m_resource);
+        m_pure_results   = core::Vector<PureGuardResult>(m_resource);
+
+        m_arena.release();
+#endif
+    }
+
+    /*!
+     * \brief priv_warmResource returns where the warm thread allocates, see setLazyInit()
+     *
+     * \return the resource given to setLazyInit(), else the default resource if this
+     * StateMachine uses it, else nullptr as no other resource is known to be thread-safe
+     */
+    MemoryResource* priv_warmResource() const
+    {
+        if (m_warm_given)
+        {
+            return m_warm_given;
+        }
+
+        return m_resource == defaultResource() ? m_resource : nullptr;
+    }
+
+    MemoryResource* priv_ownResource()
+    {
+#ifdef ROOST_NO_HEAP
+        return &m_arena;
+#else
+        return defaultResource();
+#endif
+    }
+
+public:
     /*!
      * \brief uninit unitializes the StateMachine
      *
@@ -309,6 +899,14 @@ public:
             return;
         }
 
+        if (m_warm_thread.joinable())
+        {
+            m_warm_stop.store(true);
+            m_warm_thread.join();
+        }
+
+        priv_releaseTables();
+
         m_original_node->m_parent = nullptr;
 
         m_top.m_children.clear();
@@ -323,50 +921,283 @@ public:
     }
 
     /*!
-     * \brief getInitStatus returns true if initialized otherwise false
-     */
-    bool getInitStatus() const
-    {
-        return m_init;
-    }
-
-    /*!
-     * \brief getSCXML outputs the SCXML representation of the StateMachine to the ostream
+     * \brief reset returns the StateMachine to its initial configuration
+     *
+     * This is a cheap alternative to uninit() followed by init() for recycling an instance: the
+     * transition tables and the topology are kept as is and nothing is allocated.
+     *
+     * This function will:
+     * - Exit every active node, calling onExit() only if call_exit_hooks is true
+     * - Reset the history of every node to its initial child
+     * - Enter the initial state(s) and fire the completion event, exactly like init()
+     *
+     * Events fired while the active nodes are exited are dropped, the same as they are during
+     * forceTransitionTo().  Events fired while the initial state(s) are entered are queued and
+     * handled once the completion event has been, the same as they are during handleEvent().
      *
      * This function will do nothing if:
      * - This StateMachine is not initialized
      * - If an event is in progress (i.e. handleEvent() hasn't exited)
      * - If a forced transition is in progress(i.e. forceTransitionTo() hasn't exited)
      *
-     * If output_transitions is set to true, transitions and history nodes will be outputed to the
-     * SCXML, otherwise they won't.  It is often useful in state machines with large numbers of
-     * transitions to simply see the layout of the state machine which is why this is an option.
-     * Because in Roost HSM history nodes are attached to every composite state by default,
-     * history nodes are hidden only if output_transitions is false.
-     *
-     * \param os the ostream to write to
-     * \param output_transitions if true will output transitions and history nodes to the SCXML
+     * \param call_exit_hooks true to call onExit() (and the spy) on the nodes that are exited
+     * \return true if reset, otherwise false
      */
-    void getSCXML(std::ostream& os, bool output_transitions = true)
+    bool reset(bool call_exit_hooks = true)
     {
 
         if (!m_init || m_event_in_progress || m_force_transition_in_progress)
         {
-            return;
+            return false;
         }
 
-        os << "<scxml initial=\"" << m_original_node->getName() << "\" name=\"" << m_name
-           << "\" version=\"1.0\" xmlns=\"http://www.w3.org/2005/07/scxml\">" << std::endl;
+        m_force_transition_in_progress = true;
 
-        m_original_node->getSCXML(os, output_transitions);
+        core::Hooks exit_hooks{this, &priv_onEntry, &priv_onExit, &priv_onHistory};
 
-        os << "</scxml>" << std::endl;
-    }
+        if (!call_exit_hooks)
+        {
+            exit_hooks.on_exit = &priv_ignoreExit;
+        }
 
-    /*!
-     * \brief getGraphViz outputs the graphviz tree representation of the StateMachine to the
-     * ostream
-     *
+        core::destructUntil(m_topology, m_runtime, exit_hooks, core::TOP_NODE, core::TOP_NODE);
+
+        m_force_transition_in_progress = false;
+
+        // Anything the entry hooks or actions fire waits for the configuration to be complete
+        m_event_in_progress = true;
+
+        // Exiting recorded history along the way, so this must come after the exit
+        core::reset(m_topology, m_runtime);
+        core::construct(m_topology, m_runtime, m_hooks, core::TOP_NODE);
+
+        priv_handle(m_original_node->getNoneEvt());
+        priv_drainQueue();
+
+        m_event_in_progress = false;
+
+        return true;
+    }
+
+    /*!
+     * \brief setLazyInit turns lazy creation of the transition tables on or off
+     *
+     * By default init() calls createTransitionTable() on every node.  In lazy mode init() only
+     * validates the hierarchy, and the transition table of a node is created the first time the
+     * node is entered.  Nodes that are only reached on rare paths never pay for their rows.
+     *
+     * Errors in a lazily created table can't fail init(), so they are reported to the spy when
+     * the node is entered and the node is left without transitions.
+     *
+     * Creating a table allocates after init(), once per node.  The inline arena of a
+     * ROOST_NO_HEAP build only takes memory back at the next init(), so it must also hold the
+     * rows collected for each lazily created table.
+     *
+     * If warm_in_background is true, a successful init() starts a thread that creates all
+     * remaining tables while events are handled.  createTransitionTable() may then run on that
+     * thread, so it must only touch the node itself (which is what addRow() does).  The thread
+     * never calls the spy: a table it fails to create is left for the node's first entry, which
+     * creates it again and reports the errors on the thread handling events.  uninit() stops
+     * and joins the thread.
+     *
+     * The thread allocates its tables while the StateMachine allocates on the thread handling
+     * events, so it can't share a resource that isn't thread-safe (i.e. a StatsResource, or the
+     * inline arena of a ROOST_NO_HEAP build).  It allocates from warm_resource, which only that
+     * thread uses until uninit() joins it and must outlive the tables.  Without one, the thread
+     * is only started if the StateMachine uses defaultResource(); otherwise init() reports an
+     * error to the spy and the tables are created on entry instead.
+     *
+     * Takes effect on the next call to init().
+     *
+     * \param lazy true to create transition tables on first entry
+     * \param warm_in_background true to create the remaining tables on a background thread
+     * \param warm_resource where the background thread allocates, nullptr for the above
+     */
+    void setLazyInit(
+            bool            lazy,
+            bool            warm_in_background = false,
+            MemoryResource* warm_resource      = nullptr)
+    {
+        m_lazy               = lazy;
+        m_warm_in_background = warm_in_background;
+        m_warm_given         = warm_resource;
+    }
+
+    /*!
+     * \brief setFlatDispatch turns flattening the machine into a node by event table on or off
+     *
+     * When on, init() resolves for every node that the machine can rest in and every event the
+     * rows that could handle it (its own and those of its ancestors, in priority order), along
+     * with the nodes each of them exits and enters.  Handling an event is then a table lookup
+     * followed by the guards, and taking a row replays its steps.  Rows to a history are still
+     * resolved when taken.  The table only has a row for the nodes the machine can rest in, so it
+     * grows with the number of leaves times the number of events with rows.
+     *
+     * Only machines without orthogonal nodes are flattened, and not in lazy mode, anything else
+     * is handled as usual.  See hasFlatDispatch().
+     *
+     * Takes effect on the next call to init().
+     *
+     * \param flat true to flatten the machine
+     */
+    void setFlatDispatch(bool flat)
+    {
+        m_flat_dispatch = flat;
+    }
+
+    /*!
+     * \brief hasFlatDispatch returns true if init() flattened the machine, see setFlatDispatch()
+     */
+    bool hasFlatDispatch() const
+    {
+        return m_flat;
+    }
+
+    /*!
+     * \brief setDispatchCache gives every region a cache of its last dispatch
+     *
+     * Each region remembers the event it last dispatched and, for the node it was current in,
+     * the first node up from there with rows for that event.  Dispatching the same event again
+     * before the region moves goes straight to those rows instead of walking up the ancestors,
+     * which pays off for the repetitive event streams where most events leave the machine where
+     * it is.  The guards are still checked on every dispatch.
+     *
+     * Walks that pass through an orthogonal node are not cached.  A flattened machine (see
+     * setFlatDispatch()) has no use for the caches and doesn't create them.
+     *
+     * Takes effect on the next call to init().  See dispatchCacheStats().
+     *
+     * \param cache true to cache the last dispatch of every region
+     */
+    void setDispatchCache(bool cache)
+    {
+        m_dispatch_caching = cache;
+    }
+
+    /*!
+     * \brief dispatchCacheStats returns the hits and misses of the dispatch caches since init()
+     */
+    DispatchCacheStats dispatchCacheStats() const
+    {
+        return m_cache_stats;
+    }
+
+    /*!
+     * \brief pureGuardStats returns how often pure guards were reused since init()
+     *
+     * The result of a guard declared with ROOST_PURE_GUARD() is kept for the rest of the
+     * dispatch, i.e. until the event (or a completion event) has been dispatched into every
+     * region.  Actions only run after that, so they can't change what a pure guard returns.
+     * Every other row of the node with the same guard reuses the result instead of calling it,
+     * as does every row of any node with the same tag for a guard declared with
+     * ROOST_PURE_GUARD_TAG().  The spy only hears of the first call.
+     */
+    PureGuardStats pureGuardStats() const
+    {
+        return m_pure_stats;
+    }
+
+    /*!
+     * \brief setGuardFlags points the flag guards at a word of flags owned by the context
+     *
+     * Guards declared with ROOST_FLAG_GUARD() test the word as it is when an event is
+     * dispatched, so the context only has to keep it up to date.  Where an event has several
+     * rows in a node, their flag guards are tested together (four at a time with SSE2) and only
+     * the rows that can still be taken are looked at, in order.  A row with an ordinary guard is
+     * unaffected.
+     *
+     * \param flags the word of flags, nullptr for none (every flag reads as 0)
+     */
+    void setGuardFlags(GuardFlags const* flags)
+    {
+        m_guard_flags = flags;
+    }
+
+    /*!
+     * \brief setTopologyCache keeps the topology derived by init() in a file between runs
+     *
+     * init() hashes the shape of the tree and, if the file holds a topology for the same hash,
+     * maps it instead of building the topology and LCA index.  The routes of the transitions
+     * created during init() are stored as well, so they are replayed instead of resolved again.
+     * Otherwise the topology is built as usual and the file is (re)written.
+     *
+     * A missing, stale or corrupted file is never an error, it only costs a rebuild.  Failing to
+     * write the file is reported to the spy but doesn't fail init().
+     *
+     * Takes effect on the next call to init().
+     *
+     * \param path the path of the cache file, empty to disable the cache
+     */
+    void setTopologyCache(std::string path)
+    {
+        m_topology_cache = std::move(path);
+    }
+
+    /*!
+     * \brief warmAll creates every transition table that hasn't been created yet
+     *
+     * Only useful in lazy mode, where it moves the cost of creating the tables to a point of
+     * the caller's choosing (i.e. before latency-critical events arrive).  Does nothing if this
+     * StateMachine is not initialized.
+     */
+    void warmAll()
+    {
+        if (!m_init || !m_lazy)
+        {
+            return;
+        }
+
+        priv_warm(false);
+    }
+
+    /*!
+     * \brief getInitStatus returns true if initialized otherwise false
+     */
+    bool getInitStatus() const
+    {
+        return m_init;
+    }
+
+    /*!
+     * \brief getSCXML outputs the SCXML representation of the StateMachine to the ostream
+     *
+     * This function will do nothing if:
+     * - This StateMachine is not initialized
+     * - If an event is in progress (i.e. handleEvent() hasn't exited)
+     * - If a forced transition is in progress(i.e. forceTransitionTo() hasn't exited)
+     *
+     * If output_transitions is set to true, transitions and history nodes will be outputed to the
+     * SCXML, otherwise they won't.  It is often useful in state machines with large numbers of
+     * transitions to simply see the layout of the state machine which is why this is an option.
+     * Because in Roost HSM history nodes are attached to every composite state by default,
+     * history nodes are hidden only if output_transitions is false.
+     *
+     * \param os the ostream to write to
+     * \param output_transitions if true will output transitions and history nodes to the SCXML
+     */
+    void getSCXML(std::ostream& os, bool output_transitions = true)
+    {
+
+        if (!m_init || m_event_in_progress || m_force_transition_in_progress)
+        {
+            return;
+        }
+
+        // Every table is needed to output the transitions
+        warmAll();
+
+        os << "<scxml initial=\"" << m_original_node->getName() << "\" name=\"" << m_name
+           << "\" version=\"1.0\" xmlns=\"http://www.w3.org/2005/07/scxml\">" << std::endl;
+
+        m_original_node->getSCXML(os, output_transitions);
+
+        os << "</scxml>" << std::endl;
+    }
+
+    /*!
+     * \brief getGraphViz outputs the graphviz tree representation of the StateMachine to the
+     * ostream
+     *
      * This function will do nothing if:
      * - This StateMachine is not initialized
      * - If an event is in progress (i.e. handleEvent() hasn't exited)
@@ -390,6 +1221,153 @@ public:
         os << "}" << std::endl;
     }
 
+    /*!
+     * \brief getSymbolFile outputs the names of every node, action and guard as a symbol file
+     *
+     * See loadSymbolFile() for the format.  Output from a build without ROOST_STRIP_NAMES, the
+     * file decodes the ids output by the same StateMachine built with it.
+     *
+     * This function will do nothing if:
+     * - This StateMachine is not initialized
+     * - If an event is in progress (i.e. handleEvent() hasn't exited)
+     * - If a forced transition is in progress(i.e. forceTransitionTo() hasn't exited)
+     *
+     * \param os the ostream to write to
+     */
+    void getSymbolFile(std::ostream& os)
+    {
+
+        if (!m_init || m_event_in_progress || m_force_transition_in_progress)
+        {
+            return;
+        }
+
+        // Every table is needed to output the names of the rows
+        warmAll();
+
+        std::set<u32> written;
+
+        auto write = [&os, &written](Name name) {
+            if (name != NO_NAME && written.insert(nameIdOf(name)).second)
+            {
+                writeSymbol(os, name);
+            }
+        };
+
+        for (core::NodeId id = 0; id < m_all_nodes.size(); ++id)
+        {
+            TransitionTable<CTX, E> const& table = m_tables[id];
+
+            write(m_all_nodes[id]->m_name);
+
+            for (u32 i = 0; i < table.num_rows; ++i)
+            {
+                write(table.guard_names[i]);
+            }
+
+            for (u32 i = 0; i < table.num_actions; ++i)
+            {
+                write(table.action_names[i]);
+            }
+        }
+    }
+
+    /*!
+     * \brief memoryReport returns the bytes taken up by this StateMachine and its nodes
+     *
+     * Every container is counted by capacity, so apart from the spy and queue (see
+     * Spy::memoryBytes() and IFifo::memoryBytes()) the report adds up to what was allocated from
+     * the resource, plus the StateMachine and node objects themselves.  Tables not created yet in
+     * lazy mode count as empty.  Building the report allocates from the global heap.
+     */
+    MemoryReport memoryReport() const
+    {
+        MemoryReport report;
+        report.nodes.reserve(m_all_nodes.size());
+
+        for (core::NodeId id = 0; id < m_all_nodes.size(); ++id)
+        {
+            Node<CTX, E> const* node = m_all_nodes[id];
+            NodeMemory          memory{node->getName(), node->m_node_type, 0, 0, 0, 0, 0, 0, 0, 0};
+
+            switch (node->m_node_type)
+            {
+            case NodeType::COMPOSITE_NODE:
+                memory.object_bytes = sizeof(CompositeNode<CTX, E>);
+                break;
+            case NodeType::ORTHOGONAL_NODE:
+                memory.object_bytes = sizeof(OrthogonalNode<CTX, E>);
+                break;
+            case NodeType::REGION:
+                memory.object_bytes = sizeof(RegionNode<CTX, E>);
+                break;
+            default:
+                memory.object_bytes = sizeof(LeafNode<CTX, E>);
+                break;
+            }
+
+#ifndef ROOST_NO_HEAP
+            memory.children_bytes = capacityBytes(node->m_children);
+#endif
+
+            // Lazy tables still being created are skipped rather than waited for
+            bool table_ready = id >= m_table_state.size() ||
+                               m_table_state[id].load(std::memory_order_acquire) >= TABLE_READY;
+
+            if (table_ready && id < m_tables.size())
+            {
+                TransitionTable<CTX, E> const& table = m_tables[id];
+                auto layout = TransitionTable<CTX, E>::layout(
+                        table.num_events,
+                        table.num_rows,
+                        table.num_actions,
+                        table.flag_masks != nullptr,
+                        table.pure_tags != nullptr);
+
+                memory.index_bytes    = layout.rows;
+                memory.row_bytes      = layout.guards - layout.rows;
+                memory.delegate_bytes = layout.guard_names - layout.guards;
+                memory.name_bytes     = layout.bytes - layout.guard_names;
+                memory.num_rows       = table.num_rows;
+                memory.num_actions    = table.num_actions;
+            }
+
+            report.node_bytes += memory.object_bytes + memory.children_bytes;
+            report.table_bytes += memory.tableBytes();
+            report.nodes.push_back(memory);
+        }
+
+        core::Topology const& t = m_topology;
+
+        report.machine_bytes  = sizeof(*this);
+        report.topology_bytes = capacityBytes(t.parent) + capacityBytes(t.initial_child) +
+                                capacityBytes(t.type) + capacityBytes(t.region) +
+                                capacityBytes(t.level) + capacityBytes(t.child_offsets) +
+                                capacityBytes(t.children) + capacityBytes(t.depth) +
+                                capacityBytes(t.ancestors);
+        report.history_bytes =
+                capacityBytes(m_runtime.last_active) + capacityBytes(t.records_history);
+        report.runtime_bytes =
+                capacityBytes(m_runtime.current) + capacityBytes(m_runtime.entry_path);
+        report.dispatch_bytes = capacityBytes(m_dispatch) + capacityBytes(m_tables) +
+                                capacityBytes(m_flat_column) + capacityBytes(m_flat_row) +
+                                capacityBytes(m_flat_cells) + capacityBytes(m_flat_candidates) +
+                                capacityBytes(m_flat_steps) + capacityBytes(m_dispatch_cache) +
+                                capacityBytes(m_pure_results) + capacityBytes(m_region_offsets) +
+                                capacityBytes(m_region_levels);
+        report.scratch_bytes  = capacityBytes(m_transitions) + capacityBytes(m_all_nodes) +
+                               capacityBytes(m_table_state) + capacityBytes(m_route_log.keys) +
+                               capacityBytes(m_route_log.routes);
+        report.spy_bytes  = m_spy ? m_spy->memoryBytes() : 0;
+        report.fifo_bytes = m_fifo ? m_fifo->memoryBytes() : 0;
+
+        report.total_bytes = report.machine_bytes + report.node_bytes + report.table_bytes +
+                             report.topology_bytes + report.history_bytes + report.runtime_bytes +
+                             report.dispatch_bytes + report.scratch_bytes + report.spy_bytes +
+                             report.fifo_bytes;
+        return report;
+    }
+
     /*!
      * \brief getCurrentNodes returns the currently active nodes (not the active states)
      *
@@ -405,6 +1383,10 @@ public:
      * - If an event is in progress (i.e. handleEvent() hasn't exited)
      * - If a forced transition is in progress(i.e. forceTransitionTo() hasn't exited)*
      *
+     * Nothing is taken from the resource of this StateMachine, but the list itself lives on the
+     * global heap, so this function is not available where ROOST_NO_HEAP forbids the heap (it
+     * is meant for tests).
+     *
      * \return a list containing all current nodes
      */
     std::vector<std::string> getCurrentNodes()
@@ -417,27 +1399,19 @@ public:
             return rval;
         }
 
-        std::queue<Node<CTX, E>*> nodes;
-
-        nodes.push(m_top.m_current_node);
-
-        while (!nodes.empty())
+        struct Collector
         {
-            Node<CTX, E>* node = nodes.front();
-            nodes.pop();
-
-            rval.push_back(node->getName());
+            StateMachine*             sm;
+            std::vector<std::string>* names;
 
-            if (node->m_node_type == NodeType::ORTHOGONAL_NODE)
+            static void visit(void* collector, core::NodeId id)
             {
-                for (Node<CTX, E>* child : node->m_children)
-                {
-                    // This static cast is enforced by init()
-                    RegionNode<CTX, E>* region = static_cast<RegionNode<CTX, E>*>(child);
-                    nodes.push(region->m_current_node);
-                }
+                Collector* c = static_cast<Collector*>(collector);
+                c->names->push_back(c->sm->m_all_nodes[id]->getName());
             }
-        }
+        } collector{this, &rval};
+
+        core::currentNodes(m_topology, m_runtime, core::TOP_NODE, &Collector::visit, &collector);
 
         return rval;
     }
@@ -471,14 +1445,25 @@ public:
             return;
         }
 
+        if (!priv_isMember(dest_node))
+        {
+            if (m_spy)
+            {
+                m_spy->error(m_name, m_ctx, "Destination is not part of the state machine");
+            }
+
+            return;
+        }
+
         m_force_transition_in_progress = true;
 
         m_transitions.clear();
 
-        TransitionTableEntry<CTX, E> transition = Node<CTX, E>::priv_createTransitionEntry(
-                m_top.m_initial_child, dest_node, ROOST_NO_ACTION, ROOST_NO_GUARD);
+        TransitionTableEntry<CTX, E> transition{};
+        transition.m_route = priv_makeRoute(m_top.m_initial_child, dest_node, core::History::NONE);
+        transition.m_kind  = ROW_EXTERNAL;
 
-        m_transitions.push_back(transition);
+        m_transitions.push_back({&transition, nullptr});
 
         // Tell process transitions to ignore the event and simply transition
         // We ignore actions and don't fire the "event" function to the spy
@@ -516,7 +1501,15 @@ public:
             return;
         }
 
-        m_fifo->push(e);
+        if (!m_queue->push(e))
+        {
+            if (m_spy)
+            {
+                m_spy->error(m_name, m_ctx, "Event queue is full");
+            }
+
+            return;
+        }
 
         // The reason that we want to do this check is that other nodes
         // have the ability to fire other events within the transition
@@ -528,33 +1521,72 @@ public:
         }
 
         m_event_in_progress = true;
+        priv_drainQueue();
+        m_event_in_progress = false;
+    }
 
-        E event;
+    /*!
+     * \brief handleEvents fires a batch of events into the StateMachine, in order
+     *
+     * Does the same as calling handleEvent() for each event, but only checks the state of the
+     * StateMachine once.  While no event is in progress the events are dispatched directly
+     * instead of going through the queue.  Events posted by the actions of an event are still
+     * handled before the next event of the batch.
+     *
+     * If an event is in progress (i.e. called from an action) the events are queued instead,
+     * the ones that don't fit in the queue are dropped.  The whole batch is dropped if this
+     * StateMachine is not initialized or a forced transition is in progress.
+     *
+     * \param events the events to fire into the state machine
+     * \param count the number of events
+     * \return how many of the events were handled and how many dropped
+     */
+    BatchResult handleEvents(E const* events, size_t count)
+    {
+        BatchResult result{0, 0};
 
-        while (!m_fifo->empty())
+        if (!m_init || m_force_transition_in_progress)
         {
-            event = m_fifo->front();
-            m_fifo->pop_front();
-
-            m_transitions.clear();
-
-            m_top.handle(event, &m_transitions);
+            result.dropped = count;
+            return result;
+        }
 
-            if (m_transitions.empty())
+        if (m_event_in_progress)
+        {
+            for (size_t i = 0; i < count; ++i)
             {
-
-                if (m_spy)
+                if (m_queue->push(events[i]))
+                {
+                    ++result.handled;
+                }
+                else
                 {
-                    m_spy->no_transition(m_top.getName(), m_ctx, event);
+                    ++result.dropped;
                 }
+            }
 
-                continue;
+            if (result.dropped != 0 && m_spy)
+            {
+                m_spy->error(m_name, m_ctx, "Event queue is full");
             }
 
-            processTransitions(event, &m_transitions);
+            return result;
+        }
+
+        m_event_in_progress = true;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            priv_handleOne(events[i]);
+
+            // Whatever the actions posted comes before the rest of the batch
+            priv_drainQueue();
         }
 
         m_event_in_progress = false;
+
+        result.handled = count;
+        return result;
     }
 
     /*!
@@ -565,25 +1597,7 @@ public:
      */
     static size_t compute_max_depth(Node<CTX, E>* node, size_t depth = 1)
     {
-
-        if (!node)
-        {
-            return depth;
-        }
-
-        if (node->m_children.empty())
-        {
-            return depth;
-        }
-
-        size_t plusone = depth + 1;
-
-        for (auto& c : node->m_children)
-        {
-            depth = std::max(depth, compute_max_depth(c, plusone));
-        }
-
-        return depth;
+        return core::maxDepth(Node<CTX, E>::treeAccess(), node, depth);
     }
 
     /*!
@@ -593,16 +1607,12 @@ public:
      */
     static void get_all_children(Node<CTX, E>* node, std::vector<Node<CTX, E>*>& all_nodes)
     {
-        if (!node)
-        {
-            return;
-        }
-
-        all_nodes.push_back(node);
+        std::vector<void*> nodes;
+        core::flatten(Node<CTX, E>::treeAccess(), node, nodes);
 
-        for (auto& c : node->m_children)
+        for (void* n : nodes)
         {
-            get_all_children(c, all_nodes);
+            all_nodes.push_back(static_cast<Node<CTX, E>*>(n));
         }
     }
 
@@ -633,9 +1643,9 @@ private:
      * \param ignore_events ignore the supplied event
      */
     void processTransitions(
-            E const&                                   e,
-            std::vector<TransitionTableEntry<CTX, E>>* transitions,
-            bool                                       ignore_events = false)
+            E const&                e,
+            TransitionList<CTX, E>* transitions,
+            bool                    ignore_events = false)
     {
         E event{e};
 
@@ -646,229 +1656,969 @@ private:
             // Top is listed as level 1, so if this is zero, then it is not set
             u32 current_level{0};
 
-            for (TransitionTableEntry<CTX, E> transition : *transitions)
+            for (SelectedTransition<CTX, E> const& transition : *transitions)
             {
+                core::Route const& route = transition.row->m_route;
 
-                /*
-                 * While handle will make sure transitions are put into the vector for each level
-                 * properly, sometimes transitions can make their way outside of their region.
-                 *
-                 * Once that happens we don't want a transition that was exited from firing
-                 */
-                if (transition.m_lca_region)
+                // Internal rows have no LCA, so never take part in the level filtering
+                if ((transition.row->m_kind & ROW_EXTERNAL) &&
+                    !core::selectTransition(m_topology, current_level, route))
                 {
-                    // The lower the level, the close it is to top (which has a level of 1)
-
-                    // If it is zero, then it isn't set (The lowest is 1 for the top region)
-                    // Set the level and then continue with the current transition
-                    if (current_level == 0)
-                    {
-                        current_level = transition.m_lca_region->getLevel();
-                    }
-                    // Otherwise we have to do a check on the transition
-                    else if (current_level < transition.m_src_region->getLevel())
-                    {
-                        continue;
-                    }
+                    continue;
+                }
 
-                    if (transition.m_lca_region->getLevel() < current_level)
-                    {
-                        current_level = transition.m_lca_region->getLevel();
-                    }
+                if (priv_fire(transition, event, ignore_events))
+                {
+                    core::transition(m_topology, m_runtime, m_hooks, route);
                 }
+            }
+
+            transitions->clear();
+
+            if (!ignore_events)
+            {
+                event = m_top.getNoneEvt();
+                priv_dispatch(event, core::TOP_NODE, transitions);
+            }
+        }
+    }
+
+    /*!
+     * \brief priv_fire calls the spy and the actions of a transition, unless ignoring events
+     *
+     * \return true if the transition goes somewhere, false for an internal transition (or one
+     * without an LCA, which is reported)
+     */
+    bool priv_fire(SelectedTransition<CTX, E> const& transition, E const& event, bool ignore_events)
+    {
+        TransitionTableEntry<CTX, E> const& row   = *transition.row;
+        core::Route const&                  route = row.m_route;
+
+        if (!ignore_events)
+        {
+            if (m_tracing)
+            {
+                m_spy->event(m_all_nodes[route.src]->getName(), m_ctx, event);
+            }
+
+            if (row.m_kind & ROW_ACTIONS)
+            {
+                // Execute all actions
+                u32 first_action = row.m_first_action;
 
-                if (m_spy && !ignore_events)
+                for (u32 i = first_action; i < first_action + row.m_num_actions; ++i)
                 {
-                    m_spy->event(transition.m_src->getName(), m_ctx, event);
+                    transition.table->actions[i](event);
                 }
+            }
+        }
+
+        // Just an internal transition
+        if (!(row.m_kind & ROW_EXTERNAL))
+        {
+            return false;
+        }
+
+        if (route.lca == core::INVALID_NODE)
+        {
+            // The destination can't be valid and lca be invalid
+
+            if (m_spy)
+            {
+                m_spy->error(
+                        m_all_nodes[route.src]->getName(), m_ctx, "Transition LCA was nullptr");
+            }
+
+            ROOST_ASSERT(route.lca != core::INVALID_NODE);
+
+            return false;
+        }
+
+        return true;
+    }
+
+    //! Handles the events in the queue until it is empty, an event must be in progress
+    void priv_drainQueue()
+    {
+        while (!m_queue->empty())
+        {
+            E event = m_queue->front();
+            m_queue->pop_front();
+
+            priv_handleOne(event);
+        }
+    }
+
+    //! Handles a single event and tells the spy if nothing handled it
+    void priv_handleOne(E const& event)
+    {
+        if (!priv_handle(event) && m_spy)
+        {
+            m_spy->no_transition(m_top.getName(), m_ctx, event);
+        }
+    }
+
+    /*!
+     * \brief priv_handle handles an event and the completion events that follow
+     *
+     * \return true if a row handled the event, otherwise false
+     */
+    bool priv_handle(E const& event)
+    {
+        if (m_flat)
+        {
+            return priv_flatHandle(event);
+        }
+
+        m_transitions.clear();
+
+        priv_dispatch(event, core::TOP_NODE, &m_transitions);
+
+        if (m_transitions.empty())
+        {
+            return false;
+        }
+
+        processTransitions(event, &m_transitions);
+        return true;
+    }
+
+    //! Same as priv_handle() but with the flattened table, see setFlatDispatch()
+    bool priv_flatHandle(E const& e)
+    {
+        E    event{e};
+        bool handled{false};
 
-                if (!ignore_events)
+        while (FlatCandidate const* candidate = priv_flatSelect(event))
+        {
+            handled = true;
+
+            if (priv_fire(candidate->transition, event, false))
+            {
+                if (candidate->num_exits == FLAT_DYNAMIC)
                 {
-                    // Execute all actions
-                    for (auto& f : transition.m_actions)
-                    {
-                        f.m_action_fptr(event);
-                    }
+                    core::transition(
+                            m_topology, m_runtime, m_hooks, candidate->transition.row->m_route);
+                }
+                else
+                {
+                    core::NodeId const* exits = m_flat_steps.data() + candidate->steps;
+
+                    core::runSteps(
+                            m_topology,
+                            m_runtime,
+                            m_hooks,
+                            exits,
+                            candidate->num_exits,
+                            exits + candidate->num_exits,
+                            candidate->num_entries);
                 }
+            }
+
+            event = m_top.getNoneEvt();
+        }
+
+        return handled;
+    }
+
+    //! Returns the first candidate of the current cell whose guard passes, nullptr if none
+    FlatCandidate const* priv_flatSelect(E const& event)
+    {
+        size_t value = static_cast<size_t>(event);
+        u32    row   = m_flat_row[m_runtime.current[core::TOP_NODE]];
 
-                // Just an internal transition
-                if (transition.m_destination == nullptr)
+        priv_nextDispatch();
+
+        if (value >= m_flat_column.size() || m_flat_column[value] == FLAT_DYNAMIC ||
+            row == FLAT_DYNAMIC)
+        {
+            return nullptr;
+        }
+
+        FlatCell const& cell = m_flat_cells[row * m_flat_columns + m_flat_column[value]];
+
+        GuardFlags flags = priv_guardFlags();
+
+        for (u32 i = cell.first; i < cell.first + cell.count; ++i)
+        {
+            FlatCandidate const& candidate = m_flat_candidates[i];
+
+            if (priv_passes(*candidate.transition.table, *candidate.transition.row, event, flags))
+            {
+                return &candidate;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /*!
+     * \brief priv_flatten builds the node by event table, see setFlatDispatch()
+     *
+     * \return true if flattened, false if the machine can't be
+     */
+    bool priv_flatten()
+    {
+        m_flat_columns = 0;
+        m_flat_column.clear();
+        m_flat_row.clear();
+        m_flat_cells.clear();
+        m_flat_candidates.clear();
+        m_flat_steps.clear();
+
+        for (core::NodeId id = 0; id < m_topology.size(); ++id)
+        {
+            if (m_topology.type[id] == NodeType::ORTHOGONAL_NODE)
+            {
+                return false;
+            }
+        }
+
+        // Gives every event with rows a column
+        for (TransitionTable<CTX, E> const& table : m_tables)
+        {
+            for (u32 i = 0; i < table.num_events; ++i)
+            {
+                // Negative values wrap around and are rejected too
+                size_t value = static_cast<size_t>(table.events[i]);
+
+                if (value > FLAT_MAX_EVENT_VALUE)
                 {
-                    continue;
+                    return false;
                 }
 
-                if (transition.m_lca == nullptr)
+                if (value >= m_flat_column.size())
                 {
-                    // The destination can't be non-nullptr and lca be nullptr
+                    m_flat_column.resize(value + 1, u32{FLAT_DYNAMIC});
+                }
 
-                    if (m_spy)
+                if (m_flat_column[value] == FLAT_DYNAMIC)
+                {
+                    m_flat_column[value] = m_flat_columns++;
+                }
+            }
+        }
+
+        core::Vector<E> events(m_flat_columns, E(), m_resource);
+
+        for (size_t value = 0; value < m_flat_column.size(); ++value)
+        {
+            if (m_flat_column[value] != FLAT_DYNAMIC)
+            {
+                events[m_flat_column[value]] = static_cast<E>(value);
+            }
+        }
+
+        // Only the nodes where entering stops get a row, Top, the regions, the history nodes and
+        // the composites with an initial child are never the current node
+        u32 num_rows{0};
+        m_flat_row.assign(m_topology.size(), u32{FLAT_DYNAMIC});
+
+        for (core::NodeId id = 0; id < m_topology.size(); ++id)
+        {
+            NodeType type = m_topology.type[id];
+
+            if (m_topology.initial_child[id] == core::INVALID_NODE && type != NodeType::REGION &&
+                type != NodeType::SHALLOW_HISTORY_NODE && type != NodeType::DEEP_HISTORY_NODE)
+            {
+                m_flat_row[id] = num_rows++;
+            }
+        }
+
+        m_flat_cells.assign(num_rows * m_flat_columns, FlatCell{0, 0});
+
+        for (core::NodeId node = 0; node < m_topology.size(); ++node)
+        {
+            if (m_flat_row[node] == FLAT_DYNAMIC)
+            {
+                continue;
+            }
+
+            for (u32 column = 0; column < m_flat_columns; ++column)
+            {
+                FlatCell& cell = m_flat_cells[m_flat_row[node] * m_flat_columns + column];
+                cell.first     = static_cast<u32>(m_flat_candidates.size());
+
+                // Same order as priv_dispatch(), the node first and then up to Top
+                for (core::NodeId id = node; id != core::TOP_NODE; id = m_dispatch[id].parent)
+                {
+                    TransitionTable<CTX, E> const& table = m_tables[id];
+
+                    auto rows = table.find(events[column]);
+
+                    for (auto row = rows.first; row != rows.second; ++row)
                     {
-                        m_spy->error(
-                                transition.m_src->getName(), m_ctx, "Transition LCA was nullptr");
-                    }
+                        FlatCandidate candidate{{row, &table}, 0, FLAT_DYNAMIC, 0};
+                        candidate.steps = static_cast<u32>(m_flat_steps.size());
 
-                    ROOST_ASSERT(transition.m_lca != nullptr);
+                        if (!(row->m_kind & ROW_HISTORY))
+                        {
+                            core::flattenTransition(
+                                    m_topology,
+                                    node,
+                                    row->m_route,
+                                    m_flat_steps,
+                                    candidate.num_exits,
+                                    candidate.num_entries);
+                        }
 
-                    continue;
+                        m_flat_candidates.push_back(candidate);
+                    }
                 }
 
-                transition.m_lca_region->destructUntilNode(transition.m_lca);
+                cell.count = static_cast<u32>(m_flat_candidates.size()) - cell.first;
+            }
+        }
 
-                m_on_entry_calls.clear();
+        return true;
+    }
 
-                Node<CTX, E>* tmp = transition.m_destination;
+    /*!
+     * \brief priv_makeRoute resolves the route of a row from src to dst
+     *
+     * Both nodes must be part of this StateMachine, see core::makeRoute() for how the route is
+     * resolved.  If history isn't core::History::NONE, then the row goes to that history of dst.
+     */
+    core::Route priv_makeRoute(Node<CTX, E>* src, Node<CTX, E>* dst, core::History history)
+    {
+        core::NodeId src_id = src->m_id;
+        core::NodeId dst_id = dst ? dst->m_id : core::INVALID_NODE;
+
+        core::Route route;
+
+        if (m_init || m_topology_cache.empty())
+        {
+            route = core::makeRoute(m_topology, src_id, dst_id, history);
+        }
+        else
+        {
+            route = core::makeRoute(m_topology, m_route_log, src_id, dst_id, history);
+        }
+
+        // Lazy mode already marked everything, and the tables may be created concurrently
+        if (!m_lazy)
+        {
+            core::markHistory(m_topology, route.destination, route.history);
+        }
+
+        return route;
+    }
 
-                while (tmp != transition.m_lca)
+    //! Returns true if the node was given an id by this StateMachine, otherwise false
+    bool priv_isMember(Node<CTX, E>* node) const
+    {
+        return node && node->m_id < m_all_nodes.size() && m_all_nodes[node->m_id] == node;
+    }
+
+    /*!
+     * \brief priv_dispatch finds the rows which handle event in a region
+     *
+     * Starting at the current node of the region, the first node with a row whose guard passes
+     * handles the event.  The regions of an orthogonal node are asked in order, and the
+     * orthogonal node's own rows are only checked if none of them handled it.
+     *
+     * \return true if the event was handled, otherwise false
+     */
+    bool priv_dispatch(E const& event, core::NodeId region, TransitionList<CTX, E>* transitions)
+    {
+        u32 level{0};
+
+        priv_nextDispatch();
+        return priv_dispatch(event, region, transitions, level);
+    }
+
+    /*!
+     * \brief priv_dispatch with the level processTransitions() will have reached once it gets to
+     * the rows selected so far, see core::selectTransition()
+     *
+     * Once a region of an orthogonal node has handled the event, a later region whose rows can
+     * only be selected below that level is exited by a transition already selected, and
+     * processTransitions() would discard anything selected in it.  Such regions are skipped, so
+     * their guards aren't even called.  A row into a sibling region is selected at the level of
+     * the orthogonal node rather than its own, see priv_regionLevels().
+     */
+    bool priv_dispatch(
+            E const&                event,
+            core::NodeId            region,
+            TransitionList<CTX, E>* transitions,
+            u32&                    level)
+    {
+        core::NodeId id = m_runtime.current[region];
+
+        if (!m_dispatch_cache.empty())
+        {
+            DispatchCache& cache = m_dispatch_cache[region];
+
+            if (cache.node == id && cache.event == event)
+            {
+                ++m_cache_stats.hits;
+            }
+            else
+            {
+                ++m_cache_stats.misses;
+                priv_fillCache(cache, event, region, id);
+            }
+
+            // Otherwise the walk went through an orthogonal node, so is done as usual
+            if (cache.node == id)
+            {
+                if (cache.handler == core::INVALID_NODE)
                 {
-                    m_on_entry_calls.push_back(tmp);
-                    tmp = tmp->getParent();
+                    return false;
                 }
 
-                RegionNode<CTX, E>* current_region = transition.m_lca_region;
+                TransitionTable<CTX, E> const&      table = m_tables[cache.handler];
+                TransitionTableEntry<CTX, E> const* row =
+                        priv_firstPassing(table, cache.first, cache.last, event);
 
-                for (auto it = m_on_entry_calls.rbegin(); it != m_on_entry_calls.rend(); ++it)
+                if (row)
                 {
-                    Node<CTX, E>* current_node = *it;
+                    priv_select(row, table, transitions, level);
+                    return true;
+                }
+
+                // Every guard failed, the ancestors of the handler are next
+                id = m_dispatch[cache.handler].parent;
+            }
+        }
+
+        for (; id != region; id = m_dispatch[id].parent)
+        {
+            if (m_dispatch[id].type == NodeType::ORTHOGONAL_NODE)
+            {
+                bool handled{false};
 
-                    // Because we are forcing our way through nodes, we have to call our spy here
-                    // but not on regions themselves
-                    if (this->m_spy)
+                // Not short-circuited, so every region gets its own transition unless exited
+                for (const core::NodeId* child = m_topology.childrenBegin(id);
+                     child != m_topology.childrenEnd(id);
+                     ++child)
+                {
+                    if (handled && level != 0 && level < priv_regionLevel(*child, event))
                     {
-                        this->m_spy->on_entry(current_node->getName(), this->m_ctx);
+                        continue;
                     }
 
-                    current_region->m_current_node = current_node;
-                    current_node->onEntry();
+                    handled = priv_dispatch(event, *child, transitions, level) || handled;
+                }
 
-                    if (current_node->m_node_type == NodeType::ORTHOGONAL_NODE)
-                    {
+                if (handled)
+                {
+                    return true;
+                }
+            }
 
-                        Node<CTX, E>* orthogonal_node = current_node;
+            TransitionTable<CTX, E> const&      table = m_tables[id];
+            auto                                rows  = table.find(event);
+            TransitionTableEntry<CTX, E> const* row =
+                    priv_firstPassing(table, rows.first, rows.second, event);
 
-                        ++it;
+            if (row)
+            {
+                priv_select(row, table, transitions, level);
+                return true;
+            }
+        }
 
-                        // If the transition ends at the orthogonal node, then we still have to
-                        // initialize The children of the orthogonal node
-                        if (it == m_on_entry_calls.rend())
-                        {
+        return false;
+    }
 
-                            for (Node<CTX, E>* child : orthogonal_node->m_children)
-                            {
-                                // Enforced by init()
-                                RegionNode<CTX, E>* region =
-                                        static_cast<RegionNode<CTX, E>*>(child);
-                                region->construct();
-                            }
-
-                            // We need a break here because otherwise the iterator won't exit the
-                            // for-loop
-                            break;
-                        }
-                        else
-                        {
+    /*!
+     * \brief priv_regionLevels finds, for each region and event, the lowest level of the source
+     * region of any row for the event of the nodes under the region
+     *
+     * core::selectTransition() keeps a row while the level reached is at or below the level of
+     * its source region.  That is usually the region of the row's node, but a row into a sibling
+     * region has the orthogonal node as its source, and an internal row is always kept.  So
+     * priv_dispatch() can only skip a region when the level is below all of them.  Lazy tables
+     * aren't known yet, so no region is skipped in lazy mode.
+     */
+    void priv_regionLevels()
+    {
+        m_region_offsets.clear();
+        m_region_levels.clear();
 
-                            ROOST_ASSERT((*it)->m_node_type == NodeType::REGION);
+        if (m_lazy)
+        {
+            return;
+        }
 
-                            current_region = static_cast<RegionNode<CTX, E>*>(*it);
+        using Found = std::pair<core::NodeId, RegionLevel>;
+        core::Vector<Found> found(m_resource);
 
-                            for (Node<CTX, E>* child : orthogonal_node->m_children)
-                            {
-                                // Skip the one that we are personally handling
-                                if (child == current_region)
-                                {
-                                    continue;
-                                }
+        for (core::NodeId id = 0; id < m_tables.size(); ++id)
+        {
+            TransitionTable<CTX, E> const& table = m_tables[id];
 
-                                // Enforced by init()
-                                RegionNode<CTX, E>* region =
-                                        static_cast<RegionNode<CTX, E>*>(child);
-                                region->construct();
-                            }
-                        }
-                    }
+            for (u32 e = 0; e < table.num_events; ++e)
+            {
+                u32 lowest = std::numeric_limits<u32>::max();
 
-                    else if (current_node->m_node_type == NodeType::SHALLOW_HISTORY_NODE)
-                    {
+                for (u32 i = table.offsets[e]; i < table.offsets[e + 1]; ++i)
+                {
+                    core::Route const& route = table.rows[i].m_route;
+                    u32                level = route.lca_region == core::INVALID_NODE
+                                                       ? 0
+                                                       : m_topology.level[route.src_region];
 
-                        // We know that history nodes have no children and thus can only be called
-                        // As the last node
+                    lowest = level < lowest ? level : lowest;
+                }
 
-                        // Only composite states can have history nodes
-                        Node<CTX, E>* containing_composite_state = current_node->m_parent;
-                        ROOST_ASSERT(
-                                containing_composite_state->m_node_type ==
-                                NodeType::COMPOSITE_NODE);
+                for (core::NodeId r = m_topology.region[id]; r != core::INVALID_NODE;)
+                {
+                    found.push_back(Found(r, RegionLevel{table.events[e], lowest}));
 
-                        Node<CTX, E>* next_target =
-                                containing_composite_state->m_last_active_child;
+                    core::NodeId parent = m_topology.parent[r];
+                    r = parent == core::INVALID_NODE ? core::INVALID_NODE
+                                                     : m_topology.region[parent];
+                }
+            }
+        }
 
-                        // We simply call the on entry of the last node for simple history
-                        if (this->m_spy)
-                        {
-                            this->m_spy->on_entry(next_target->getName(), this->m_ctx);
-                        }
+        // The lowest level of a region and event comes first and is the one kept
+        std::sort(found.begin(), found.end(), [](Found const& a, Found const& b) {
+            if (a.first != b.first)
+            {
+                return a.first < b.first;
+            }
 
-                        next_target->onEntry();
-                        current_region->m_current_node = next_target;
+            if (a.second.event != b.second.event)
+            {
+                return a.second.event < b.second.event;
+            }
 
-                        if (current_region->m_current_node->m_node_type ==
-                            NodeType::ORTHOGONAL_NODE)
-                        {
+            return a.second.level < b.second.level;
+        });
 
-                            for (Node<CTX, E>* child : current_region->m_current_node->m_children)
-                            {
-                                // Enforced by init()
-                                RegionNode<CTX, E>* region =
-                                        static_cast<RegionNode<CTX, E>*>(child);
-                                region->construct();
-                            }
-                        }
+        m_region_offsets.assign(m_topology.size() + 1, 0);
 
-                        break;
-                    }
+        for (size_t i = 0; i < found.size(); ++i)
+        {
+            if (i != 0 && found[i].first == found[i - 1].first &&
+                found[i].second.event == found[i - 1].second.event)
+            {
+                continue;
+            }
 
-                    else if (current_node->m_node_type == NodeType::DEEP_HISTORY_NODE)
-                    {
+            m_region_levels.push_back(found[i].second);
+            ++m_region_offsets[found[i].first + 1];
+        }
 
-                        // We know that history nodes have no children and thus can only be called
-                        // As the last node
+        for (size_t r = 1; r < m_region_offsets.size(); ++r)
+        {
+            m_region_offsets[r] += m_region_offsets[r - 1];
+        }
+    }
 
-                        // Only composite states can have history nodes
-                        Node<CTX, E>* containing_composite_state = current_node->m_parent;
-                        ROOST_ASSERT(
-                                containing_composite_state->m_node_type ==
-                                NodeType::COMPOSITE_NODE);
+    //! Returns the lowest level a row for event under region can be selected at, 0 if unknown
+    u32 priv_regionLevel(core::NodeId region, E const& event) const
+    {
+        if (m_region_offsets.empty())
+        {
+            return 0;
+        }
 
-                        Node<CTX, E>* next_target =
-                                containing_composite_state->m_last_active_child;
+        RegionLevel const* first = m_region_levels.data() + m_region_offsets[region];
+        RegionLevel const* last  = m_region_levels.data() + m_region_offsets[region + 1];
+        RegionLevel const* it    = std::lower_bound(
+                first, last, event, [](RegionLevel const& l, E const& e) { return l.event < e; });
 
-                        // We simply call the on entry of the last node for simple history
-                        if (this->m_spy)
-                        {
-                            this->m_spy->on_entry(next_target->getName(), this->m_ctx);
-                        }
+        // Without rows for the event nothing can be selected under the region
+        return it != last && it->event == event ? it->level : std::numeric_limits<u32>::max();
+    }
+
+    //! Forgets the results of the pure guards, see pureGuardStats()
+    void priv_nextDispatch()
+    {
+        if (++m_dispatches == 0)
+        {
+            // Wrapped around, a result stamped with the new count would look current
+            for (PureGuardResult& result : m_pure_results)
+            {
+                result.dispatch = 0;
+            }
 
-                        next_target->onEntry();
-                        current_region->m_current_node = next_target;
-                        current_region->constructFromDeepHistory();
+            m_dispatches = 1;
+        }
+    }
 
-                        break;
-                    }
+    //! Returns true if any row has a pure guard
+    bool priv_hasPureGuards() const
+    {
+        for (TransitionTable<CTX, E> const& table : m_tables)
+        {
+            for (u32 i = 0; i < table.num_rows; ++i)
+            {
+                if (table.rows[i].m_kind & ROW_PURE)
+                {
+                    return true;
                 }
+            }
+        }
+
+        return false;
+    }
+
+    /*!
+     * \brief priv_guardKey returns what identifies the guard of a row within its node, rows
+     * share the result of a pure guard by its key
+     */
+    static uintptr_t priv_guardKey(TransitionTable<CTX, E> const& table, u16 guard)
+    {
+        if (table.pure_tags && table.pure_tags[guard] != 0)
+        {
+            return table.pure_tags[guard];
+        }
 
-                // We want to make sure we "drill down" after finalizing the transition
-                // after all we could have ended up in a new region
-                current_region->construct();
+#ifdef ROOST_STRIP_NAMES
+        return table.guard_names[guard];
+#else
+        // The same literal has the same address, at worst a guard has a few keys
+        return reinterpret_cast<uintptr_t>(table.guard_names[guard]);
+#endif
+    }
+
+    //! Returns the flags tested by flag guards, see setGuardFlags()
+    GuardFlags priv_guardFlags() const
+    {
+        return m_guard_flags ? *m_guard_flags : 0;
+    }
+
+    /*!
+     * \brief priv_firstPassing returns the first row in [first, last) whose guard passes for
+     * event, nullptr if none
+     *
+     * If the table has flag guards the rows are tested 32 at a time by core::matchFlags(), rows
+     * without one always match, so only the rows that matched are looked at any further.
+     */
+    TransitionTableEntry<CTX, E> const* priv_firstPassing(
+            TransitionTable<CTX, E> const&      table,
+            TransitionTableEntry<CTX, E> const* first,
+            TransitionTableEntry<CTX, E> const* last,
+            E const&                            event)
+    {
+        GuardFlags flags = priv_guardFlags();
+
+        if (!table.flag_masks)
+        {
+            for (TransitionTableEntry<CTX, E> const* row = first; row != last; ++row)
+            {
+                if (priv_passes(table, *row, event, flags))
+                {
+                    return row;
+                }
             }
 
-            transitions->clear();
+            return nullptr;
+        }
 
-            if (!ignore_events)
+        for (; first < last; first += 32)
+        {
+            size_t i       = first - table.rows;
+            u32    count   = static_cast<u32>(std::min<ptrdiff_t>(last - first, 32));
+            u32    matches = core::matchFlags(
+                    flags, table.flag_masks + i, table.flag_expected + i, count);
+
+            while (matches != 0)
             {
-                event = m_top.getNoneEvt();
-                m_top.handle(event, transitions);
+                TransitionTableEntry<CTX, E> const* row = first + core::lowestBit(matches);
+
+                // The flag guards are done, an ordinary guard still has to pass
+                if (!(row->m_kind & ROW_GUARDED) || priv_passes(table, *row, event, flags))
+                {
+                    return row;
+                }
+
+                matches &= matches - 1;
             }
         }
+
+        return nullptr;
+    }
+
+    /*!
+     * \brief priv_passes returns true if the guard of row passes for event and flags
+     *
+     * Pure guards are only called once per dispatch, see pureGuardStats().
+     */
+    bool priv_passes(
+            TransitionTable<CTX, E> const&      table,
+            TransitionTableEntry<CTX, E> const& row,
+            E const&                            event,
+            GuardFlags                          flags)
+    {
+        if (!(row.m_kind & ROW_PURE) || m_pure_results.empty())
+        {
+            return table.passes(row, event, flags);
+        }
+
+        // Tagged guards are shared by every node, the others only by the rows of their own
+        bool         shared = table.pure_tags && table.pure_tags[row.m_guard] != 0;
+        core::NodeId owner  = shared ? core::INVALID_NODE
+                                     : static_cast<core::NodeId>(&table - m_tables.data());
+        uintptr_t    key    = priv_guardKey(table, row.m_guard);
+        uintptr_t    hash   = key ^ (key >> 5) ^ (static_cast<uintptr_t>(owner) * 0x9E3779B1u);
+
+        PureGuardResult& result = m_pure_results[hash & (PURE_GUARD_SLOTS - 1)];
+
+        if (result.dispatch == m_dispatches && result.key == key && result.owner == owner)
+        {
+            ++m_pure_stats.hits;
+            return result.value;
+        }
+
+        ++m_pure_stats.misses;
+
+        result.key      = key;
+        result.owner    = owner;
+        result.dispatch = m_dispatches;
+        result.value    = table.guards[row.m_guard](event);
+        return result.value;
+    }
+
+    //! Selects a row and keeps track of the level like processTransitions() will
+    void priv_select(
+            TransitionTableEntry<CTX, E> const* row,
+            TransitionTable<CTX, E> const&      table,
+            TransitionList<CTX, E>*             transitions,
+            u32&                                level)
+    {
+        transitions->push_back({row, &table});
+
+        if (row->m_kind & ROW_EXTERNAL)
+        {
+            core::selectTransition(m_topology, level, row->m_route);
+        }
+    }
+
+    /*!
+     * \brief priv_fillCache walks up from the current node of a region to find the first node
+     * with rows for event, see setDispatchCache()
+     *
+     * Leaves the cache empty if the walk reaches an orthogonal node, as which rows handle the
+     * event then depends on the current nodes of its regions too.
+     */
+    void priv_fillCache(DispatchCache& cache, E const& event, core::NodeId region, core::NodeId id)
+    {
+        cache.node    = core::INVALID_NODE;
+        cache.event   = event;
+        cache.handler = core::INVALID_NODE;
+
+        for (core::NodeId node = id; node != region; node = m_dispatch[node].parent)
+        {
+            if (m_dispatch[node].type == NodeType::ORTHOGONAL_NODE)
+            {
+                return;
+            }
+
+            auto rows = m_tables[node].find(event);
+
+            if (rows.first != rows.second)
+            {
+                cache.handler = node;
+                cache.first   = rows.first;
+                cache.last    = rows.second;
+                break;
+            }
+        }
+
+        cache.node = id;
+    }
+
+    /*!
+     * \brief priv_createTable creates the transition table of a node if not created yet
+     *
+     * The first thread to claim the node creates the table; any other thread waits until it is
+     * ready, so the table is always complete once this returns on the thread handling events.
+     *
+     * The warm thread never calls the spy.  A table it fails to create (or runs out of memory
+     * for) goes back to TABLE_NOT_CREATED, so the node is created again when it is entered and
+     * the errors are reported from there.
+     *
+     * \param id the node of the table
+     * \param background true if called from the warm thread
+     */
+    void priv_createTable(core::NodeId id, bool background = false)
+    {
+        std::atomic<u8>& state = m_table_state[id];
+
+        if (state.load(std::memory_order_acquire) >= TABLE_READY)
+        {
+            return;
+        }
+
+        u8 expected = TABLE_NOT_CREATED;
+
+        // The other thread may give the node back rather than create it, so waiting has to claim
+        while (!state.compare_exchange_weak(expected, TABLE_CREATING, std::memory_order_acq_rel))
+        {
+            if (expected >= TABLE_READY)
+            {
+                return;
+            }
+
+            expected = TABLE_NOT_CREATED;
+            std::this_thread::yield();
+        }
+
+#if ROOST_HAS_EXCEPTIONS
+        try
+        {
+#endif
+            MemoryResource*                resource = background ? m_warm_resource : m_resource;
+            Node<CTX, E>*                  node     = m_all_nodes[id];
+            TransitionTableBuilder<CTX, E> builder(resource);
+            builder.silent = background;
+
+            if (node->priv_createTransitionTable(builder))
+            {
+                // Each table has a block of its own, as they are created one at a time
+                m_tables[id] = builder.build(priv_allocateTableBlock(resource, builder.bytes()));
+            }
+            else if (background)
+            {
+                state.store(TABLE_NOT_CREATED, std::memory_order_release);
+                return;
+            }
+            else if (m_spy)
+            {
+                m_spy->error(node->getName(), m_ctx, "Failed Lazy Init");
+            }
+#if ROOST_HAS_EXCEPTIONS
+        }
+        catch (std::bad_alloc const&)
+        {
+            state.store(TABLE_NOT_CREATED, std::memory_order_release);
+
+            if (!background)
+            {
+                throw;
+            }
+
+            // Leaves the rest to be created on entry, when the error can be reported
+            m_warm_stop.store(true, std::memory_order_relaxed);
+            return;
+        }
+#endif
+
+        state.store(background ? TABLE_WARMED : TABLE_READY, std::memory_order_release);
+    }
+
+    /*!
+     * \brief priv_buildTables lays out the tables of every node in a single block
+     *
+     * The size of the block is known from the builders, so it is allocated once and released
+     * at once by priv_releaseTables().
+     */
+    void priv_buildTables(core::Vector<TransitionTableBuilder<CTX, E>>& builders)
+    {
+        m_table_bytes = 0;
+
+        for (auto const& builder : builders)
+        {
+            m_table_bytes += builder.bytes();
+        }
+
+        m_table_block = priv_allocateTableBlock(m_resource, m_table_bytes);
+        char* at      = static_cast<char*>(m_table_block);
+
+        for (core::NodeId id = 0; id < builders.size(); ++id)
+        {
+            m_tables[id] = builders[id].build(at);
+            at += builders[id].bytes();
+        }
+    }
+
+    static void* priv_allocateTableBlock(MemoryResource* resource, size_t bytes)
+    {
+        return bytes ? resource->allocate(bytes, CACHE_LINE_SIZE) : nullptr;
+    }
+
+    //! Destroys every table and frees its memory, either the single block or one per table
+    void priv_releaseTables()
+    {
+        for (core::NodeId id = 0; id < m_tables.size(); ++id)
+        {
+            TransitionTable<CTX, E>& table = m_tables[id];
+            void*                    block = table.data();
+            size_t                   bytes = table.bytes();
+
+            table.destroy();
+
+            if (!m_table_block && block)
+            {
+                bool warmed = id < m_table_state.size() &&
+                              m_table_state[id].load(std::memory_order_acquire) == TABLE_WARMED;
+
+                (warmed ? m_warm_resource : m_resource)->deallocate(block, bytes, CACHE_LINE_SIZE);
+            }
+        }
+
+        if (m_table_block)
+        {
+            m_resource->deallocate(m_table_block, m_table_bytes, CACHE_LINE_SIZE);
+        }
+
+        m_table_block = nullptr;
+        m_table_bytes = 0;
+    }
+
+    void priv_warm(bool background)
+    {
+        for (core::NodeId id = 0; id < m_all_nodes.size(); ++id)
+        {
+            if (background && m_warm_stop.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+
+            priv_createTable(id, background);
+        }
+    }
+
+    static void priv_onEntry(void* ctx, core::NodeId id)
+    {
+        StateMachine* self = static_cast<StateMachine*>(ctx);
+        Node<CTX, E>* node = self->m_all_nodes[id];
+
+        if (self->m_lazy)
+        {
+            self->priv_createTable(id);
+        }
+
+        if (self->m_tracing)
+        {
+            self->m_spy->on_entry(node->getName(), self->m_ctx);
+        }
+
+        node->onEntry();
+    }
+
+    static void priv_onExit(void* ctx, core::NodeId id)
+    {
+        StateMachine* self = static_cast<StateMachine*>(ctx);
+        Node<CTX, E>* node = self->m_all_nodes[id];
+
+        if (self->m_tracing)
+        {
+            self->m_spy->on_exit(node->getName(), self->m_ctx);
+        }
+
+        node->onExit();
+    }
+
+    static void priv_ignoreExit(void*, core::NodeId)
+    {
+    }
+
+    static void priv_onHistory(void* ctx, core::NodeId, core::History history)
+    {
+        StateMachine* self = static_cast<StateMachine*>(ctx);
+
+        // History targets aren't nodes, but entering one is still reported
+        if (self->m_tracing)
+        {
+            self->m_spy->on_entry(core::historyName(history), self->m_ctx);
+        }
     }
 
 };  // Class: StateMachine
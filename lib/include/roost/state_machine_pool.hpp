@@ -0,0 +1,259 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROOST_LIB_STATE_MACHINE_POOL_HPP
+#define ROOST_LIB_STATE_MACHINE_POOL_HPP
+
+#include "roost/alias.hpp"
+#include "roost/common.hpp"
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace roost
+{
+
+/*!
+ * \brief StateMachinePool keeps initialized StateMachine sessions ready to be handed out
+ *
+ * Constructing a session means constructing its whole node tree, a StateMachine with its spy and
+ * queue, and then running init().  A pool does all of that once per slot when it is initialized
+ * and afterwards acquire() and release() only move a slot on and off a free list, so neither
+ * touches the global heap.
+ *
+ * SESSION is the user's type that owns the context, the root node and the StateMachine, and
+ * gives access to the latter through stateMachine():
+ *
+ * struct Session
+ * {
+ *     Session() : m_root("root", m_ctx, nullptr), m_sm("Session", &m_root)
+ *     {
+ *         m_ctx.m_root = &m_root;
+ *     }
+ *
+ *     SMTypes::StateMachine& stateMachine()
+ *     {
+ *         return m_sm;
+ *     }
+ *
+ *     Ctx                   m_ctx;
+ *     RootState             m_root;
+ *     SMTypes::StateMachine m_sm;
+ * };
+ *
+ * Sessions are constructed in place in a single slab and never move, so SESSION doesn't need to
+ * be copyable or movable.  A released session is reset() before it goes back on the free list,
+ * so every session handed out is in its initial configuration.  A session released while it is
+ * busy (i.e. its Handle is dropped from one of its own actions) can't be reset yet, so it is
+ * set aside and reset by the next acquire() instead.
+ */
+template <typename SESSION>
+class StateMachinePool
+{
+public:
+    //! Returns a session to its pool when a Handle goes out of scope
+    struct Releaser
+    {
+        StateMachinePool* m_pool;
+
+        void operator()(SESSION* session) const
+        {
+            m_pool->release(session);
+        }
+    };  // Struct: Releaser
+
+    using Handle = std::unique_ptr<SESSION, Releaser>;
+
+    /*!
+     * \brief StateMachinePool allocates the slab and constructs every session in it
+     *
+     * After constructing the pool, init() still needs to be called.
+     *
+     * \param capacity the number of sessions in the pool
+     * \param args passed to the constructor of every session
+     */
+    template <typename... Args>
+    explicit StateMachinePool(size_t capacity, Args const&... args)
+        : m_slab(new Slot[capacity]),
+          m_capacity(capacity),
+          m_free(),
+          m_deferred(),
+          m_init(false),
+          m_exit_hooks_on_release(true)
+    {
+        m_free.reserve(capacity);
+        m_deferred.reserve(capacity);
+
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            new (&m_slab[i]) SESSION(args...);
+        }
+    }
+
+    ~StateMachinePool()
+    {
+        // Handles must not outlive their pool
+        ROOST_ASSERT(!m_init || m_free.size() + m_deferred.size() == m_capacity);
+
+        for (size_t i = 0; i < m_capacity; ++i)
+        {
+            session(i)->~SESSION();
+        }
+    }
+
+    StateMachinePool(StateMachinePool const&) = delete;
+    StateMachinePool& operator=(StateMachinePool const&) = delete;
+
+    /*!
+     * \brief init initializes the StateMachine of every session and fills the free list
+     *
+     * If already initialized, then this function does nothing.
+     *
+     * \return true if every StateMachine initialized, otherwise false
+     */
+    bool init()
+    {
+        if (m_init)
+        {
+            return true;
+        }
+
+        for (size_t i = 0; i < m_capacity; ++i)
+        {
+            if (!session(i)->stateMachine().init())
+            {
+                return false;
+            }
+        }
+
+        // Handed out from the back, so the first session is handed out first
+        for (size_t i = m_capacity; i-- > 0;)
+        {
+            m_free.push_back(static_cast<u32>(i));
+        }
+
+        m_init = true;
+        return true;
+    }
+
+    /*!
+     * \brief setExitHooksOnRelease sets whether release() calls onExit() on the active nodes
+     *
+     * Defaults to true.  Turning it off makes release() cheaper when the active configuration of
+     * a finished session doesn't need to be exited.
+     */
+    void setExitHooksOnRelease(bool exit_hooks)
+    {
+        m_exit_hooks_on_release = exit_hooks;
+    }
+
+    /*!
+     * \brief acquire hands out a session in its initial configuration
+     * \return the session or an empty Handle if not initialized or every session is in use
+     */
+    Handle acquire()
+    {
+        priv_resetDeferred();
+
+        if (m_free.empty())
+        {
+            return Handle(nullptr, Releaser{this});
+        }
+
+        u32 idx = m_free.back();
+        m_free.pop_back();
+
+        return Handle(session(idx), Releaser{this});
+    }
+
+    /*!
+     * \brief release resets a session and puts it back in the pool
+     *
+     * Called by the Handle, there is normally no need to call it directly.
+     *
+     * If the StateMachine of the session can't be reset right now (an event or a forced
+     * transition is in progress) the session is only put back by a later acquire().
+     *
+     * \param s a session handed out by this pool
+     */
+    void release(SESSION* s)
+    {
+        size_t idx = static_cast<size_t>(reinterpret_cast<Slot*>(s) - m_slab.get());
+
+        ROOST_ASSERT(idx < m_capacity);
+
+        if (s->stateMachine().reset(m_exit_hooks_on_release))
+        {
+            m_free.push_back(static_cast<u32>(idx));
+        }
+        else
+        {
+            m_deferred.push_back(static_cast<u32>(idx));
+        }
+    }
+
+    //! Returns the number of sessions that can be acquired, including those not yet reset
+    size_t available() const
+    {
+        return m_free.size() + m_deferred.size();
+    }
+
+    //! Returns the number of sessions in the pool
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+private:
+    using Slot = typename std::aligned_storage<sizeof(SESSION), alignof(SESSION)>::type;
+
+    SESSION* session(size_t idx)
+    {
+        return reinterpret_cast<SESSION*>(&m_slab[idx]);
+    }
+
+    //! Resets the sessions whose release() was deferred, those that are still busy stay put
+    void priv_resetDeferred()
+    {
+        size_t kept = 0;
+
+        for (u32 idx : m_deferred)
+        {
+            if (session(idx)->stateMachine().reset(m_exit_hooks_on_release))
+            {
+                m_free.push_back(idx);
+            }
+            else
+            {
+                m_deferred[kept++] = idx;
+            }
+        }
+
+        m_deferred.resize(kept);
+    }
+
+    std::unique_ptr<Slot[]> m_slab;      //!< Storage of every session, constructed in place
+    size_t                  m_capacity;  //!< The number of sessions in m_slab
+    std::vector<u32>        m_free;      //!< Indices of the sessions that can be acquired
+    std::vector<u32>        m_deferred;  //!< Indices of the released sessions not yet reset
+    bool                    m_init;      //!< True if initialized, otherwise false
+    bool m_exit_hooks_on_release;        //!< True if release() calls onExit() on active nodes
+
+};  // Class: StateMachinePool
+
+}  // ns: roost
+
+#endif  // ROOST_LIB_STATE_MACHINE_POOL_HPP
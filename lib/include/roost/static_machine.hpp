@@ -0,0 +1,899 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROOST_LIB_STATIC_MACHINE_HPP
+#define ROOST_LIB_STATIC_MACHINE_HPP
+
+#include "roost/alias.hpp"
+#include "roost/core.hpp"
+#include "roost/fixed_storage.hpp"
+#include "roost/names.hpp"
+#include "roost/state_machine.hpp"
+
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/*
+ * The StaticMachine is a second front end for machines whose shape is fixed at compile time.  The
+ * states, the hierarchy and the transition table are all types, so every transition is resolved
+ * by the compiler: the LCA, the nodes to exit and the nodes to enter are template arguments and
+ * dispatch is a chain of direct (inlinable) calls.  There are no virtual calls, no transition
+ * table in memory and nothing is allocated.
+ *
+ * It implements the same semantics as StateMachine for leaf and composite states, including
+ * shallow and deep history, guards, actions and completion events.  Machines with orthogonal
+ * nodes still need a StateMachine.
+ *
+ * The actions and guards of a row are small types, see ROOST_STATIC_ACTION() and
+ * ROOST_STATIC_GUARD().  Like the ones given to addRow() they are called on the state that owns
+ * the row.
+ */
+
+/*!
+ * \brief ROOST_STATIC_ACTION declares an action type named type which calls fn(e) on the state
+ */
+#define ROOST_STATIC_ACTION(type, fn)                                        \
+    struct type                                                              \
+    {                                                                        \
+        static const char* name()                                            \
+        {                                                                    \
+            return ROOST_NAME_STRING(#fn);                                   \
+        }                                                                    \
+                                                                             \
+        template <typename STATE, typename CTX_TYPE, typename EVENT_TYPE>    \
+        void operator()(STATE& state, CTX_TYPE&, EVENT_TYPE const& e) const  \
+        {                                                                    \
+            state.fn(e);                                                     \
+        }                                                                    \
+    }
+
+/*!
+ * \brief ROOST_STATIC_GUARD declares a guard type named type which evaluates expr
+ *
+ * The expression can use state (the state that owns the row), ctx and e (the event).
+ */
+#define ROOST_STATIC_GUARD(type, expr)                                       \
+    struct type                                                              \
+    {                                                                        \
+        static const char* name()                                            \
+        {                                                                    \
+            return ROOST_NAME_STRING(#expr);                                 \
+        }                                                                    \
+                                                                             \
+        template <typename STATE, typename CTX_TYPE, typename EVENT_TYPE>    \
+        bool operator()(STATE& state, CTX_TYPE& ctx, EVENT_TYPE const& e) const \
+        {                                                                    \
+            (void)state;                                                     \
+            (void)ctx;                                                       \
+            (void)e;                                                         \
+            return (expr);                                                   \
+        }                                                                    \
+    }
+
+namespace roost
+{
+
+/*!
+ * \brief StaticState is the base of every state of a StaticMachine
+ *
+ * A state with an initial child is a composite state, otherwise it is a leaf.  Exactly one state
+ * has no parent (void), it is the root which the machine enters first.  Each state also needs a
+ * static name() function, and may hide onEntry() and onExit() with its own.
+ *
+ * \tparam Parent the parent state, void for the root
+ * \tparam Initial the initial child, void for a leaf
+ */
+template <typename Parent, typename Initial = void>
+struct StaticState
+{
+    using parent_type  = Parent;
+    using initial_type = Initial;
+
+    template <typename CTX>
+    void onEntry(CTX&)
+    {
+    }
+
+    template <typename CTX>
+    void onExit(CTX&)
+    {
+    }
+};  // Struct: StaticState
+
+//! Every state of a StaticMachine
+template <typename... S>
+struct StaticStates
+{
+};  // Struct: StaticStates
+
+//! The actions of a row, executed in order
+template <typename... A>
+struct StaticActions
+{
+};  // Struct: StaticActions
+
+//! The guard of a row without one, always passes
+struct StaticNoGuard
+{
+};  // Struct: StaticNoGuard
+
+//! The destination of a row which goes to the shallow history of S
+template <typename S>
+struct StaticShallowHistory
+{
+};  // Struct: StaticShallowHistory
+
+//! The destination of a row which goes to the deep history of S
+template <typename S>
+struct StaticDeepHistory
+{
+};  // Struct: StaticDeepHistory
+
+/*!
+ * \brief StaticRow is a row of the transition table of a StaticMachine
+ *
+ * \tparam Src the state which owns the row
+ * \tparam E the event enum class type
+ * \tparam ev the event handled by the row
+ * \tparam Dst the destination state, or void for a row without one
+ * \tparam Actions the actions, a StaticActions
+ * \tparam Guard the guard, StaticNoGuard for a row without one
+ */
+template <typename Src,
+          typename E,
+          E ev,
+          typename Dst,
+          typename Actions = StaticActions<>,
+          typename Guard   = StaticNoGuard>
+struct StaticRow
+{
+    using src_type     = Src;
+    using dst_type     = Dst;
+    using actions_type = Actions;
+    using guard_type   = Guard;
+
+    static constexpr E event()
+    {
+        return ev;
+    }
+};  // Struct: StaticRow
+
+//! The rows of a StaticMachine, a state checks its rows in this order
+template <typename... R>
+struct StaticTable
+{
+};  // Struct: StaticTable
+
+/*!
+ * \brief StaticNoSpy is the spy of a StaticMachine without one, every call compiles to nothing
+ *
+ * Any type with the member functions of Spy works as the spy of a StaticMachine, it is held by
+ * value so its calls don't go through the vtable.
+ */
+struct StaticNoSpy
+{
+    template <typename... Args>
+    void on_entry(Args const&...)
+    {
+    }
+
+    template <typename... Args>
+    void on_exit(Args const&...)
+    {
+    }
+
+    template <typename... Args>
+    void action(Args const&...)
+    {
+    }
+
+    template <typename... Args>
+    void guard(Args const&...)
+    {
+    }
+
+    template <typename... Args>
+    void event(Args const&...)
+    {
+    }
+
+    template <typename... Args>
+    void no_transition(Args const&...)
+    {
+    }
+
+    template <typename... Args>
+    void error(Args const&...)
+    {
+    }
+};  // Struct: StaticNoSpy
+
+namespace detail
+{
+
+//! The index of T in S, INVALID_NODE if it isn't one of them
+template <typename T, typename... S>
+struct IndexOf : std::integral_constant<core::NodeId, core::INVALID_NODE>
+{
+};
+
+template <typename T, typename... S>
+struct IndexOf<T, T, S...> : std::integral_constant<core::NodeId, 0>
+{
+};
+
+template <typename T, typename U, typename... S>
+struct IndexOf<T, U, S...>
+    : std::integral_constant<
+              core::NodeId,
+              IndexOf<T, S...>::value == core::INVALID_NODE ? core::INVALID_NODE
+                                                             : IndexOf<T, S...>::value + 1>
+{
+};
+
+template <bool... B>
+struct BoolPack
+{
+};
+
+//! True if every B is true
+template <bool... B>
+struct AllOf : std::is_same<BoolPack<true, B...>, BoolPack<B..., true>>
+{
+};
+
+//! Number of B which are true
+template <bool... B>
+struct CountOf : std::integral_constant<size_t, 0>
+{
+};
+
+template <bool First, bool... B>
+struct CountOf<First, B...> : std::integral_constant<size_t, First + CountOf<B...>::value>
+{
+};
+
+//! The state without a parent
+template <typename... S>
+struct RootOf
+{
+    using type = void;
+};
+
+template <typename First, typename... S>
+struct RootOf<First, S...>
+{
+    using type = typename std::conditional<std::is_void<typename First::parent_type>::value,
+                                           First,
+                                           typename RootOf<S...>::type>::type;
+};
+
+//! True if A is S or one of its ancestors, void (the top) contains every state
+template <typename A, typename S>
+struct Contains
+    : std::integral_constant<bool,
+                             std::is_same<A, S>::value ||
+                                     Contains<A, typename S::parent_type>::value>
+{
+};
+
+template <typename A>
+struct Contains<A, void> : std::is_void<A>
+{
+};
+
+//! The closest ancestor of or including A which contains D
+template <typename A, typename D>
+struct LcaFrom
+{
+    using Above = typename LcaFrom<typename A::parent_type, D>::type;
+    using type  = typename std::conditional<Contains<A, D>::value, A, Above>::type;
+};
+
+template <typename D>
+struct LcaFrom<void, D>
+{
+    using type = void;
+};
+
+/*!
+ * \brief Lca is the least common ancestor of a transition, see core::makeRoute()
+ *
+ * The LCA of a self transition is the parent, unless it goes to its own history.
+ */
+template <typename Src, typename Dst, bool history>
+struct Lca
+{
+    using type = typename LcaFrom<Src, Dst>::type;
+};
+
+template <typename S, bool history>
+struct Lca<S, S, history>
+{
+    using type = typename std::conditional<history, S, typename S::parent_type>::type;
+};
+
+//! Splits the destination of a row into the state and its history
+template <typename Dst>
+struct Target : std::integral_constant<core::History, core::History::NONE>
+{
+    using type = Dst;
+};
+
+template <typename S>
+struct Target<StaticShallowHistory<S>>
+    : std::integral_constant<core::History, core::History::SHALLOW>
+{
+    using type = S;
+};
+
+template <typename S>
+struct Target<StaticDeepHistory<S>> : std::integral_constant<core::History, core::History::DEEP>
+{
+    using type = S;
+};
+
+template <typename... T>
+struct TypeList
+{
+};
+
+}  // ns: detail
+
+/*!
+ * \brief StaticMachine runs a hierarchy and transition table given as types
+ *
+ * See the top of this file.  The interface follows StateMachine: init(), reset(), handleEvent(),
+ * forceTransitionTo() and getCurrentNodes() behave the same and make the same calls to the hooks
+ * and the spy.  The states are default constructed and owned by the machine, see getState().
+ *
+ * \tparam CTX the context type, passed to the hooks, actions and guards
+ * \tparam E the event enum class type
+ * \tparam States the states, a StaticStates
+ * \tparam Table the transition table, a StaticTable
+ * \tparam SPY the spy, StaticNoSpy for none
+ */
+template <typename CTX,
+          typename E,
+          typename States,
+          typename Table,
+          typename SPY = StaticNoSpy>
+class StaticMachine;
+
+template <typename CTX, typename E, typename... S, typename... R, typename SPY>
+class StaticMachine<CTX, E, StaticStates<S...>, StaticTable<R...>, SPY> final
+{
+private:
+    //! The id of state T is its index in S, void (the top) is INVALID_NODE
+    template <typename T>
+    using Id = detail::IndexOf<T, S...>;
+
+    using Root = typename detail::RootOf<S...>::type;
+
+    static_assert(sizeof...(S) > 0, "A StaticMachine needs states");
+    static_assert(detail::CountOf<std::is_void<typename S::parent_type>::value...>::value == 1,
+                  "Exactly one state must have no parent");
+    static_assert(detail::AllOf<(std::is_void<typename S::parent_type>::value ||
+                                 Id<typename S::parent_type>::value != core::INVALID_NODE)...>::
+                          value,
+                  "The parent of a state must be one of the states");
+    static_assert(detail::AllOf<(std::is_void<typename S::initial_type>::value ||
+                                 Id<typename S::initial_type>::value != core::INVALID_NODE)...>::
+                          value,
+                  "The initial child of a state must be one of the states");
+    static_assert(detail::AllOf<Id<typename R::src_type>::value != core::INVALID_NODE...>::value,
+                  "The state of a row must be one of the states");
+    static_assert(detail::AllOf<(std::is_void<typename R::dst_type>::value ||
+                                 Id<typename detail::Target<typename R::dst_type>::type>::value !=
+                                         core::INVALID_NODE)...>::value,
+                  "The destination of a row must be one of the states");
+
+    using HookFunction   = void (StaticMachine::*)();
+    using HandleFunction = bool (StaticMachine::*)(E const&);
+    using NameFunction   = const char* (*)();
+
+    const char*      m_name;  //!< The name of the machine
+    CTX&             m_ctx;   //!< The context passed to the states
+    SPY              m_spy;   //!< Held by value so the calls are direct
+    std::tuple<S...> m_states;
+
+    core::NodeId m_current;                    //!< The current state, INVALID_NODE if none
+    core::NodeId m_last_active[sizeof...(S)];  //!< The last active child of each state
+
+    RingFifo<E, ROOST_NO_HEAP_FIFO_SIZE> m_queue;  //!< Events fired while handling one
+
+    bool m_init;                          //!< True if successfully initialized
+    bool m_event_in_progress;             //!< True if handleEvent() hasn't exited
+    bool m_force_transition_in_progress;  //!< True if forceTransitionTo() hasn't exited
+
+public:
+    using CTX_TYPE   = CTX;
+    using EVENT_TYPE = E;
+
+    /*!
+     * \brief StaticMachine constructs the machine and its states
+     *
+     * After constructing the StaticMachine, init() still needs to be called.
+     *
+     * \param name the name of the machine
+     * \param ctx the context passed to the states
+     * \param spy the spy, copied into the machine
+     */
+    StaticMachine(const char* name, CTX& ctx, SPY spy = SPY())
+        : m_name(name),
+          m_ctx(ctx),
+          m_spy(spy),
+          m_states(),
+          m_current(core::INVALID_NODE),
+          m_last_active(),
+          m_queue(),
+          m_init(false),
+          m_event_in_progress(false),
+          m_force_transition_in_progress(false)
+    {
+    }
+
+    /*!
+     * \brief init enters the initial states and fires the completion event
+     *
+     * Unlike StateMachine::init() nothing can fail, the checks were done by the compiler.
+     *
+     * \return true
+     */
+    bool init()
+    {
+        priv_resetHistory();
+        m_current = core::INVALID_NODE;
+
+        priv_enter<Root>();
+        priv_construct<Root>(std::is_void<typename Root::initial_type>());
+        priv_complete();
+
+        m_init = true;
+        return m_init;
+    }
+
+    bool getInitStatus() const
+    {
+        return m_init;
+    }
+
+    /*!
+     * \brief reset returns the machine to its initial configuration, see StateMachine::reset()
+     *
+     * \param call_exit_hooks true to call onExit() (and the spy) on the states that are exited
+     * \return true if reset, otherwise false
+     */
+    bool reset(bool call_exit_hooks = true)
+    {
+
+        if (!m_init || m_event_in_progress || m_force_transition_in_progress)
+        {
+            return false;
+        }
+
+        m_force_transition_in_progress = true;
+
+        if (call_exit_hooks)
+        {
+            priv_exitTo(core::INVALID_NODE);
+        }
+
+        m_current                      = core::INVALID_NODE;
+        m_force_transition_in_progress = false;
+
+        // Anything the entry hooks or actions fire waits for the configuration to be complete
+        m_event_in_progress = true;
+
+        priv_resetHistory();
+
+        priv_enter<Root>();
+        priv_construct<Root>(std::is_void<typename Root::initial_type>());
+        priv_complete();
+        priv_drainQueue();
+
+        m_event_in_progress = false;
+
+        return true;
+    }
+
+    /*!
+     * \brief handleEvent takes an event and fires it into the machine, see
+     * StateMachine::handleEvent()
+     *
+     * \param e the event to fire into the machine
+     */
+    void handleEvent(E const& e)
+    {
+
+        if (!m_init || m_force_transition_in_progress)
+        {
+            return;
+        }
+
+        if (!m_queue.push(e))
+        {
+            m_spy.error(m_name, m_ctx, "Event queue is full", "");
+            return;
+        }
+
+        if (m_event_in_progress)
+        {
+            return;
+        }
+
+        m_event_in_progress = true;
+        priv_drainQueue();
+        m_event_in_progress = false;
+    }
+
+    /*!
+     * \brief forceTransitionTo forces the machine to transition to Dst, see
+     * StateMachine::forceTransitionTo()
+     *
+     * \tparam Dst the destination state
+     */
+    template <typename Dst>
+    void forceTransitionTo()
+    {
+        static_assert(Id<Dst>::value != core::INVALID_NODE, "Dst must be one of the states");
+
+        if (!m_init || m_event_in_progress || m_force_transition_in_progress)
+        {
+            return;
+        }
+
+        m_force_transition_in_progress = true;
+
+        using Lca = typename detail::Lca<Root, Dst, false>::type;
+
+        // Where the machine is isn't known at compile time, so exiting goes by id
+        priv_exitTo(Id<Lca>::value);
+        priv_enterPath<Lca, Dst>(std::is_same<Lca, Dst>());
+        priv_construct<Dst>(std::is_void<typename Dst::initial_type>());
+
+        m_force_transition_in_progress = false;
+    }
+
+    /*!
+     * \brief getCurrentNodes returns the name of the current state, see
+     * StateMachine::getCurrentNodes()
+     */
+    std::vector<std::string> getCurrentNodes() const
+    {
+        std::vector<std::string> rval;
+
+        if (!m_init || m_event_in_progress || m_force_transition_in_progress)
+        {
+            return rval;
+        }
+
+        static const NameFunction names[] = {&S::name...};
+
+        rval.push_back(names[m_current]());
+        return rval;
+    }
+
+    //! Returns the object of state T
+    template <typename T>
+    T& getState()
+    {
+        return std::get<Id<T>::value>(m_states);
+    }
+
+    //! Returns true if T is the current state
+    template <typename T>
+    bool isCurrent() const
+    {
+        return m_current == Id<T>::value;
+    }
+
+private:
+    //! Dispatches the event from the current state, returns true if it was handled
+    bool priv_handle(E const& e)
+    {
+        static const HandleFunction handlers[] = {&StaticMachine::priv_handleIn<S>...};
+
+        return (this->*handlers[m_current])(e);
+    }
+
+    //! Handles the events in the queue until it is empty, an event must be in progress
+    void priv_drainQueue()
+    {
+        while (!m_queue.empty())
+        {
+            E event = m_queue.front();
+            m_queue.pop_front();
+
+            if (!priv_handle(event))
+            {
+                m_spy.no_transition("Top", m_ctx, event);
+                continue;
+            }
+
+            priv_complete();
+        }
+    }
+
+    //! Fires completion events until none is handled
+    void priv_complete()
+    {
+        while (priv_handle(E::ROOST_NONE))
+        {
+        }
+    }
+
+    template <typename Cur>
+    bool priv_handleIn(E const& e)
+    {
+        return priv_dispatch<Cur, Cur>(e, std::false_type());
+    }
+
+    //! Asks A and then its ancestors for a row which handles e
+    template <typename Cur, typename A>
+    bool priv_dispatch(E const&, std::true_type)
+    {
+        return false;
+    }
+
+    template <typename Cur, typename A>
+    bool priv_dispatch(E const& e, std::false_type)
+    {
+        using Parent = typename A::parent_type;
+
+        return priv_tryRows<Cur, A>(e, detail::TypeList<R...>()) ||
+               priv_dispatch<Cur, Parent>(e, std::is_void<Parent>());
+    }
+
+    template <typename Cur, typename A>
+    bool priv_tryRows(E const&, detail::TypeList<>)
+    {
+        return false;
+    }
+
+    template <typename Cur, typename A, typename Row, typename... Rest>
+    bool priv_tryRows(E const& e, detail::TypeList<Row, Rest...>)
+    {
+        return priv_tryRow<Cur, Row>(e, std::is_same<typename Row::src_type, A>()) ||
+               priv_tryRows<Cur, A>(e, detail::TypeList<Rest...>());
+    }
+
+    template <typename Cur, typename Row>
+    bool priv_tryRow(E const&, std::false_type)
+    {
+        return false;
+    }
+
+    template <typename Cur, typename Row>
+    bool priv_tryRow(E const& e, std::true_type)
+    {
+        using Src = typename Row::src_type;
+
+        if (e != Row::event() || !priv_guard<Src>(e, typename Row::guard_type()))
+        {
+            return false;
+        }
+
+        m_spy.event(Src::name(), m_ctx, e);
+        priv_act<Src>(e, typename Row::actions_type());
+        priv_transition<Cur, Src, typename Row::dst_type>(std::is_void<typename Row::dst_type>());
+        return true;
+    }
+
+    template <typename Src>
+    bool priv_guard(E const&, StaticNoGuard)
+    {
+        return true;
+    }
+
+    template <typename Src, typename Guard>
+    bool priv_guard(E const& e, Guard guard)
+    {
+        bool rval = guard(getState<Src>(), m_ctx, e);
+        m_spy.guard(Src::name(), m_ctx, e, Guard::name(), rval);
+        return rval;
+    }
+
+    template <typename Src>
+    void priv_act(E const&, StaticActions<>)
+    {
+    }
+
+    template <typename Src, typename Action, typename... Rest>
+    void priv_act(E const& e, StaticActions<Action, Rest...>)
+    {
+        m_spy.action(Src::name(), m_ctx, e, Action::name());
+        Action()(getState<Src>(), m_ctx, e);
+        priv_act<Src>(e, StaticActions<Rest...>());
+    }
+
+    //! A row without a destination
+    template <typename Cur, typename Src, typename Dst>
+    void priv_transition(std::true_type)
+    {
+    }
+
+    /*!
+     * \brief priv_transition exits from Cur up to the LCA, then enters down to the destination
+     *
+     * Everything but the history is known at compile time and unrolled.
+     */
+    template <typename Cur, typename Src, typename Dst>
+    void priv_transition(std::false_type)
+    {
+        using Destination = detail::Target<Dst>;
+        using To          = typename Destination::type;
+        using Lca = typename detail::Lca<Src, To, Destination::value != core::History::NONE>::type;
+
+        priv_exitUntil<Lca, Cur>(std::is_same<Lca, Cur>());
+        priv_enterPath<Lca, To>(std::is_same<Lca, To>());
+        priv_enterTarget<To>(std::integral_constant<core::History, Destination::value>());
+    }
+
+    template <typename To>
+    void priv_enterTarget(std::integral_constant<core::History, core::History::NONE>)
+    {
+        priv_construct<To>(std::is_void<typename To::initial_type>());
+    }
+
+    template <typename To, core::History history>
+    void priv_enterTarget(std::integral_constant<core::History, history>)
+    {
+        static_assert(!std::is_void<typename To::initial_type>::value,
+                      "Only composite states have history");
+
+        priv_enterHistory(Id<To>::value, history);
+    }
+
+    template <typename Lca, typename Node>
+    void priv_exitUntil(std::true_type)
+    {
+    }
+
+    template <typename Lca, typename Node>
+    void priv_exitUntil(std::false_type)
+    {
+        using Parent = typename Node::parent_type;
+
+        priv_exit<Node>();
+        priv_exitUntil<Lca, Parent>(std::is_same<Lca, Parent>());
+    }
+
+    //! Exits from the current state until lca is the current state
+    void priv_exitTo(core::NodeId lca)
+    {
+        static const HookFunction exits[] = {&StaticMachine::priv_exit<S>...};
+
+        while (m_current != lca)
+        {
+            (this->*exits[m_current])();
+        }
+    }
+
+    template <typename Lca, typename Node>
+    void priv_enterPath(std::true_type)
+    {
+    }
+
+    template <typename Lca, typename Node>
+    void priv_enterPath(std::false_type)
+    {
+        using Parent = typename Node::parent_type;
+
+        priv_enterPath<Lca, Parent>(std::is_same<Lca, Parent>());
+        priv_enter<Node>();
+    }
+
+    //! Enters the initial children below Node
+    template <typename Node>
+    void priv_construct(std::true_type)
+    {
+    }
+
+    template <typename Node>
+    void priv_construct(std::false_type)
+    {
+        using Initial = typename Node::initial_type;
+
+        priv_enter<Initial>();
+        priv_construct<Initial>(std::is_void<typename Initial::initial_type>());
+    }
+
+    //! Enters the history of a composite state, see core::transition()
+    void priv_enterHistory(core::NodeId node, core::History history)
+    {
+        static const HookFunction  enters[] = {&StaticMachine::priv_enter<S>...};
+        static const core::NodeId  initial[] = {Id<typename S::initial_type>::value...};
+
+        m_spy.on_entry(core::historyName(history), m_ctx);
+        (this->*enters[m_last_active[node]])();
+
+        if (history == core::History::DEEP)
+        {
+            for (core::NodeId id = m_last_active[m_current]; id != core::INVALID_NODE;
+                 id              = m_last_active[id])
+            {
+                (this->*enters[id])();
+            }
+        }
+
+        for (core::NodeId id = initial[m_current]; id != core::INVALID_NODE; id = initial[id])
+        {
+            (this->*enters[id])();
+        }
+    }
+
+    template <typename Node>
+    void priv_enter()
+    {
+        m_spy.on_entry(Node::name(), m_ctx);
+        getState<Node>().onEntry(m_ctx);
+        m_current = Id<Node>::value;
+    }
+
+    template <typename Node>
+    void priv_exit()
+    {
+        using Parent = typename Node::parent_type;
+
+        m_spy.on_exit(Node::name(), m_ctx);
+        getState<Node>().onExit(m_ctx);
+        m_current = Id<Parent>::value;
+
+        if (m_current != core::INVALID_NODE)
+        {
+            m_last_active[m_current] = Id<Node>::value;
+        }
+    }
+
+    //! Composite states start out with their initial child as history
+    void priv_resetHistory()
+    {
+        static const core::NodeId initial[] = {Id<typename S::initial_type>::value...};
+
+        for (size_t i = 0; i < sizeof...(S); ++i)
+        {
+            m_last_active[i] = initial[i];
+        }
+    }
+
+};  // Class: StaticMachine
+
+/*!
+ * \brief StaticAlias shortens the names of the StaticMachine types for a context and event type
+ */
+template <typename CTX, typename E>
+class StaticAlias
+{
+public:
+    template <typename Parent, typename Initial = void>
+    using State = StaticState<Parent, Initial>;
+
+    template <typename Src,
+              E ev,
+              typename Dst,
+              typename Actions = StaticActions<>,
+              typename Guard   = StaticNoGuard>
+    using Row = StaticRow<Src, E, ev, Dst, Actions, Guard>;
+
+    template <typename States, typename Table, typename SPY = StaticNoSpy>
+    using Machine = StaticMachine<CTX, E, States, Table, SPY>;
+};  // Class: StaticAlias
+
+}  // ns: roost
+
+#endif  // ROOST_LIB_STATIC_MACHINE_HPP
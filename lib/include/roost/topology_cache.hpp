@@ -0,0 +1,124 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROOST_LIB_TOPOLOGY_CACHE_HPP
+#define ROOST_LIB_TOPOLOGY_CACHE_HPP
+
+#include "roost/alias.hpp"
+#include "roost/core.hpp"
+
+#include <string>
+#include <vector>
+
+namespace roost
+{
+namespace core
+{
+
+//! Bumped whenever the layout of a topology cache file changes
+const u32 TOPOLOGY_CACHE_VERSION = 3;
+
+//! Number of entries in RouteLog::keys for each route
+const size_t ROUTE_KEY_WORDS = 3;
+
+/*!
+ * \brief RouteLog records the routes made while the transition tables are created
+ *
+ * createTransitionTable() adds its rows in the same order on every run, so the routes can be
+ * saved next to the Topology and replayed instead of resolved again.  A route is only replayed if
+ * it was made for the same source, destination and history, otherwise the log is truncated at that
+ * point and recording starts over from there.
+ */
+struct RouteLog
+{
+    Vector<NodeId> keys;    //!< The src, dst and history passed to makeRoute(), ROUTE_KEY_WORDS each
+    Vector<Route>  routes;  //!< The routes in the order they were made
+    size_t         next;    //!< The next route to replay
+    bool           dirty;   //!< True if a route was made that wasn't replayed
+
+    explicit RouteLog(MemoryResource* resource = defaultResource())
+        : keys(resource), routes(resource), next(0), dirty(false)
+    {
+    }
+
+    void clear()
+    {
+        keys.clear();
+        routes.clear();
+        next  = 0;
+        dirty = false;
+    }
+};  // Struct: RouteLog
+
+/*!
+ * \brief makeRoute replays the next route of a log, or makes and records it on a miss
+ *
+ * See makeRoute(Topology const&, NodeId, NodeId, History).
+ */
+Route makeRoute(
+        Topology const& topology,
+        RouteLog&       log,
+        NodeId          src,
+        NodeId          dst,
+        History         history = History::NONE);
+
+/*!
+ * \brief hashTree assigns node ids to a tree and hashes its shape
+ *
+ * The ids are the same as the ones buildTopology() assigns, so a Topology loaded from a cache
+ * file that matches the hash can be used in its place.
+ *
+ * \param access the accessors of the typed tree
+ * \param top the Top region of the tree
+ * \param all_nodes filled with every node in the tree, indexed by id
+ * \return the FNV-1a hash of the type, children and initial child of every node
+ */
+u64 hashTree(TreeAccess const& access, void* top, Vector<void*>& all_nodes);
+
+/*!
+ * \brief saveTopologyCache writes a Topology and its RouteLog to a cache file
+ *
+ * The file is written next to path and then renamed over it, so a process loading the cache at
+ * the same time either sees the old file or the new one.
+ *
+ * \return true if saved, otherwise false
+ */
+bool saveTopologyCache(
+        std::string const& path,
+        u64                hash,
+        Topology const&    topology,
+        RouteLog const&    log);
+
+/*!
+ * \brief loadTopologyCache maps a cache file and loads the Topology and RouteLog it holds
+ *
+ * Nothing is loaded if the file is missing, was written by another version or byte order, was
+ * made for a different hash or node count, is truncated, doesn't match the hash of its contents,
+ * or doesn't describe a tree (see isWellFormed() in topology_cache.cpp).  Any of these is a miss,
+ * the caller builds the Topology again.
+ *
+ * \return true if loaded, otherwise false
+ */
+bool loadTopologyCache(
+        std::string const& path,
+        u64                hash,
+        size_t             node_count,
+        Topology&          topology,
+        RouteLog&          log);
+
+}  // ns: core
+
+}  // ns: roost
+
+#endif  // ROOST_LIB_TOPOLOGY_CACHE_HPP
@@ -16,39 +16,70 @@
 #define ROOST_LIB_TRANSITION_TABLE_HPP
 
 #include "roost/common.hpp"
+#include "roost/core.hpp"
+#include "roost/memory_resource.hpp"
+#include "roost/names.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <functional>  // std::function
+#include <iterator>
+#include <limits>
+#include <map>
+#include <new>
+#include <ostream>
+#include <utility>
 #include <vector>
 
-#define ROOST_ACTION(x)                                     \
-    roost::ActionFunctor<CTX_TYPE, EVENT_TYPE>(             \
-            [&, this](EVENT_TYPE const &e) {                \
-                if (m_spy)                                  \
-                {                                           \
-                    m_spy->action(getName(), m_ctx, e, #x); \
-                }                                           \
-                x(e);                                       \
-            },                                              \
-            #x)
-
-#define ROOST_GUARD(x)                                           \
-    roost::GuardFunctor<CTX_TYPE, EVENT_TYPE>(                   \
-            [&, this](EVENT_TYPE const &e) {                     \
-                bool rval = (x);                                 \
-                if (m_spy)                                       \
-                {                                                \
-                    m_spy->guard(getName(), m_ctx, e, #x, rval); \
-                }                                                \
-                return rval;                                     \
-            },                                                   \
-            #x)
+#define ROOST_ACTION(x)                                                     \
+    roost::ActionFunctor<CTX_TYPE, EVENT_TYPE>(                             \
+            [&, this](EVENT_TYPE const &e) {                                \
+                if (m_tracing)                                              \
+                {                                                           \
+                    m_spy->action(getName(), m_ctx, e, ROOST_NAME_STRING(#x)); \
+                }                                                           \
+                x(e);                                                       \
+            },                                                              \
+            ROOST_NAME(#x))
+
+#define ROOST_GUARD(x)                                                           \
+    roost::GuardFunctor<CTX_TYPE, EVENT_TYPE>(                                   \
+            [&, this](EVENT_TYPE const &e) {                                     \
+                bool rval = (x);                                                 \
+                if (m_tracing)                                                   \
+                {                                                                \
+                    m_spy->guard(getName(), m_ctx, e, ROOST_NAME_STRING(#x), rval); \
+                }                                                                \
+                return rval;                                                     \
+            },                                                                   \
+            ROOST_NAME(#x))
 
 #define ROOST_NO_ACTION \
     {                   \
     }
 
-#define ROOST_NO_GUARD \
-    roost::GuardFunctor<CTX_TYPE, EVENT_TYPE>([](EVENT_TYPE const &) { return true; }, nullptr)
+// A guard that only reads state no action can change while an event is dispatched, e.g.
+// ROOST_PURE_GUARD(m_open).  Its result is reused by the other rows of the node with the same
+// guard until the next dispatch, see StateMachine::pureGuardStats().
+#define ROOST_PURE_GUARD(x) roost::pureGuard(ROOST_GUARD(x))
+
+// A pure guard whose result is shared with every row, in any node, with the same tag, e.g.
+// ROOST_PURE_GUARD_TAG(LINK_UP_TAG, m_ctx.linkUp()).  The tag is a non-zero u32 picked by the
+// user, like the value of an event, and every guard with the tag must compute the same thing.
+#define ROOST_PURE_GUARD_TAG(tag, x) roost::pureGuard(ROOST_GUARD(x), (tag))
+
+// A guard over the flags of the context, passes if the flags under mask equal expected, e.g.
+// ROOST_FLAG_GUARD(LINK_UP | ARMED, LINK_UP) for "link up and not armed".  The rows of an event
+// with flag guards are tested all at once, without calling anything, see
+// StateMachine::setGuardFlags().  The spy isn't told about flag guards.
+#define ROOST_FLAG_GUARD(mask, expected)           \
+    roost::flagGuard<CTX_TYPE, EVENT_TYPE>(        \
+            (mask),                                \
+            (expected),                            \
+            ROOST_NAME("flags & " #mask " == " #expected))
+
+// An empty guard, the row is marked as unguarded and the guard is never called
+#define ROOST_NO_GUARD roost::GuardFunctor<CTX_TYPE, EVENT_TYPE>()
 
 #define ROOST_NO_DEST nullptr
 
@@ -58,91 +89,383 @@ namespace roost
 template <typename CTX, typename E, typename>
 class Node;
 
-template <typename CTX, typename E, typename>
-class RegionNode;
-
 template <typename CTX, typename E>
 using ActionFunctionPtr = std::function<void(E const &)>;
 
 template <typename CTX, typename E>
 using GuardFunctionPtr = std::function<bool(E const &)>;
 
+//! A word of flags owned by the context, tested by ROOST_FLAG_GUARD()
+using GuardFlags = u32;
+
+// The std::function in a functor only allocates if its target doesn't fit the small buffer, the
+// targets made by ROOST_ACTION and ROOST_GUARD capture little enough to fit
 template <typename CTX, typename E>
 struct ActionFunctor
 {
-    ActionFunctor(ActionFunctionPtr<CTX, E> &&action_fptr, const char *name) noexcept
+    ActionFunctor(ActionFunctionPtr<CTX, E> &&action_fptr, Name name) noexcept
         : m_action_fptr(std::move(action_fptr)), m_name(name)
     {
     }
 
+#ifdef ROOST_STRIP_NAMES
+    ActionFunctor(ActionFunctionPtr<CTX, E> &&action_fptr, const char *name) noexcept
+        : m_action_fptr(std::move(action_fptr)), m_name(makeName(name))
+    {
+    }
+#endif
+
     ActionFunctionPtr<CTX, E> m_action_fptr;
-    const char *              m_name;
+    Name                      m_name;
 };  // Class: ActionFunctor
 
 template <typename CTX, typename E>
 struct GuardFunctor
 {
 
-    GuardFunctor() : m_guard_fptr(nullptr), m_name(nullptr)
+    GuardFunctor()
+        : m_guard_fptr(nullptr),
+          m_name(NO_NAME),
+          m_pure(false),
+          m_pure_tag(0),
+          m_flag_mask(0),
+          m_flag_expected(0)
     {
     }
 
+    GuardFunctor(GuardFunctionPtr<CTX, E> &&guard_fptr, Name name) noexcept
+        : m_guard_fptr(std::move(guard_fptr)),
+          m_name(name),
+          m_pure(false),
+          m_pure_tag(0),
+          m_flag_mask(0),
+          m_flag_expected(0)
+    {
+    }
+
+#ifdef ROOST_STRIP_NAMES
     GuardFunctor(GuardFunctionPtr<CTX, E> &&guard_fptr, const char *name) noexcept
-        : m_guard_fptr(std::move(guard_fptr)), m_name(name)
+        : m_guard_fptr(std::move(guard_fptr)),
+          m_name(makeName(name)),
+          m_pure(false),
+          m_pure_tag(0),
+          m_flag_mask(0),
+          m_flag_expected(0)
     {
     }
+#endif
+
+    //! True if this is a flag guard, see flagGuard()
+    bool isFlagGuard() const
+    {
+        return !m_guard_fptr && m_flag_mask != 0;
+    }
 
     GuardFunctionPtr<CTX, E> m_guard_fptr;
-    const char *             m_name;
+    Name                     m_name;
+    bool                     m_pure;           //!< Its result can be reused, see pureGuard()
+    u32                      m_pure_tag;       //!< Shares the result across nodes if not 0
+    GuardFlags               m_flag_mask;      //!< The flags tested by a flag guard
+    GuardFlags               m_flag_expected;  //!< Their value for the flag guard to pass
 };  // Class: GuardFunctor
 
+/*!
+ * \brief flagGuard returns a guard which passes if the flags under mask equal expected
+ *
+ * See ROOST_FLAG_GUARD().  A mask of 0 is the same as having no guard.
+ */
+template <typename CTX, typename E>
+GuardFunctor<CTX, E> flagGuard(GuardFlags mask, GuardFlags expected, Name name)
+{
+    GuardFunctor<CTX, E> guard;
+    guard.m_name          = mask != 0 ? name : NO_NAME;
+    guard.m_flag_mask     = mask;
+    guard.m_flag_expected = expected;
+    return guard;
+}
+
+#ifdef ROOST_STRIP_NAMES
+template <typename CTX, typename E>
+GuardFunctor<CTX, E> flagGuard(GuardFlags mask, GuardFlags expected, const char *name)
+{
+    return flagGuard<CTX, E>(mask, expected, makeName(name));
+}
+#endif
+
+/*!
+ * \brief pureGuard marks a guard as pure, see ROOST_PURE_GUARD() and ROOST_PURE_GUARD_TAG()
+ *
+ * Without a tag the result is only shared by the rows of the node the guard is added to, which
+ * are matched up by the name of the guard, so unnamed guards without a tag are left as they are.
+ *
+ * \param guard the guard
+ * \param tag shares the result with the guards of every node with the same tag, 0 for none
+ */
+template <typename CTX, typename E>
+GuardFunctor<CTX, E> pureGuard(GuardFunctor<CTX, E> &&guard, u32 tag = 0)
+{
+    guard.m_pure     = guard.m_name != NO_NAME || tag != 0;
+    guard.m_pure_tag = guard.m_pure ? tag : 0;
+    return std::move(guard);
+}
+
+/*!
+ * \brief RowKind flags what taking a row involves, worked out once by the builder
+ *
+ * Combined in TransitionTableEntry::m_kind, so dispatching and taking a row only does the work
+ * its kind needs: an unguarded row never calls its guard, an internal row never looks at its
+ * route.
+ */
+enum RowKind : u8
+{
+    ROW_INTERNAL = 0,       //!< No guard, no actions and no destination
+    ROW_GUARDED  = 1 << 0,  //!< Has a guard to call
+    ROW_ACTIONS  = 1 << 1,  //!< Has actions to run
+    ROW_EXTERNAL = 1 << 2,  //!< Has a destination
+    ROW_HISTORY  = 1 << 3,  //!< Enters its destination from history
+    ROW_PURE     = 1 << 4,  //!< Its guard is pure, see ROOST_PURE_GUARD()
+    ROW_FLAGS    = 1 << 5   //!< Has a flag guard instead, see ROOST_FLAG_GUARD()
+};
+
+/*!
+ * \brief TransitionTableEntry is a single row of a transition table
+ *
+ * Rows are plain data, the actions and guard of a row are indices into the delegate arrays of the
+ * TransitionTable that owns it.
+ */
 template <typename CTX, typename E>
 struct TransitionTableEntry
 {
+    core::Route m_route;         //!< The node ids resolved by the core
+    u32         m_first_action;  //!< Index of the first action in TransitionTable::actions
+    u8          m_num_actions;   //!< Number of actions, executed in order
+    u8          m_kind;          //!< The RowKind flags of the row
+    u16         m_guard;         //!< Index of the guard in TransitionTable::guards
+};  // Struct: TransitionTableEntry
+
+/*!
+ * \brief TransitionTable is the compiled, read-only transition table of a node
+ *
+ * Everything lives in a single block laid out by TransitionTableBuilder::build(), events first:
+ * the events that have rows (sorted), the offsets of their rows, the rows, the flag guards of
+ * the rows (only if any row has one), the tags of the pure guards (only if any guard has one),
+ * the guards and actions of all rows, and finally the names which are only read for output.
+ *
+ * The flag guards are packed by row so the rows of an event are tested together, a row without
+ * one has a mask and expected value of 0, which always matches.
+ */
+template <typename CTX, typename E>
+struct TransitionTable
+{
+    E const *                           events;        //!< Every event with rows, sorted
+    u32 const *                         offsets;       //!< Rows of events[i] start at offsets[i]
+    TransitionTableEntry<CTX, E> const *rows;          //!< The rows of all events
+    GuardFunctionPtr<CTX, E> *          guards;        //!< The guards of all rows
+    ActionFunctionPtr<CTX, E> *         actions;       //!< The actions of all rows
+    u32                                 num_events;    //!< Number of events with rows
+    u32                                 num_rows;      //!< Number of rows (and guards)
+    u32                                 num_actions;   //!< Number of actions
+    Name const *                        guard_names;   //!< Name of each guard, may be NO_NAME
+    Name const *                        action_names;  //!< Name of each action
+    GuardFlags const *                  flag_masks;    //!< Of each row, nullptr if no flag guards
+    GuardFlags const *                  flag_expected; //!< Of each row, nullptr if no flag guards
+    u32 const *                         pure_tags;     //!< Of each guard, nullptr if no tags
+
+    TransitionTable()
+        : events(nullptr),
+          offsets(nullptr),
+          rows(nullptr),
+          guards(nullptr),
+          actions(nullptr),
+          num_events(0),
+          num_rows(0),
+          num_actions(0),
+          guard_names(nullptr),
+          action_names(nullptr),
+          flag_masks(nullptr),
+          flag_expected(nullptr),
+          pure_tags(nullptr)
+    {
+    }
+
+    /*!
+     * \brief bytes returns the size of the block of a table with the given counts
+     *
+     * Always a multiple of CACHE_LINE_SIZE, so blocks can be packed back to back.
+     */
+    static size_t bytes(
+            size_t num_events,
+            size_t num_rows,
+            size_t num_actions,
+            bool   flag_guards = false,
+            bool   pure_tags   = false)
+    {
+        return layout(num_events, num_rows, num_actions, flag_guards, pure_tags).bytes;
+    }
+
+    size_t bytes() const
+    {
+        return bytes(
+                num_events, num_rows, num_actions, flag_masks != nullptr, pure_tags != nullptr);
+    }
 
-    Node<CTX, E, void *> *             m_src;
-    RegionNode<CTX, E, void *> *       m_src_region;
-    Node<CTX, E, void *> *             m_destination;
-    std::vector<ActionFunctor<CTX, E>> m_actions;
-    GuardFunctor<CTX, E>               m_guard;
-    Node<CTX, E, void *> *             m_lca;
-    RegionNode<CTX, E, void *> *       m_lca_region;
+    //! The start of the block, nullptr if the table is empty
+    void *data() const
+    {
+        return const_cast<E *>(events);
+    }
+
+    //! Returns the rows of event e, the range is empty if there are none
+    std::pair<TransitionTableEntry<CTX, E> const *, TransitionTableEntry<CTX, E> const *> find(
+            E const &e) const
+    {
+        E const *it = std::lower_bound(events, events + num_events, e);
+
+        if (it == events + num_events || *it != e)
+        {
+            return {rows, rows};
+        }
+
+        size_t idx = it - events;
+        return {rows + offsets[idx], rows + offsets[idx + 1]};
+    }
+
+    //! Returns true if the guard of row passes for e and flags, rows without a guard always pass
+    bool passes(TransitionTableEntry<CTX, E> const &row, E const &e, GuardFlags flags) const
+    {
+        if (row.m_kind & ROW_FLAGS)
+        {
+            size_t i = &row - rows;
+            return (flags & flag_masks[i]) == flag_expected[i];
+        }
+
+        return !(row.m_kind & ROW_GUARDED) || guards[row.m_guard](e);
+    }
+
+    //! Destroys the delegates and empties the table, the block itself isn't freed
+    void destroy()
+    {
+        for (u32 i = 0; i < num_rows; ++i)
+        {
+            guards[i].~GuardFunctionPtr<CTX, E>();
+        }
+
+        for (u32 i = 0; i < num_actions; ++i)
+        {
+            actions[i].~ActionFunctionPtr<CTX, E>();
+        }
+
+        *this = TransitionTable();
+    }
+
+    //! Outputs every row as a SCXML transition, nodes is indexed by node id for the target names
+    void outputSCXML(std::ostream &os, Node<CTX, E, void *> *const *nodes) const
+    {
+
+        for (u32 i = 0; i < num_events; ++i)
+        {
+
+            for (u32 row = offsets[i]; row < offsets[i + 1]; ++row)
+            {
+                priv_outputSCXML(events[i], rows[row], os, nodes);
+            }
+        }
+    }
+
+    //! Offsets of each array from the start of the block
+    struct Layout
+    {
+        size_t offsets;
+        size_t rows;
+        size_t flags;
+        size_t tags;
+        size_t guards;
+        size_t actions;
+        size_t guard_names;
+        size_t action_names;
+        size_t bytes;
+    };  // Struct: Layout
+
+    static Layout layout(
+            size_t num_events,
+            size_t num_rows,
+            size_t num_actions,
+            bool   flag_guards = false,
+            bool   pure_tags   = false)
+    {
+        if (num_events == 0)
+        {
+            return Layout{0, 0, 0, 0, 0, 0, 0, 0, 0};
+        }
+
+        size_t at = num_events * sizeof(E);
+
+        // Returns where an array of count T starts, and moves past it
+        auto place = [&at](size_t count, size_t size, size_t alignment) -> size_t {
+            at          = (at + alignment - 1) / alignment * alignment;
+            size_t rval = at;
+            at += count * size;
+            return rval;
+        };
+
+        using Entry  = TransitionTableEntry<CTX, E>;
+        using Guard  = GuardFunctionPtr<CTX, E>;
+        using Action = ActionFunctionPtr<CTX, E>;
+
+        Layout l;
+        l.offsets      = place(num_events + 1, sizeof(u32), alignof(u32));
+        l.rows         = place(num_rows, sizeof(Entry), sizeof(Entry));
+        l.flags        = place(flag_guards ? 2 * num_rows : 0, sizeof(GuardFlags), alignof(u32));
+        l.tags         = place(pure_tags ? num_rows : 0, sizeof(u32), alignof(u32));
+        l.guards       = place(num_rows, sizeof(Guard), alignof(Guard));
+        l.actions      = place(num_actions, sizeof(Action), alignof(Action));
+        l.guard_names  = place(num_rows, sizeof(Name), alignof(Name));
+        l.action_names = place(num_actions, sizeof(Name), alignof(Name));
+        l.bytes        = place(0, 0, CACHE_LINE_SIZE);
+        return l;
+    }
 
-    void outputSCXML(E event, std::ostream &os)
+private:
+    void priv_outputSCXML(
+            E                                   event,
+            TransitionTableEntry<CTX, E> const &entry,
+            std::ostream &                      os,
+            Node<CTX, E, void *> *const *       nodes) const
     {
+        core::Route const &route = entry.m_route;
 
         os << "<transition type=\"internal\" event=\"" << getStringLiteral(event) << "\" ";
 
-        if (m_guard.m_name != nullptr)
+        if (guard_names[entry.m_guard] != NO_NAME)
         {
-            os << "cond=\"" << m_guard.m_name << "\" ";
+            os << "cond=\"" << nameString(guard_names[entry.m_guard]) << "\" ";
         }
 
-        if (m_destination != nullptr)
+        if (route.destination != core::INVALID_NODE)
         {
 
-            if ((m_destination->getType() == NodeType::SHALLOW_HISTORY_NODE) ||
-                m_destination->getType() == NodeType::DEEP_HISTORY_NODE)
+            if (route.history != core::History::NONE)
             {
-                os << "target=\"" << m_destination->getParent()->getName() << "."
-                   << m_destination->getName() << "\" ";
+                os << "target=\"" << nodes[route.destination]->getName() << "."
+                   << core::historyName(route.history) << "\" ";
             }
             else
             {
-                os << "target=\"" << m_destination->getName() << "\" ";
+                os << "target=\"" << nodes[route.destination]->getName() << "\" ";
             }
         }
 
         os << ">" << std::endl;
 
-        if (!m_actions.empty())
+        if (entry.m_num_actions != 0)
         {
 
             os << "<script>" << std::endl;
 
-            for (ActionFunctor<CTX, E> &action : m_actions)
+            for (u32 i = entry.m_first_action; i < entry.m_first_action + entry.m_num_actions;
+                 ++i)
             {
-                os << action.m_name << "(" << event << ");" << std::endl;
+                os << nameString(action_names[i]) << "(" << event << ");" << std::endl;
             }
 
             os << "</script>" << std::endl;
@@ -150,7 +473,254 @@ struct TransitionTableEntry
 
         os << "</transition>" << std::endl;
     }
-};
+};  // Struct: TransitionTable
+
+/*!
+ * \brief TransitionTableBuilder collects the rows of a node while its table is created
+ *
+ * Once every row is added, build() moves them into the single block of a TransitionTable.  The
+ * builder only needs to live until then.
+ */
+template <typename CTX, typename E>
+struct TransitionTableBuilder
+{
+    using Entries = core::Vector<TransitionTableEntry<CTX, E>>;
+    using RowMap  = std::map<
+            E,
+            Entries,
+            std::less<E>,
+            ResourceAllocator<std::pair<const E, Entries>>>;
+
+    RowMap                                  rows;          //!< The rows of each event
+    core::Vector<ActionFunctionPtr<CTX, E>> actions;       //!< The actions of all rows
+    core::Vector<GuardFunctionPtr<CTX, E>>  guards;        //!< The guards of all rows
+    core::Vector<Name>                      action_names;  //!< Name of each action
+    core::Vector<Name>                      guard_names;   //!< Name of each guard, may be NO_NAME
+    core::Vector<GuardFlags>                flag_masks;    //!< Flag guard mask of each row
+    core::Vector<GuardFlags>                flag_expected; //!< Flag guard value of each row
+    core::Vector<u32>                       pure_tags;     //!< Pure guard tag of each row
+    bool                                    flag_guards;   //!< True if any row has a flag guard
+    bool                                    tagged;        //!< True if any pure guard has a tag
+    bool                                    silent;        //!< True if row errors aren't reported
+
+    explicit TransitionTableBuilder(MemoryResource *resource = defaultResource())
+        : rows(resource),
+          actions(resource),
+          guards(resource),
+          action_names(resource),
+          guard_names(resource),
+          flag_masks(resource),
+          flag_expected(resource),
+          pure_tags(resource),
+          flag_guards(false),
+          tagged(false),
+          silent(false)
+    {
+    }
+
+    /*!
+     * \brief addRow appends a row for event e, moving the actions and guard into the builder
+     *
+     * \return false if the table ran out of indices for the row (or the row has more than 255
+     * actions), otherwise true
+     */
+    template <typename It>
+    bool addRow(
+            E const &              e,
+            core::Route const &    route,
+            It                     first,
+            It                     last,
+            GuardFunctor<CTX, E> &&guard)
+    {
+        size_t num_actions = std::distance(first, last);
+
+        if (guards.size() > std::numeric_limits<u16>::max() ||
+            num_actions > std::numeric_limits<u8>::max() ||
+            actions.size() + num_actions > std::numeric_limits<u32>::max())
+        {
+            return false;
+        }
+
+        TransitionTableEntry<CTX, E> entry;
+        entry.m_route        = route;
+        entry.m_first_action = static_cast<u32>(actions.size());
+        entry.m_num_actions  = static_cast<u8>(num_actions);
+        entry.m_kind         = ROW_INTERNAL;
+        entry.m_guard        = static_cast<u16>(guards.size());
+
+        if (guard.m_guard_fptr)
+        {
+            entry.m_kind |= guard.m_pure ? ROW_GUARDED | ROW_PURE : ROW_GUARDED;
+        }
+        else if (guard.isFlagGuard())
+        {
+            entry.m_kind |= ROW_FLAGS;
+            flag_guards = true;
+        }
+
+        if (num_actions != 0)
+        {
+            entry.m_kind |= ROW_ACTIONS;
+        }
+
+        if (route.destination != core::INVALID_NODE)
+        {
+            entry.m_kind |= ROW_EXTERNAL;
+        }
+
+        if (route.history != core::History::NONE)
+        {
+            entry.m_kind |= ROW_HISTORY;
+        }
+
+        for (; first != last; ++first)
+        {
+            actions.push_back(std::move(first->m_action_fptr));
+            action_names.push_back(first->m_name);
+        }
+
+        guards.push_back(std::move(guard.m_guard_fptr));
+        guard_names.push_back(guard.m_name);
+        flag_masks.push_back(guard.m_flag_mask);
+        flag_expected.push_back(guard.m_flag_expected);
+        pure_tags.push_back(guard.m_pure_tag);
+        tagged = tagged || guard.m_pure_tag != 0;
+
+        auto it = rows.find(e);
+
+        if (it == rows.end())
+        {
+            // New Entry
+            it = rows.insert({e, Entries(rows.get_allocator())}).first;
+        }
+
+        it->second.push_back(entry);
+        return true;
+    }
+
+    //! The size of the block build() needs
+    size_t bytes() const
+    {
+        return TransitionTable<CTX, E>::bytes(
+                rows.size(), guards.size(), actions.size(), flag_guards, tagged);
+    }
+
+    /*!
+     * \brief build moves the rows into memory and returns the table over it
+     *
+     * The rows are ordered by event and then by the order they were added, a row keeps the
+     * index of its guard and actions.
+     *
+     * \param memory a block of at least bytes(), aligned to CACHE_LINE_SIZE
+     */
+    TransitionTable<CTX, E> build(void *memory)
+    {
+        TransitionTable<CTX, E> table;
+
+        if (rows.empty())
+        {
+            return table;
+        }
+
+        auto l = TransitionTable<CTX, E>::layout(
+                rows.size(), guards.size(), actions.size(), flag_guards, tagged);
+        char *base = static_cast<char *>(memory);
+
+        using Entry  = TransitionTableEntry<CTX, E>;
+        using Guard  = GuardFunctionPtr<CTX, E>;
+        using Action = ActionFunctionPtr<CTX, E>;
+
+        E *           events       = reinterpret_cast<E *>(base);
+        u32 *         offsets      = reinterpret_cast<u32 *>(base + l.offsets);
+        Entry *       entries      = reinterpret_cast<Entry *>(base + l.rows);
+        Guard *       guard_fptrs  = reinterpret_cast<Guard *>(base + l.guards);
+        Action *      action_fptrs = reinterpret_cast<Action *>(base + l.actions);
+        Name *        g_names      = reinterpret_cast<Name *>(base + l.guard_names);
+        Name *        a_names      = reinterpret_cast<Name *>(base + l.action_names);
+        GuardFlags *  masks        = reinterpret_cast<GuardFlags *>(base + l.flags);
+        GuardFlags *  expected     = masks + guards.size();
+        u32 *         tags         = reinterpret_cast<u32 *>(base + l.tags);
+
+        u32 num_events = 0;
+        u32 num_rows   = 0;
+
+        for (auto const &event_rows : rows)
+        {
+            events[num_events]  = event_rows.first;
+            offsets[num_events] = num_rows;
+
+            for (Entry const &entry : event_rows.second)
+            {
+                if (flag_guards)
+                {
+                    // Packed in the order of the rows, not in the order they were added
+                    masks[num_rows]    = flag_masks[entry.m_guard];
+                    expected[num_rows] = flag_expected[entry.m_guard];
+                }
+
+                entries[num_rows++] = entry;
+            }
+
+            ++num_events;
+        }
+
+        offsets[num_events] = num_rows;
+
+        for (size_t i = 0; i < guards.size(); ++i)
+        {
+            new (guard_fptrs + i) Guard(std::move(guards[i]));
+            g_names[i] = guard_names[i];
+
+            if (tagged)
+            {
+                tags[i] = pure_tags[i];
+            }
+        }
+
+        for (size_t i = 0; i < actions.size(); ++i)
+        {
+            new (action_fptrs + i) Action(std::move(actions[i]));
+            a_names[i] = action_names[i];
+        }
+
+        table.events       = events;
+        table.offsets      = offsets;
+        table.rows         = entries;
+        table.guards       = guard_fptrs;
+        table.actions      = action_fptrs;
+        table.num_events   = num_events;
+        table.num_rows     = num_rows;
+        table.num_actions  = static_cast<u32>(actions.size());
+        table.guard_names  = g_names;
+        table.action_names = a_names;
+
+        if (flag_guards)
+        {
+            table.flag_masks    = masks;
+            table.flag_expected = expected;
+        }
+
+        if (tagged)
+        {
+            table.pure_tags = tags;
+        }
+
+        return table;
+    }
+};  // Struct: TransitionTableBuilder
+
+/*!
+ * \brief SelectedTransition is a row picked to handle an event, along with its table
+ */
+template <typename CTX, typename E>
+struct SelectedTransition
+{
+    TransitionTableEntry<CTX, E> const *row;    //!< The row whose guard passed
+    TransitionTable<CTX, E> const *     table;  //!< The table of the row, nullptr if not in one
+};  // Struct: SelectedTransition
+
+template <typename CTX, typename E>
+using TransitionList = core::Vector<SelectedTransition<CTX, E>>;
 
 }  // ns: roost
 
@@ -0,0 +1,801 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "roost/core.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ROOST_SSE2
+#endif
+
+namespace roost
+{
+namespace core
+{
+
+namespace
+{
+
+//! A node waiting to be visited by buildTopology()
+struct Pending
+{
+    void*  node;    //!< The node to visit
+    NodeId parent;  //!< The id of its parent
+    u32    slot;    //!< Where the id of the node goes in the children of its parent
+};  // Struct: Pending
+
+bool isRecordingType(NodeType type)
+{
+    // Only composite nodes and regions remember their last active child
+    return type == NodeType::COMPOSITE_NODE || type == NodeType::REGION;
+}
+
+void recordLastVisited(Topology const& topology, Runtime& runtime, NodeId node, NodeId child)
+{
+    // Most nodes are never the target of a history transition, see markHistory()
+    if (topology.records_history[node])
+    {
+        runtime.last_active[node] = child;
+    }
+}
+
+void constructRegions(
+        Topology const& topology,
+        Runtime&        runtime,
+        Hooks const&    hooks,
+        NodeId          orthogonal_node,
+        NodeId          skip)
+{
+    const NodeId* end = topology.childrenEnd(orthogonal_node);
+
+    for (const NodeId* it = topology.childrenBegin(orthogonal_node); it != end; ++it)
+    {
+        // Skip the one that we are personally handling
+        if (*it == skip)
+        {
+            continue;
+        }
+
+        // Enforced by init(), all children of orthogonal nodes are regions
+        construct(topology, runtime, hooks, *it);
+    }
+}
+
+void enter(Runtime& runtime, Hooks const& hooks, NodeId region, NodeId node)
+{
+    hooks.on_entry(hooks.ctx, node);
+    runtime.current[region] = node;
+}
+
+void buildLcaIndex(Topology& topology)
+{
+    size_t n = topology.size();
+
+    // Enough rows to lift any node by up to max_depth - 1
+    u32 levels{1};
+
+    while ((size_t(1) << levels) < topology.max_depth)
+    {
+        ++levels;
+    }
+
+    topology.lca_levels = levels;
+    topology.ancestors.resize(levels * n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        NodeId parent         = topology.parent[i];
+        topology.ancestors[i] = parent == INVALID_NODE ? static_cast<NodeId>(i) : parent;
+    }
+
+    for (u32 k = 1; k < levels; ++k)
+    {
+        NodeId*       row      = &topology.ancestors[k * n];
+        const NodeId* prev_row = &topology.ancestors[(k - 1) * n];
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            row[i] = prev_row[prev_row[i]];
+        }
+    }
+}
+
+//! Visits the current nodes that are depth orthogonal nodes below region, true if there were any
+bool visitCurrentNodes(
+        Topology const& topology,
+        Runtime const&  runtime,
+        NodeId          region,
+        u32             depth,
+        NodeVisitor     visit,
+        void*           user)
+{
+    NodeId node = runtime.current[region];
+
+    if (depth == 0)
+    {
+        visit(user, node);
+        return true;
+    }
+
+    if (topology.type[node] != NodeType::ORTHOGONAL_NODE)
+    {
+        return false;
+    }
+
+    bool          found{false};
+    const NodeId* end = topology.childrenEnd(node);
+
+    for (const NodeId* it = topology.childrenBegin(node); it != end; ++it)
+    {
+        found = visitCurrentNodes(topology, runtime, *it, depth - 1, visit, user) || found;
+    }
+
+    return found;
+}
+
+}  // ns: anonymous
+
+void flatten(TreeAccess const& access, void* node, std::vector<void*>& all_nodes)
+{
+    if (!node)
+    {
+        return;
+    }
+
+    std::vector<void*> stack{node};
+
+    while (!stack.empty())
+    {
+        node = stack.back();
+        stack.pop_back();
+
+        all_nodes.push_back(node);
+
+        // Pushed in reverse so that the children are visited in declaration order
+        for (size_t i = access.num_children(node); i-- > 0;)
+        {
+            stack.push_back(access.child(node, i));
+        }
+    }
+}
+
+size_t maxDepth(TreeAccess const& access, void* node, size_t depth)
+{
+    if (!node)
+    {
+        return depth;
+    }
+
+    size_t                                max_depth{depth};
+    std::vector<std::pair<void*, size_t>> stack{{node, depth}};
+
+    while (!stack.empty())
+    {
+        std::pair<void*, size_t> current = stack.back();
+        stack.pop_back();
+
+        max_depth = std::max(max_depth, current.second);
+
+        for (size_t i = access.num_children(current.first); i-- > 0;)
+        {
+            stack.push_back({access.child(current.first, i), current.second + 1});
+        }
+    }
+
+    return max_depth;
+}
+
+void* findLca(TreeAccess const& access, void* src, void* dst)
+{
+    if (src == nullptr || dst == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (src == dst)
+    {
+        // This is a special case, we want to set the LCA
+        // to the parent to make sure our generic algorithm works
+        return access.parent(src);
+    }
+
+    void* original_src = src;
+
+    while (dst != nullptr)
+    {
+        while (src != nullptr)
+        {
+            if (src == dst)
+            {
+                return src;
+            }
+
+            src = access.parent(src);
+        }
+
+        dst = access.parent(dst);
+        src = original_src;
+    }
+
+    // Shouldn't happen
+    return nullptr;
+}
+
+NodeId findLca(Topology const& topology, NodeId src, NodeId dst)
+{
+    if (src == INVALID_NODE || dst == INVALID_NODE)
+    {
+        return INVALID_NODE;
+    }
+
+    if (src == dst)
+    {
+        // Same special case as the pointer version, the LCA of a self transition is the parent
+        return topology.parent[src];
+    }
+
+    if (topology.depth[src] < topology.depth[dst])
+    {
+        std::swap(src, dst);
+    }
+
+    // Lift the deeper node to the depth of the other one
+    u32 diff = topology.depth[src] - topology.depth[dst];
+
+    for (u32 k = 0; diff != 0; ++k, diff >>= 1)
+    {
+        if (diff & 1)
+        {
+            src = topology.ancestor(k, src);
+        }
+    }
+
+    // One was the ancestor of the other
+    if (src == dst)
+    {
+        return src;
+    }
+
+    for (u32 k = topology.lca_levels; k-- > 0;)
+    {
+        NodeId src_up = topology.ancestor(k, src);
+        NodeId dst_up = topology.ancestor(k, dst);
+
+        if (src_up != dst_up)
+        {
+            src = src_up;
+            dst = dst_up;
+        }
+    }
+
+    return topology.parent[src];
+}
+
+void buildTopology(
+        TreeAccess const& access,
+        void*             top,
+        Vector<void*>&    all_nodes,
+        Topology&         topology)
+{
+    // Clearing keeps the storage of a previous init()
+    all_nodes.clear();
+    topology.parent.clear();
+    topology.initial_child.clear();
+    topology.type.clear();
+    topology.region.clear();
+    topology.level.clear();
+    topology.child_offsets.clear();
+    topology.children.clear();
+    topology.depth.clear();
+    topology.records_history.clear();
+    topology.max_depth         = 0;
+    topology.number_of_regions = 0;
+
+    Vector<Pending> stack(all_nodes.get_allocator());
+    stack.push_back({top, INVALID_NODE, 0});
+
+    // A single pre-order walk, so every parent is resolved before its children
+    while (!stack.empty())
+    {
+        Pending pending = stack.back();
+        stack.pop_back();
+
+        void*    node   = pending.node;
+        NodeId   id     = static_cast<NodeId>(all_nodes.size());
+        NodeId   parent = pending.parent;
+        NodeType type   = access.type(node);
+        u32      depth  = parent == INVALID_NODE ? 1 : topology.depth[parent] + 1;
+
+        access.set_id(node, id);
+        all_nodes.push_back(node);
+
+        topology.parent.push_back(parent);
+        topology.initial_child.push_back(INVALID_NODE);
+        topology.type.push_back(type);
+        topology.depth.push_back(depth);
+        topology.records_history.push_back(0);
+
+        if (type == NodeType::REGION)
+        {
+            // The level of a region is its depth, so the Top region is level 1
+            topology.region.push_back(id);
+            topology.level.push_back(depth);
+            ++topology.number_of_regions;
+        }
+        else
+        {
+            topology.region.push_back(parent == INVALID_NODE ? id : topology.region[parent]);
+            topology.level.push_back(0);
+        }
+
+        topology.max_depth = std::max(topology.max_depth, static_cast<size_t>(depth));
+
+        if (parent != INVALID_NODE)
+        {
+            topology.children[pending.slot] = id;
+
+            // An initial child that isn't a direct child is left unset, init() will report that
+            if (access.initial_child(all_nodes[parent]) == node)
+            {
+                topology.initial_child[parent] = id;
+            }
+        }
+
+        // Nodes are visited in id order, so the children of each node get contiguous slots that
+        // are filled in as the children are visited
+        u32    first_slot   = static_cast<u32>(topology.children.size());
+        size_t num_children = access.num_children(node);
+
+        topology.child_offsets.push_back(first_slot);
+        topology.children.resize(first_slot + num_children, INVALID_NODE);
+
+        // Pushed in reverse so that the children are visited in declaration order
+        for (size_t i = num_children; i-- > 0;)
+        {
+            stack.push_back({access.child(node, i), id, static_cast<u32>(first_slot + i)});
+        }
+    }
+
+    topology.child_offsets.push_back(static_cast<u32>(topology.children.size()));
+
+    buildLcaIndex(topology);
+}
+
+const char* historyName(History history)
+{
+    switch (history)
+    {
+    case History::SHALLOW:
+        return "ShallowHistory";
+    case History::DEEP:
+        return "DeepHistory";
+    default:
+        return "";
+    }
+}
+
+Route makeRoute(Topology const& topology, NodeId src, NodeId dst, History history)
+{
+    Route route;
+    route.src         = src;
+    route.destination = dst;
+    route.history     = history;
+
+    // The history is a child of dst in all but name, so dst is the LCA of a transition from dst
+    route.lca = (history != History::NONE && src == dst) ? dst : findLca(topology, src, dst);
+
+    // If destination is INVALID_NODE then it is an internal transition and
+    // lca will also be INVALID_NODE
+
+    if (route.lca != INVALID_NODE)
+    {
+        if (topology.type[route.lca] == NodeType::ORTHOGONAL_NODE)
+        {
+            // A transition that has an LCA of an orthogonal node will be transformed so that
+            // the orthogonal regions are exited and then default entered
+
+            route.src         = route.lca;
+            route.destination = route.lca;
+            route.history     = History::NONE;
+
+            // Force the LCA to be parent of "real" LCA so that our algorithm will call
+            // On exit and then on entry of "real" LCA
+
+            route.lca = topology.parent[route.lca];
+        }
+
+        route.lca_region = topology.region[route.lca];
+    }
+    else
+    {
+        route.lca_region = INVALID_NODE;
+    }
+
+    // Important we do this after the orthogonal node lca check above
+    // because we could change the src field in the route
+    route.src_region = topology.region[route.src];
+
+    return route;
+}
+
+void markHistory(Topology& topology, NodeId node, History history)
+{
+    if (history == History::NONE)
+    {
+        return;
+    }
+
+    topology.records_history[node] = 1;
+
+    if (history == History::DEEP)
+    {
+        // Nodes are numbered in pre-order, so the descendants of node directly follow it
+        for (size_t i = node + 1; i < topology.size() && topology.depth[i] > topology.depth[node];
+             ++i)
+        {
+            topology.records_history[i] = isRecordingType(topology.type[i]);
+        }
+    }
+}
+
+void markAllHistory(Topology& topology)
+{
+    for (size_t i = 0; i < topology.size(); ++i)
+    {
+        topology.records_history[i] = isRecordingType(topology.type[i]);
+    }
+}
+
+void reset(Topology const& topology, Runtime& runtime)
+{
+    size_t n = topology.size();
+
+    runtime.current.resize(n);
+    runtime.last_active.resize(n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        runtime.current[i] = static_cast<NodeId>(i);
+
+        // Composite nodes and regions start out with their initial child as history
+        runtime.last_active[i] =
+                isRecordingType(topology.type[i]) ? topology.initial_child[i] : INVALID_NODE;
+    }
+
+    // The maximum number of onEntry() calls will be the max depth of the tree
+    runtime.entry_path.clear();
+    runtime.entry_path.reserve(topology.max_depth);
+}
+
+void construct(Topology const& topology, Runtime& runtime, Hooks const& hooks, NodeId region)
+{
+    NodeId current_node = topology.initial_child[runtime.current[region]];
+
+    while (current_node != INVALID_NODE)
+    {
+        enter(runtime, hooks, region, current_node);
+
+        if (topology.type[current_node] == NodeType::ORTHOGONAL_NODE)
+        {
+            constructRegions(topology, runtime, hooks, current_node, INVALID_NODE);
+            return;
+        }
+
+        current_node = topology.initial_child[current_node];
+    }
+}
+
+void constructFromDeepHistory(
+        Topology const& topology,
+        Runtime&        runtime,
+        Hooks const&    hooks,
+        NodeId          region)
+{
+    NodeId current_node = runtime.current[region];
+
+    while (current_node != INVALID_NODE)
+    {
+        if (topology.type[current_node] == NodeType::ORTHOGONAL_NODE)
+        {
+            // Orthogonal nodes have no last active child, instead activate their regions
+            const NodeId* end = topology.childrenEnd(current_node);
+
+            for (const NodeId* it = topology.childrenBegin(current_node); it != end; ++it)
+            {
+                constructFromDeepHistory(topology, runtime, hooks, *it);
+            }
+
+            return;
+        }
+
+        current_node = runtime.last_active[current_node];
+
+        if (current_node != INVALID_NODE)
+        {
+            enter(runtime, hooks, region, current_node);
+        }
+    }
+}
+
+void destructUntil(
+        Topology const& topology,
+        Runtime&        runtime,
+        Hooks const&    hooks,
+        NodeId          region,
+        NodeId          node)
+{
+    while (runtime.current[region] != node)
+    {
+        NodeId current_node = runtime.current[region];
+
+        if (topology.type[current_node] == NodeType::ORTHOGONAL_NODE)
+        {
+            const NodeId* end = topology.childrenEnd(current_node);
+
+            for (const NodeId* it = topology.childrenBegin(current_node); it != end; ++it)
+            {
+                destructUntil(topology, runtime, hooks, *it, *it);
+            }
+        }
+
+        hooks.on_exit(hooks.ctx, current_node);
+
+        NodeId parent           = topology.parent[current_node];
+        runtime.current[region] = parent;
+
+        // Save the last active child of the region and inform the composite state of it too
+        recordLastVisited(topology, runtime, region, current_node);
+        recordLastVisited(topology, runtime, parent, current_node);
+    }
+}
+
+bool selectTransition(Topology const& topology, u32& current_level, Route const& route)
+{
+    if (route.lca_region == INVALID_NODE)
+    {
+        return true;
+    }
+
+    // The lower the level, the close it is to top (which has a level of 1)
+    u32 lca_level = topology.level[route.lca_region];
+
+    // If it is zero, then it isn't set (The lowest is 1 for the top region)
+    // Set the level and then continue with the current transition
+    if (current_level == 0)
+    {
+        current_level = lca_level;
+    }
+    // Otherwise we have to do a check on the transition
+    else if (current_level < topology.level[route.src_region])
+    {
+        return false;
+    }
+
+    if (lca_level < current_level)
+    {
+        current_level = lca_level;
+    }
+
+    return true;
+}
+
+void transition(Topology const& topology, Runtime& runtime, Hooks const& hooks, Route const& route)
+{
+    destructUntil(topology, runtime, hooks, route.lca_region, route.lca);
+
+    Vector<NodeId>& path = runtime.entry_path;
+    path.clear();
+
+    for (NodeId tmp = route.destination; tmp != route.lca; tmp = topology.parent[tmp])
+    {
+        path.push_back(tmp);
+    }
+
+    NodeId current_region = route.lca_region;
+
+    for (auto it = path.rbegin(); it != path.rend(); ++it)
+    {
+        NodeId current_node = *it;
+
+        // Because we are forcing our way through nodes, we have to call our hooks here
+        // but not on regions themselves
+        enter(runtime, hooks, current_region, current_node);
+
+        NodeType type = topology.type[current_node];
+
+        if (type == NodeType::ORTHOGONAL_NODE)
+        {
+            ++it;
+
+            // If the transition ends at the orthogonal node, then we still have to
+            // initialize the children of the orthogonal node
+            if (it == path.rend())
+            {
+                constructRegions(topology, runtime, hooks, current_node, INVALID_NODE);
+
+                // We need a break here because otherwise the iterator won't exit the for-loop
+                break;
+            }
+
+            ROOST_ASSERT(topology.type[*it] == NodeType::REGION);
+
+            current_region = *it;
+            constructRegions(topology, runtime, hooks, current_node, current_region);
+        }
+    }
+
+    if (route.history != History::NONE)
+    {
+        // Only composite states have history, and the composite state was just entered (or was
+        // the LCA) so it is the current node of current_region
+        ROOST_ASSERT(topology.type[route.destination] == NodeType::COMPOSITE_NODE);
+
+        NodeId next_target = runtime.last_active[route.destination];
+
+        // We simply call the on entry of the last node for history
+        hooks.on_history(hooks.ctx, route.destination, route.history);
+        enter(runtime, hooks, current_region, next_target);
+
+        if (route.history == History::DEEP)
+        {
+            constructFromDeepHistory(topology, runtime, hooks, current_region);
+        }
+        else if (topology.type[next_target] == NodeType::ORTHOGONAL_NODE)
+        {
+            constructRegions(topology, runtime, hooks, next_target, INVALID_NODE);
+        }
+    }
+
+    // We want to make sure we "drill down" after finalizing the transition
+    // after all we could have ended up in a new region
+    construct(topology, runtime, hooks, current_region);
+}
+
+void flattenTransition(
+        Topology const& topology,
+        NodeId          current,
+        Route const&    route,
+        Vector<NodeId>& steps,
+        u32&            num_exits,
+        u32&            num_entries)
+{
+    size_t first = steps.size();
+
+    num_exits   = 0;
+    num_entries = 0;
+
+    if (route.destination == INVALID_NODE)
+    {
+        return;
+    }
+
+    // Same order as destructUntil()
+    for (NodeId node = current; node != route.lca; node = topology.parent[node])
+    {
+        steps.push_back(node);
+    }
+
+    num_exits = static_cast<u32>(steps.size() - first);
+
+    // The path down from the LCA, built backwards
+    for (NodeId node = route.destination; node != route.lca; node = topology.parent[node])
+    {
+        steps.push_back(node);
+    }
+
+    std::reverse(steps.begin() + first + num_exits, steps.end());
+
+    // And the initial children below the destination, same as construct()
+    for (NodeId node = topology.initial_child[route.destination]; node != INVALID_NODE;
+         node        = topology.initial_child[node])
+    {
+        steps.push_back(node);
+    }
+
+    num_entries = static_cast<u32>(steps.size() - first - num_exits);
+}
+
+void runSteps(
+        Topology const& topology,
+        Runtime&        runtime,
+        Hooks const&    hooks,
+        NodeId const*   exits,
+        u32             num_exits,
+        NodeId const*   entries,
+        u32             num_entries)
+{
+    for (u32 i = 0; i < num_exits; ++i)
+    {
+        NodeId node   = exits[i];
+        NodeId parent = topology.parent[node];
+
+        hooks.on_exit(hooks.ctx, node);
+        runtime.current[TOP_NODE] = parent;
+
+        recordLastVisited(topology, runtime, TOP_NODE, node);
+        recordLastVisited(topology, runtime, parent, node);
+    }
+
+    for (u32 i = 0; i < num_entries; ++i)
+    {
+        enter(runtime, hooks, TOP_NODE, entries[i]);
+    }
+}
+
+u32 matchFlags(u32 flags, u32 const* masks, u32 const* expected, u32 count)
+{
+    u32 matches = 0;
+    u32 i       = 0;
+
+#ifdef ROOST_SSE2
+    __m128i const all = _mm_set1_epi32(static_cast<int>(flags));
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i m  = _mm_loadu_si128(reinterpret_cast<__m128i const*>(masks + i));
+        __m128i e  = _mm_loadu_si128(reinterpret_cast<__m128i const*>(expected + i));
+        __m128i eq = _mm_cmpeq_epi32(_mm_and_si128(all, m), e);
+
+        // One bit per lane
+        matches |= static_cast<u32>(_mm_movemask_ps(_mm_castsi128_ps(eq))) << i;
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        if ((flags & masks[i]) == expected[i])
+        {
+            matches |= u32{1} << i;
+        }
+    }
+
+    return matches;
+}
+
+u32 lowestBit(u32 bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<u32>(__builtin_ctz(bits));
+#else
+    u32 i = 0;
+
+    while (!(bits & 1))
+    {
+        bits >>= 1;
+        ++i;
+    }
+
+    return i;
+#endif
+}
+
+void currentNodes(
+        Topology const& topology,
+        Runtime const&  runtime,
+        NodeId          region,
+        NodeVisitor     visit,
+        void*           user)
+{
+    // Breadth first without a queue, one level of orthogonal nodes at a time
+    for (u32 depth = 0; visitCurrentNodes(topology, runtime, region, depth, visit, user); ++depth)
+    {
+    }
+}
+
+}  // ns: core
+
+}  // ns: roost
@@ -0,0 +1,105 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include "roost/memory_report.hpp"
+
+#include <cstdio>
+
+namespace roost
+{
+
+namespace
+{
+
+const char* typeName(NodeType type)
+{
+    switch (type)
+    {
+    case NodeType::LEAF_NODE:
+        return "LEAF_NODE";
+    case NodeType::COMPOSITE_NODE:
+        return "COMPOSITE_NODE";
+    case NodeType::ORTHOGONAL_NODE:
+        return "ORTHOGONAL_NODE";
+    case NodeType::REGION:
+        return "REGION";
+    case NodeType::SHALLOW_HISTORY_NODE:
+        return "SHALLOW_HISTORY_NODE";
+    case NodeType::DEEP_HISTORY_NODE:
+        return "DEEP_HISTORY_NODE";
+    }
+
+    return "UNKNOWN";
+}
+
+void writeString(std::ostream& os, const char* s)
+{
+    os << '"';
+
+    for (; s && *s; ++s)
+    {
+        unsigned char c = static_cast<unsigned char>(*s);
+
+        if (c == '"' || c == '\\')
+        {
+            os << '\\' << *s;
+        }
+        else if (c < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            os << escaped;
+        }
+        else
+        {
+            os << *s;
+        }
+    }
+
+    os << '"';
+}
+
+}  // ns: anonymous
+
+void MemoryReport::toJSON(std::ostream& os) const
+{
+    os << "{\"total_bytes\":" << total_bytes << ",\"machine_bytes\":" << machine_bytes
+       << ",\"node_bytes\":" << node_bytes << ",\"table_bytes\":" << table_bytes
+       << ",\"topology_bytes\":" << topology_bytes << ",\"history_bytes\":" << history_bytes
+       << ",\"runtime_bytes\":" << runtime_bytes << ",\"dispatch_bytes\":" << dispatch_bytes
+       << ",\"scratch_bytes\":" << scratch_bytes << ",\"spy_bytes\":" << spy_bytes
+       << ",\"fifo_bytes\":" << fifo_bytes << ",\"nodes\":[";
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        NodeMemory const& node = nodes[i];
+
+        os << (i ? ",{" : "{") << "\"name\":";
+        writeString(os, node.name);
+        os << ",\"type\":";
+        writeString(os, typeName(node.type));
+        os << ",\"object_bytes\":" << node.object_bytes
+           << ",\"children_bytes\":" << node.children_bytes
+           << ",\"table_bytes\":" << node.tableBytes() << ",\"index_bytes\":" << node.index_bytes
+           << ",\"row_bytes\":" << node.row_bytes << ",\"delegate_bytes\":" << node.delegate_bytes
+           << ",\"name_bytes\":" << node.name_bytes << ",\"num_rows\":" << node.num_rows
+           << ",\"num_actions\":" << node.num_actions << "}";
+    }
+
+    os << "]}";
+}
+
+}  // ns: roost
@@ -0,0 +1,70 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "roost/memory_resource.hpp"
+
+#include <cstdint>
+
+namespace roost
+{
+
+namespace
+{
+
+//! Forwards to the global operator new and delete
+class NewDeleteResource final : public MemoryResource
+{
+protected:
+    void* doAllocate(size_t bytes, size_t alignment) override
+    {
+        if (alignment <= alignof(std::max_align_t))
+        {
+            return ::operator new(bytes);
+        }
+
+        // Over-aligned, the pointer operator new returned is kept just before the block
+        char*     raw     = static_cast<char*>(::operator new(bytes + alignment + sizeof(void*)));
+        uintptr_t start   = reinterpret_cast<uintptr_t>(raw + sizeof(void*));
+        char*     aligned = raw + sizeof(void*) + (alignment - start % alignment) % alignment;
+
+        reinterpret_cast<void**>(aligned)[-1] = raw;
+        return aligned;
+    }
+
+    void doDeallocate(void* p, size_t, size_t alignment) override
+    {
+        if (alignment <= alignof(std::max_align_t))
+        {
+            ::operator delete(p);
+            return;
+        }
+
+        ::operator delete(static_cast<void**>(p)[-1]);
+    }
+
+    bool doIsEqual(MemoryResource const& other) const noexcept override
+    {
+        return dynamic_cast<NewDeleteResource const*>(&other) != nullptr;
+    }
+};  // Class: NewDeleteResource
+
+}  // ns: anonymous
+
+MemoryResource* defaultResource() noexcept
+{
+    static NewDeleteResource resource;
+    return &resource;
+}
+
+}  // ns: roost
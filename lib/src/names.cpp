@@ -0,0 +1,110 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "roost/names.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace roost
+{
+
+namespace
+{
+
+struct SymbolTable
+{
+    std::mutex                           mutex;
+    std::unordered_map<u32, std::string> names;         //!< Names added or loaded
+    std::unordered_map<u32, std::string> placeholders;  //!< '#' names of unknown ids
+};  // Struct: SymbolTable
+
+SymbolTable& symbolTable()
+{
+    static SymbolTable table;
+    return table;
+}
+
+std::string placeholder(u32 id)
+{
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "#%08x", static_cast<unsigned>(id));
+    return buf;
+}
+
+}  // ns: anonymous
+
+const char* symbolName(u32 id)
+{
+    SymbolTable&                table = symbolTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    auto it = table.names.find(id);
+
+    if (it != table.names.end())
+    {
+        return it->second.c_str();
+    }
+
+    // Never erased nor changed once added, so the string outlives the call
+    return table.placeholders.emplace(id, placeholder(id)).first->second.c_str();
+}
+
+void addSymbol(const char* name)
+{
+    SymbolTable&                table = symbolTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    table.names.emplace(nameId(name), name);
+}
+
+bool loadSymbolFile(std::string const& path)
+{
+    std::ifstream file(path);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    SymbolTable&                table = symbolTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    std::string                 line;
+
+    while (std::getline(file, line))
+    {
+        size_t space = line.find(' ');
+
+        if (space == std::string::npos)
+        {
+            continue;
+        }
+
+        u32 id = static_cast<u32>(std::strtoul(line.c_str(), nullptr, 16));
+        table.names.emplace(id, line.substr(space + 1));
+    }
+
+    return true;
+}
+
+void writeSymbol(std::ostream& os, u32 id, const char* name)
+{
+    os << placeholder(id).substr(1) << " " << name << "\n";
+}
+
+}  // ns: roost
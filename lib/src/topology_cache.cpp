@@ -0,0 +1,623 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "roost/topology_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ROOST_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace roost
+{
+namespace core
+{
+
+namespace
+{
+
+const char CACHE_MAGIC[8]  = {'R', 'O', 'O', 'S', 'T', 'T', 'C', '\0'};
+const u32  CACHE_BYTE_ORDER = 0x01020304;
+
+const u64 FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const u64 FNV_PRIME        = 1099511628211ULL;
+
+/*!
+ * \brief CacheHeader starts every topology cache file
+ *
+ * The header is followed by arrays of u32, in this order: parent, initial_child, type, region,
+ * level, depth (node_count each), child_offsets (node_count + 1), children (children_count),
+ * ancestors (lca_levels * node_count), the route keys (ROUTE_KEY_WORDS * route_count) and the
+ * routes (ROUTE_WORDS * route_count).  payload_hash covers every byte after the header, so a
+ * file that was damaged or edited after it was saved is never loaded.
+ */
+struct CacheHeader
+{
+    char magic[8];           //!< Always CACHE_MAGIC
+    u32  version;            //!< Always TOPOLOGY_CACHE_VERSION
+    u32  byte_order;         //!< CACHE_BYTE_ORDER as written by the saving machine
+    u64  hash;               //!< The hashTree() of the tree
+    u64  payload_hash;       //!< The FNV-1a hash of the arrays that follow the header
+    u64  node_count;         //!< Number of nodes in the tree
+    u64  children_count;     //!< Number of entries in children
+    u64  route_count;        //!< Number of routes in the RouteLog
+    u64  max_depth;          //!< Topology::max_depth
+    u64  number_of_regions;  //!< Topology::number_of_regions
+    u32  lca_levels;         //!< Topology::lca_levels
+    u32  reserved;           //!< Always zero
+};  // Struct: CacheHeader
+
+const size_t ROUTE_WORDS = sizeof(Route) / sizeof(u32);
+
+static_assert(sizeof(Route) == ROUTE_WORDS * sizeof(u32), "Route must be made of u32 only");
+static_assert(sizeof(CacheHeader) % sizeof(u64) == 0, "CacheHeader must not need padding");
+
+void hashWord(u64& hash, u32 word)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        hash ^= (word >> (i * 8)) & 0xFF;
+        hash *= FNV_PRIME;
+    }
+}
+
+void hashBytes(u64& hash, const char* bytes, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(bytes[i]);
+        hash *= FNV_PRIME;
+    }
+}
+
+//! A read-only view of a whole file, mapped where mmap is available and read otherwise
+class MappedFile
+{
+public:
+    explicit MappedFile(std::string const& path) : m_data(nullptr), m_size(0), m_buffer()
+    {
+#if ROOST_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            return;
+        }
+
+        struct stat st;
+
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (addr != MAP_FAILED)
+            {
+                m_data = static_cast<const char*>(addr);
+                m_size = static_cast<size_t>(st.st_size);
+            }
+        }
+
+        ::close(fd);
+#else
+        std::ifstream in(path, std::ios::binary);
+
+        if (in)
+        {
+            m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            m_data = m_buffer.data();
+            m_size = m_buffer.size();
+        }
+#endif
+    }
+
+    ~MappedFile()
+    {
+#if ROOST_HAS_MMAP
+        if (m_data)
+        {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+#endif
+    }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    const char* data() const
+    {
+        return m_data;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    const char*       m_data;    //!< The contents of the file or nullptr
+    size_t            m_size;    //!< The size of the file
+    std::vector<char> m_buffer;  //!< Holds the contents if the file could not be mapped
+};  // Class: MappedFile
+
+//! Hands out consecutive arrays of u32 from a mapped file
+class Reader
+{
+public:
+    Reader(const char* data, size_t size) : m_data(data), m_remaining(size)
+    {
+    }
+
+    //! Copies count words into out, returns false if the file is too short
+    template <typename T>
+    bool read(Vector<T>& out, size_t count)
+    {
+        static_assert(sizeof(T) % sizeof(u32) == 0, "Only arrays of u32 are stored");
+
+        size_t bytes = count * sizeof(u32);
+
+        if (count > m_remaining / sizeof(u32))
+        {
+            return false;
+        }
+
+        out.resize(bytes / sizeof(T));
+        std::memcpy(out.data(), m_data, bytes);
+
+        m_data += bytes;
+        m_remaining -= bytes;
+        return true;
+    }
+
+    bool done() const
+    {
+        return m_remaining == 0;
+    }
+
+private:
+    const char* m_data;       //!< The next array
+    size_t      m_remaining;  //!< Bytes left in the file
+};  // Class: Reader
+
+//! Writes the first count entries of array and adds them to hash
+template <typename T>
+void writeArray(std::ofstream& out, u64& hash, Vector<T> const& array, size_t count)
+{
+    const char* bytes = reinterpret_cast<const char*>(array.data());
+
+    hashBytes(hash, bytes, count * sizeof(T));
+    out.write(bytes, count * sizeof(T));
+}
+
+bool isNode(NodeId id, size_t n)
+{
+    return id < n;
+}
+
+bool isNodeOrInvalid(NodeId id, size_t n)
+{
+    return id < n || id == INVALID_NODE;
+}
+
+template <typename P>
+bool allOf(Vector<NodeId> const& ids, size_t n, P pred)
+{
+    for (NodeId id : ids)
+    {
+        if (!pred(id, n))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//! True if ancestor is node or one of its ancestors, parent must already be known to be pre-order
+bool isAncestor(Topology const& topology, NodeId ancestor, NodeId node)
+{
+    while (node != INVALID_NODE && node > ancestor)
+    {
+        node = topology.parent[node];
+    }
+
+    return node == ancestor;
+}
+
+/*!
+ * \brief isWellFormed checks that the ids describe a tree the core can walk
+ *
+ * The ids are already known to be in range.  The parents must come before their children, as the
+ * pre-order walk of buildTopology() numbers them, so every walk up the tree ends at Top, and the
+ * depths, regions, children and ancestors must agree with the parents.  A route's LCA must be an
+ * ancestor of its source and destination, otherwise transition() walks past Top.
+ */
+bool isWellFormed(Topology const& topology, RouteLog const& log)
+{
+    size_t n = topology.size();
+
+    if (topology.parent[0] != INVALID_NODE || topology.depth[0] != 1 ||
+        topology.type[0] != NodeType::REGION)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        NodeId parent = topology.parent[i];
+        bool   region = topology.type[i] == NodeType::REGION;
+
+        if (i > 0 && (parent >= i || topology.depth[i] != topology.depth[parent] + 1 ||
+                      topology.region[i] != (region ? i : topology.region[parent])))
+        {
+            return false;
+        }
+
+        if (topology.level[i] != (region ? topology.depth[i] : 0) ||
+            (topology.initial_child[i] != INVALID_NODE &&
+             topology.parent[topology.initial_child[i]] != i))
+        {
+            return false;
+        }
+
+        for (const NodeId* child = topology.childrenBegin(static_cast<NodeId>(i));
+             child != topology.childrenEnd(static_cast<NodeId>(i));
+             ++child)
+        {
+            if (topology.parent[*child] != i)
+            {
+                return false;
+            }
+        }
+
+        if (topology.ancestors[i] != (i == 0 ? 0 : parent))
+        {
+            return false;
+        }
+    }
+
+    for (u32 k = 1; k < topology.lca_levels; ++k)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (topology.ancestor(k, static_cast<NodeId>(i)) !=
+                topology.ancestor(k - 1, topology.ancestor(k - 1, static_cast<NodeId>(i))))
+            {
+                return false;
+            }
+        }
+    }
+
+    for (Route const& route : log.routes)
+    {
+        if (route.src_region != topology.region[route.src])
+        {
+            return false;
+        }
+
+        if (route.lca == INVALID_NODE)
+        {
+            if (route.lca_region != INVALID_NODE)
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        if (route.lca_region != topology.region[route.lca] ||
+            !isAncestor(topology, route.lca, route.src) ||
+            (route.destination != INVALID_NODE &&
+             !isAncestor(topology, route.lca, route.destination)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//! Checks everything the core indexes with, so a corrupted file can't read out of bounds
+bool isConsistent(Topology const& topology, RouteLog const& log)
+{
+    size_t n = topology.size();
+
+    if (!allOf(topology.parent, n, isNodeOrInvalid) ||
+        !allOf(topology.initial_child, n, isNodeOrInvalid) ||
+        !allOf(topology.region, n, isNode) || !allOf(topology.children, n, isNode) ||
+        !allOf(topology.ancestors, n, isNode))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < log.keys.size(); i += ROUTE_KEY_WORDS)
+    {
+        if (!isNodeOrInvalid(log.keys[i], n) || !isNodeOrInvalid(log.keys[i + 1], n) ||
+            log.keys[i + 2] > static_cast<u32>(History::DEEP))
+        {
+            return false;
+        }
+    }
+
+    if (topology.lca_levels == 0 ||
+        (size_t(1) << topology.lca_levels) < topology.max_depth)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (static_cast<u32>(topology.type[i]) > static_cast<u32>(NodeType::DEEP_HISTORY_NODE) ||
+            topology.depth[i] == 0 || topology.depth[i] > topology.max_depth ||
+            topology.child_offsets[i] > topology.child_offsets[i + 1])
+        {
+            return false;
+        }
+    }
+
+    if (topology.child_offsets[0] != 0 || topology.child_offsets[n] != topology.children.size())
+    {
+        return false;
+    }
+
+    for (Route const& route : log.routes)
+    {
+        if (!isNode(route.src, n) || !isNode(route.src_region, n) ||
+            !isNodeOrInvalid(route.destination, n) || !isNodeOrInvalid(route.lca, n) ||
+            !isNodeOrInvalid(route.lca_region, n) || route.history > History::DEEP)
+        {
+            return false;
+        }
+    }
+
+    return isWellFormed(topology, log);
+}
+
+}  // ns: anonymous
+
+Route makeRoute(Topology const& topology, RouteLog& log, NodeId src, NodeId dst, History history)
+{
+    size_t        i   = log.next;
+    NodeId const* key = log.keys.data() + ROUTE_KEY_WORDS * i;
+
+    if (i < log.routes.size() && key[0] == src && key[1] == dst &&
+        key[2] == static_cast<u32>(history))
+    {
+        ++log.next;
+        return log.routes[i];
+    }
+
+    // Everything after a miss is recorded again
+    log.keys.resize(ROUTE_KEY_WORDS * i);
+    log.routes.resize(i);
+
+    Route route = makeRoute(topology, src, dst, history);
+
+    log.keys.push_back(src);
+    log.keys.push_back(dst);
+    log.keys.push_back(static_cast<u32>(history));
+    log.routes.push_back(route);
+    log.next  = log.routes.size();
+    log.dirty = true;
+
+    return route;
+}
+
+u64 hashTree(TreeAccess const& access, void* top, Vector<void*>& all_nodes)
+{
+    all_nodes.clear();
+
+    u64           hash = FNV_OFFSET_BASIS;
+    Vector<void*> stack(all_nodes.get_allocator());
+    stack.push_back(top);
+
+    // Same pre-order walk as buildTopology(), so the ids match
+    while (!stack.empty())
+    {
+        void* node = stack.back();
+        stack.pop_back();
+
+        access.set_id(node, static_cast<NodeId>(all_nodes.size()));
+        all_nodes.push_back(node);
+
+        size_t num_children  = access.num_children(node);
+        void*  initial_child = access.initial_child(node);
+        u32    initial_slot  = INVALID_NODE;
+
+        for (size_t i = num_children; i-- > 0;)
+        {
+            void* child = access.child(node, i);
+
+            if (child == initial_child)
+            {
+                initial_slot = static_cast<u32>(i);
+            }
+
+            stack.push_back(child);
+        }
+
+        hashWord(hash, static_cast<u32>(access.type(node)));
+        hashWord(hash, static_cast<u32>(num_children));
+        hashWord(hash, initial_slot);
+    }
+
+    return hash;
+}
+
+bool saveTopologyCache(
+        std::string const& path,
+        u64                hash,
+        Topology const&    topology,
+        RouteLog const&    log)
+{
+    size_t n = topology.size();
+
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version           = TOPOLOGY_CACHE_VERSION;
+    header.byte_order        = CACHE_BYTE_ORDER;
+    header.hash              = hash;
+    header.node_count        = n;
+    header.children_count    = topology.children.size();
+    header.route_count       = log.next;
+    header.max_depth         = topology.max_depth;
+    header.number_of_regions = topology.number_of_regions;
+    header.lca_levels        = topology.lca_levels;
+    header.payload_hash      = FNV_OFFSET_BASIS;
+
+    Vector<u32> types(n, 0, topology.type.get_allocator());
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        types[i] = static_cast<u32>(topology.type[i]);
+    }
+
+#if ROOST_HAS_MMAP
+    std::string tmp_path = path + ".tmp." + std::to_string(::getpid());
+#else
+    std::string tmp_path = path + ".tmp";
+#endif
+
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+
+        if (!out)
+        {
+            return false;
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeArray(out, header.payload_hash, topology.parent, n);
+        writeArray(out, header.payload_hash, topology.initial_child, n);
+        writeArray(out, header.payload_hash, types, n);
+        writeArray(out, header.payload_hash, topology.region, n);
+        writeArray(out, header.payload_hash, topology.level, n);
+        writeArray(out, header.payload_hash, topology.depth, n);
+        writeArray(out, header.payload_hash, topology.child_offsets, n + 1);
+        writeArray(out, header.payload_hash, topology.children, topology.children.size());
+        writeArray(out, header.payload_hash, topology.ancestors, topology.ancestors.size());
+        writeArray(out, header.payload_hash, log.keys, ROUTE_KEY_WORDS * log.next);
+        writeArray(out, header.payload_hash, log.routes, log.next);
+
+        // Written again now that the payload is hashed
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        if (!out.flush())
+        {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        // Not every platform renames over an existing file
+        std::remove(path.c_str());
+
+        if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool loadTopologyCache(
+        std::string const& path,
+        u64                hash,
+        size_t             node_count,
+        Topology&          topology,
+        RouteLog&          log)
+{
+    MappedFile file(path);
+
+    if (file.size() < sizeof(CacheHeader))
+    {
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != TOPOLOGY_CACHE_VERSION || header.byte_order != CACHE_BYTE_ORDER ||
+        header.hash != hash || header.node_count != node_count || node_count == 0 ||
+        header.lca_levels >= 32 || header.max_depth > node_count ||
+        header.number_of_regions > node_count || header.children_count > file.size() ||
+        header.route_count > file.size())
+    {
+        return false;
+    }
+
+    u64 payload_hash = FNV_OFFSET_BASIS;
+    hashBytes(payload_hash, file.data() + sizeof(header), file.size() - sizeof(header));
+
+    if (payload_hash != header.payload_hash)
+    {
+        return false;
+    }
+
+    size_t      n = node_count;
+    Vector<u32> types(topology.type.get_allocator());
+
+    Reader reader(file.data() + sizeof(header), file.size() - sizeof(header));
+
+    bool ok = reader.read(topology.parent, n) && reader.read(topology.initial_child, n) &&
+              reader.read(types, n) && reader.read(topology.region, n) &&
+              reader.read(topology.level, n) && reader.read(topology.depth, n) &&
+              reader.read(topology.child_offsets, n + 1) &&
+              reader.read(topology.children, header.children_count) &&
+              reader.read(topology.ancestors, header.lca_levels * n) &&
+              reader.read(log.keys, ROUTE_KEY_WORDS * header.route_count) &&
+              reader.read(log.routes, ROUTE_WORDS * header.route_count) && reader.done();
+
+    if (!ok)
+    {
+        return false;
+    }
+
+    topology.type.resize(n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        topology.type[i] = static_cast<NodeType>(types[i]);
+    }
+
+    // Set from the transition tables, see markHistory()
+    topology.records_history.assign(n, 0);
+
+    topology.lca_levels        = header.lca_levels;
+    topology.max_depth         = header.max_depth;
+    topology.number_of_regions = header.number_of_regions;
+
+    log.next  = 0;
+    log.dirty = false;
+
+    return isConsistent(topology, log);
+}
+
+}  // ns: core
+
+}  // ns: roost
@@ -0,0 +1,172 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hayai/hayai.hpp"
+
+#include <chrono>
+#include <iostream>
+
+#include "baseline/sm1_baseline.hpp"
+#include "baseline/sm2_baseline.hpp"
+#include "roost/state_machine.hpp"
+#include "sm1/sm1.hpp"
+#include "sm1/sm1_static.hpp"
+#include "sm2/sm2.hpp"
+
+// Hand-written counterparts of the SM1Bench and SM2Bench smoke tests in sample_bench.cpp.  They
+// execute the same hooks in the same order (see baseline_test.cpp) so the difference in time is
+// the dispatch overhead of the StateMachine.
+
+template <typename FSM>
+class SM1Baseline : public ::hayai::Fixture
+{
+public:
+    FSM fsm;
+
+    virtual void SetUp()
+    {
+        fsm.init();
+    }
+};
+
+template <typename FSM>
+class SM2Baseline : public ::hayai::Fixture
+{
+public:
+    FSM fsm;
+
+    virtual void SetUp()
+    {
+        fsm.init();
+        fsm.forceToSe();
+    }
+};
+
+//! The same machine again, declared as types for a StaticMachine
+class SM1Static : public ::hayai::Fixture
+{
+public:
+    sm1::Ctx              ctx;
+    sm1_static::Machine<> fsm{"SM1Static", ctx};
+
+    virtual void SetUp()
+    {
+        fsm.init();
+    }
+};
+
+using SM1Switch = SM1Baseline<sm1_baseline::SwitchFsm>;
+using SM1Table  = SM1Baseline<sm1_baseline::TableFsm>;
+using SM2Switch = SM2Baseline<sm2_baseline::SwitchFsm>;
+using SM2Table  = SM2Baseline<sm2_baseline::TableFsm>;
+
+BENCHMARK_F(SM1Switch, smoke_test, 100, 100)
+{
+    fsm.handleEvent(sm1::Evt::FIRST);
+}
+
+BENCHMARK_F(SM1Table, smoke_test, 100, 100)
+{
+    fsm.handleEvent(sm1::Evt::FIRST);
+}
+
+BENCHMARK_F(SM1Static, smoke_test, 100, 100)
+{
+    fsm.handleEvent(sm1::Evt::FIRST);
+}
+
+BENCHMARK_F(SM2Switch, smoke_test, 100, 100)
+{
+    fsm.handleEvent(sm2::Evt::SECOND);
+}
+
+BENCHMARK_F(SM2Table, smoke_test, 100, 100)
+{
+    fsm.handleEvent(sm2::Evt::SECOND);
+}
+
+namespace
+{
+
+const size_t RATIO_ITERATIONS = 100000;
+
+template <typename FUNC>
+double nsPerEvent(FUNC func)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < RATIO_ITERATIONS; ++i)
+    {
+        func();
+    }
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / RATIO_ITERATIONS;
+}
+
+void printRatio(const char* name, double roost_ns, double switch_ns, double table_ns)
+{
+    std::cout << "[ OVERHEAD ] " << name << ": roost " << roost_ns << " ns, switch " << switch_ns
+              << " ns, table " << table_ns << " ns, roost/switch " << roost_ns / switch_ns
+              << "x, roost/table " << roost_ns / table_ns << "x" << std::endl;
+}
+
+}  // ns: anonymous
+
+//! Single shot benchmark that reports how far the StateMachine is from the hand-written floor
+BENCHMARK(Baseline, overhead_ratio, 1, 1)
+{
+    {
+        sm1::Ctx       ctx;
+        sm1::RootState root{"root", ctx, nullptr};
+        ctx.m_root = &root;
+
+        sm1::SMTypes::StateMachine be("TestBackend", &root);
+        be.init();
+
+        sm1_baseline::SwitchFsm sw;
+        sm1_baseline::TableFsm  table;
+        sw.init();
+        table.init();
+
+        double roost_ns  = nsPerEvent([&] { be.handleEvent(sm1::Evt::FIRST); });
+        double switch_ns = nsPerEvent([&] { sw.handleEvent(sm1::Evt::FIRST); });
+        double table_ns  = nsPerEvent([&] { table.handleEvent(sm1::Evt::FIRST); });
+
+        printRatio("sm1", roost_ns, switch_ns, table_ns);
+    }
+
+    {
+        sm2::Ctx       ctx;
+        sm2::RootState root{"root", ctx, nullptr};
+        ctx.m_root = &root;
+
+        sm2::SMTypes::StateMachine be("TestBackend", &root);
+        be.init();
+        be.forceTransitionTo(&root.m_s11.m_s111.m_s1111.m_s11113.m_se);
+
+        sm2_baseline::SwitchFsm sw;
+        sm2_baseline::TableFsm  table;
+        sw.init();
+        sw.forceToSe();
+        table.init();
+        table.forceToSe();
+
+        double roost_ns  = nsPerEvent([&] { be.handleEvent(sm2::Evt::SECOND); });
+        double switch_ns = nsPerEvent([&] { sw.handleEvent(sm2::Evt::SECOND); });
+        double table_ns  = nsPerEvent([&] { table.handleEvent(sm2::Evt::SECOND); });
+
+        printRatio("sm2", roost_ns, switch_ns, table_ns);
+    }
+}
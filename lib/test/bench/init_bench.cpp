@@ -0,0 +1,245 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hayai/hayai.hpp"
+
+#include "roost/state_machine.hpp"
+#include "roost/state_machine_pool.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Measures StateMachine::init() on generated machines of increasing size.  Each level of the
+// machine is a composite state holding LEVEL_WIDTH leaves and the next level, so the number of
+// nodes grows linearly with the depth and so should the time to init().
+
+namespace init_bench
+{
+
+enum class Evt
+{
+    ROOST_NONE,  // Enforced by framework
+    NEXT,
+    BACK
+};
+
+static const char* EvtStrings[] = {"NONE", "NEXT", "BACK"};
+
+ROOST_ENUM_PRINT_HELPER(Evt, EvtStrings)
+
+struct Ctx
+{
+};
+
+using SMTypes = roost::NodeAlias<Ctx, Evt>;
+
+const size_t LEVEL_WIDTH = 16;
+
+class GenLeaf : public SMTypes::Leaf
+{
+public:
+    GenLeaf(Ctx& ctx, SMTypes::Node* parent, SMTypes::Node* next, SMTypes::Node* back)
+        : SMTypes::Leaf("leaf", ctx, parent), m_next(next), m_back(back)
+    {
+    }
+
+    void createTransitionTable() override
+    {
+        SMTypes::Node& next = *m_next;
+        SMTypes::Node& back = *m_back;
+
+        // One short transition and one that leaves the whole hierarchy
+        addRow(Evt::NEXT, &next, ROOST_NO_ACTION, ROOST_NO_GUARD);
+        addRow(Evt::BACK, &back, ROOST_NO_ACTION, ROOST_NO_GUARD);
+    }
+
+private:
+    SMTypes::Node* m_next;
+    SMTypes::Node* m_back;
+};  // Class: GenLeaf
+
+template <size_t DEPTH>
+class Level : public SMTypes::Composite
+{
+public:
+    Level(Ctx& ctx, SMTypes::Node* parent, SMTypes::Node* back)
+        : SMTypes::Composite("level", ctx, parent, &m_next), m_next(ctx, this, back)
+    {
+        for (size_t i = 0; i < LEVEL_WIDTH; ++i)
+        {
+            m_leaves.emplace_back(new GenLeaf(ctx, this, &m_next, back));
+        }
+    }
+
+    void createTransitionTable() override
+    {
+    }
+
+    Level<DEPTH - 1>                      m_next;
+    std::vector<std::unique_ptr<GenLeaf>> m_leaves;
+};  // Class: Level
+
+template <>
+class Level<0> : public GenLeaf
+{
+public:
+    Level(Ctx& ctx, SMTypes::Node* parent, SMTypes::Node* back)
+        : GenLeaf(ctx, parent, back, back)
+    {
+    }
+};  // Class: Level
+
+template <size_t DEPTH>
+class RootState : public SMTypes::Composite
+{
+public:
+    RootState(Ctx& ctx)
+        : SMTypes::Composite("root", ctx, nullptr, &m_levels), m_levels(ctx, this, &m_levels)
+    {
+    }
+
+    void createTransitionTable() override
+    {
+    }
+
+    Level<DEPTH> m_levels;
+};  // Class: RootState
+
+template <size_t DEPTH>
+class InitBench : public ::hayai::Fixture
+{
+public:
+    Ctx              ctx;
+    RootState<DEPTH> root{ctx};
+
+    void run(const char* cache = "")
+    {
+        SMTypes::StateMachine be("InitBench", &root);
+        be.setTopologyCache(cache);
+        be.init();
+    }
+};  // Class: InitBench
+
+//! Returns the path of a file in the temporary directory
+inline std::string tempPath(const char* file)
+{
+#ifdef _WIN32
+    const char* dir      = std::getenv("TEMP");
+    const char* fallback = ".";
+#else
+    const char* dir      = std::getenv("TMPDIR");
+    const char* fallback = "/tmp";
+#endif
+
+    std::string path = dir && *dir ? dir : fallback;
+    char        last = path[path.size() - 1];
+
+    if (last != '/' && last != '\\')
+    {
+        path += '/';
+    }
+
+    return path + file;
+}
+
+//! InitBench with a topology cache in the temporary directory, removed after each run
+template <size_t DEPTH>
+class CachedInitBench : public InitBench<DEPTH>
+{
+public:
+    std::string cache = tempPath("roost_init_bench.cache");
+
+    void SetUp() override
+    {
+        std::remove(cache.c_str());
+    }
+
+    void TearDown() override
+    {
+        std::remove(cache.c_str());
+    }
+};  // Class: CachedInitBench
+
+//! Everything a session constructs, for comparing a pool against construct and init()
+template <size_t DEPTH>
+struct Session
+{
+    Session() : m_ctx(), m_root(m_ctx), m_sm("Session", &m_root)
+    {
+    }
+
+    SMTypes::StateMachine& stateMachine()
+    {
+        return m_sm;
+    }
+
+    Ctx                   m_ctx;
+    RootState<DEPTH>      m_root;
+    SMTypes::StateMachine m_sm;
+};  // Struct: Session
+
+class SessionBench : public ::hayai::Fixture
+{
+public:
+    roost::StateMachinePool<Session<32>> pool{1};
+
+    void SetUp() override
+    {
+        pool.init();
+    }
+};  // Class: SessionBench
+
+}  // ns: init_bench
+
+using InitDepth32  = init_bench::InitBench<32>;
+using InitDepth64  = init_bench::InitBench<64>;
+using InitDepth128 = init_bench::InitBench<128>;
+using CachedInit128 = init_bench::CachedInitBench<128>;
+using SessionBench = init_bench::SessionBench;
+
+BENCHMARK_F(InitDepth32, init, 10, 10)
+{
+    run();
+}
+
+BENCHMARK_F(InitDepth64, init, 10, 10)
+{
+    run();
+}
+
+BENCHMARK_F(InitDepth128, init, 10, 10)
+{
+    run();
+}
+
+// The first iteration of a run writes the cache, every other one maps it
+BENCHMARK_F(CachedInit128, init_cached, 10, 10)
+{
+    run(cache.c_str());
+}
+
+BENCHMARK_F(SessionBench, construct_init, 10, 10)
+{
+    init_bench::Session<32> session;
+    session.stateMachine().init();
+}
+
+BENCHMARK_F(SessionBench, pool_acquire_release, 10, 10)
+{
+    // The handle releases the session right away
+    pool.acquire();
+}
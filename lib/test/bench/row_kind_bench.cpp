@@ -0,0 +1,178 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "hayai/hayai.hpp"
+
+#include "roost/state_machine.hpp"
+
+// One benchmark per RowKind, each event below is handled by a single row of that kind.  The
+// external and history rows go to Busy and back, so they cost two transitions.
+
+namespace row_kind
+{
+
+enum class Evt
+{
+    ROOST_NONE,  // Enforced by framework
+    INTERNAL,
+    GUARDED,
+    ACTIONS,
+    EXTERNAL,
+    HISTORY
+};
+
+static const char* EvtStrings[] = {"NONE", "INTERNAL", "GUARDED", "ACTIONS", "EXTERNAL", "HISTORY"};
+
+ROOST_ENUM_PRINT_HELPER(Evt, EvtStrings)
+
+class RootState;
+
+struct Ctx
+{
+    RootState* m_root;
+    bool       pass;
+    roost::u32 count;
+};
+
+using SMTypes = roost::NodeAlias<Ctx, Evt>;
+
+class Idle : public SMTypes::Leaf
+{
+public:
+    Idle(const char* name, Ctx& ctx, SMTypes::Node* parent) : SMTypes::Leaf(name, ctx, parent)
+    {
+    }
+
+    void createTransitionTable() override;
+
+    void count(Evt const&)
+    {
+        ++m_ctx.count;
+    }
+};
+
+class Work : public SMTypes::Leaf
+{
+public:
+    Work(const char* name, Ctx& ctx, SMTypes::Node* parent) : SMTypes::Leaf(name, ctx, parent)
+    {
+    }
+
+    void createTransitionTable() override
+    {
+    }
+};
+
+class Busy : public SMTypes::Composite
+{
+public:
+    Busy(const char* name, Ctx& ctx, SMTypes::Node* parent)
+        : SMTypes::Composite(name, ctx, parent, &m_work), m_work("work", ctx, this)
+    {
+    }
+
+    Work m_work;
+
+    void createTransitionTable() override;
+};
+
+class RootState : public SMTypes::Composite
+{
+public:
+    RootState(const char* name, Ctx& ctx, SMTypes::Node* parent)
+        : SMTypes::Composite(name, ctx, parent, &m_idle),
+          m_idle("idle", ctx, this),
+          m_busy("busy", ctx, this)
+    {
+    }
+
+    Idle m_idle;
+    Busy m_busy;
+
+    void createTransitionTable() override
+    {
+    }
+};
+
+// clang-format off
+
+void Idle::createTransitionTable()
+{
+    RootState& rs = *m_ctx.m_root;
+
+    addRow(Evt::INTERNAL, ROOST_NO_DEST,             ROOST_NO_ACTION,       ROOST_NO_GUARD);
+    addRow(Evt::GUARDED,  ROOST_NO_DEST,             ROOST_NO_ACTION,       ROOST_GUARD(m_ctx.pass));
+    addRow(Evt::ACTIONS,  ROOST_NO_DEST,             {ROOST_ACTION(count)}, ROOST_NO_GUARD);
+    addRow(Evt::EXTERNAL, &rs.m_busy,                ROOST_NO_ACTION,       ROOST_NO_GUARD);
+    addRow(Evt::HISTORY,  &rs.m_busy.shallowHistory, ROOST_NO_ACTION,       ROOST_NO_GUARD);
+}
+
+void Busy::createTransitionTable()
+{
+    RootState& rs = *m_ctx.m_root;
+
+    addRow(Evt::ROOST_NONE, &rs.m_idle, ROOST_NO_ACTION, ROOST_NO_GUARD);
+}
+
+// clang-format on
+
+}  // ns: row_kind
+
+class RowKindBench : public ::hayai::Fixture
+{
+public:
+    row_kind::Ctx       ctx{nullptr, true, 0};
+    row_kind::RootState root{"root", ctx, nullptr};
+
+    row_kind::SMTypes::StateMachine* be;
+
+    virtual void SetUp()
+    {
+        ctx.m_root = &root;
+
+        be = new row_kind::SMTypes::StateMachine("RowKindBench", &root);
+        be->init();
+    }
+
+    virtual void TearDown()
+    {
+        delete be;
+    }
+};
+
+BENCHMARK_F(RowKindBench, internal, 100, 1000)
+{
+    be->handleEvent(row_kind::Evt::INTERNAL);
+}
+
+BENCHMARK_F(RowKindBench, guarded_internal, 100, 1000)
+{
+    be->handleEvent(row_kind::Evt::GUARDED);
+}
+
+BENCHMARK_F(RowKindBench, internal_actions, 100, 1000)
+{
+    be->handleEvent(row_kind::Evt::ACTIONS);
+}
+
+BENCHMARK_F(RowKindBench, external, 100, 1000)
+{
+    be->handleEvent(row_kind::Evt::EXTERNAL);
+}
+
+BENCHMARK_F(RowKindBench, history, 100, 1000)
+{
+    be->handleEvent(row_kind::Evt::HISTORY);
+}
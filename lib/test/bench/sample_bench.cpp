@@ -45,6 +45,55 @@ BENCHMARK_F(SM1Bench, smoke_test, 100, 100)
     be->handleEvent(sm1::Evt::FIRST);
 }
 
+//! SM1Bench with the machine flattened into a node by event table
+class SM1FlatBench : public SM1Bench
+{
+public:
+    virtual void SetUp()
+    {
+        ctx.m_root = &root;
+
+        be = new sm1::SMTypes::StateMachine("TestBackend", &root);
+        be->setFlatDispatch(true);
+        be->init();
+    }
+};
+
+BENCHMARK_F(SM1FlatBench, smoke_test, 100, 100)
+{
+    be->handleEvent(sm1::Evt::FIRST);
+}
+
+//! SM1Bench with the events handed over in a batch of 64 instead of one at a time
+class SM1BatchBench : public SM1Bench
+{
+public:
+    sm1::Evt events[64];
+
+    virtual void SetUp()
+    {
+        SM1Bench::SetUp();
+
+        for (sm1::Evt& e : events)
+        {
+            e = sm1::Evt::FIRST;
+        }
+    }
+};
+
+BENCHMARK_F(SM1BatchBench, one_at_a_time, 100, 100)
+{
+    for (sm1::Evt e : events)
+    {
+        be->handleEvent(e);
+    }
+}
+
+BENCHMARK_F(SM1BatchBench, batch, 100, 100)
+{
+    be->handleEvents(events, 64);
+}
+
 class SM2Bench : public ::hayai::Fixture
 {
 public:
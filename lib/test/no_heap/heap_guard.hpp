@@ -0,0 +1,35 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROOST_TEST_NO_HEAP_HEAP_GUARD_HPP
+#define ROOST_TEST_NO_HEAP_HEAP_GUARD_HPP
+
+/*!
+ * \brief HeapGuard forbids the heap for its lifetime
+ *
+ * The global operator new, replaced in heap_guard.cpp, aborts while a HeapGuard is alive.  The
+ * replacements live in a translation unit of their own so they can't be inlined into (and
+ * mismatched with) callers.
+ */
+struct HeapGuard
+{
+    HeapGuard();
+    ~HeapGuard();
+
+    HeapGuard(HeapGuard const&)            = delete;
+    HeapGuard& operator=(HeapGuard const&) = delete;
+};  // Struct: HeapGuard
+
+#endif  // ROOST_TEST_NO_HEAP_HEAP_GUARD_HPP
@@ -0,0 +1,345 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include "heap_guard.hpp"
+#include "roost/state_machine.hpp"
+#include "simple_history/simple_history.hpp"
+#include "sm1/sm1.hpp"
+
+#include <string>
+#include <vector>
+
+// Built with ROOST_NO_HEAP, the global operator new aborts while a HeapGuard is alive, so every
+// StateMachine call made under a guard is known not to touch the heap
+
+namespace
+{
+
+//! Records the entries, exits and errors into fixed arrays
+template <typename CTX, typename E>
+class FixedTracingSpy : public roost::Spy<CTX, E>
+{
+public:
+    static const size_t CAPACITY = 64;
+
+    FixedTracingSpy() : m_size(0), m_first_error(nullptr)
+    {
+    }
+
+    void on_entry(const char* node_name, CTX&) override
+    {
+        record('E', node_name);
+    }
+
+    void on_exit(const char* node_name, CTX&) override
+    {
+        record('X', node_name);
+    }
+
+    void action(const char*, CTX&, E const&, const char*) override
+    {
+    }
+
+    void guard(const char*, CTX&, E const&, const char*, bool) override
+    {
+    }
+
+    void event(const char*, CTX&, E const&) override
+    {
+    }
+
+    void no_transition(const char*, CTX&, E const&) override
+    {
+    }
+
+    void error(const char*, CTX&, const char* main_error, const char*) override
+    {
+        record(main_error);
+    }
+
+    void error(const char*, CTX&, E const&, const char* main_error, const char*) override
+    {
+        record(main_error);
+    }
+
+    //! Returns the trace in the format of TracingSpy, only call it without a HeapGuard
+    std::vector<std::string> trace()
+    {
+        std::vector<std::string> rval;
+
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            rval.push_back(std::string(m_kinds[i] == 'E' ? "OE-" : "OX-") + m_names[i]);
+        }
+
+        m_size = 0;
+        return rval;
+    }
+
+    const char* firstError() const
+    {
+        return m_first_error;
+    }
+
+private:
+    void record(const char* main_error)
+    {
+        if (!m_first_error)
+        {
+            m_first_error = main_error;
+        }
+    }
+
+    void record(char kind, const char* node_name)
+    {
+        if (m_size < CAPACITY)
+        {
+            m_kinds[m_size] = kind;
+            m_names[m_size] = node_name;
+            ++m_size;
+        }
+    }
+
+    char        m_kinds[CAPACITY];
+    const char* m_names[CAPACITY];
+    size_t      m_size;
+    const char* m_first_error;
+};  // Class: FixedTracingSpy
+
+}  // ns: anonymous
+
+namespace wide
+{
+
+enum class Evt
+{
+    ROOST_NONE  // Enforced by framework
+};
+
+static const char* EvtStrings[] = {"NONE"};
+
+ROOST_ENUM_PRINT_HELPER(Evt, EvtStrings)
+
+struct Ctx
+{
+};
+
+using SMTypes = roost::NodeAlias<Ctx, Evt>;
+
+class Leaf : public SMTypes::Leaf
+{
+public:
+    Leaf(Ctx& ctx, SMTypes::Node* parent) : SMTypes::Leaf("leaf", ctx, parent)
+    {
+    }
+
+    void createTransitionTable() override
+    {
+    }
+};  // Class: Leaf
+
+//! A composite with one child more than ROOST_NO_HEAP_MAX_CHILDREN allows
+class RootState : public SMTypes::Composite
+{
+public:
+    explicit RootState(Ctx& ctx)
+        : SMTypes::Composite("root", ctx, nullptr, &m_first), m_first(ctx, this)
+    {
+        for (size_t i = 0; i < ROOST_NO_HEAP_MAX_CHILDREN; ++i)
+        {
+            m_others[i].init(ctx, this);
+        }
+    }
+
+    void createTransitionTable() override
+    {
+    }
+
+    struct Slot
+    {
+        void init(Ctx& ctx, SMTypes::Node* parent)
+        {
+            ::new (&m_storage) Leaf(ctx, parent);
+        }
+
+        ~Slot()
+        {
+            reinterpret_cast<Leaf*>(&m_storage)->~Leaf();
+        }
+
+        typename std::aligned_storage<sizeof(Leaf), alignof(Leaf)>::type m_storage;
+    };  // Struct: Slot
+
+    Leaf m_first;
+    Slot m_others[ROOST_NO_HEAP_MAX_CHILDREN];
+};  // Class: RootState
+
+}  // ns: wide
+
+TEST(NoHeapTest, event_test)
+{
+    using namespace sm1;
+    using Spy = FixedTracingSpy<Ctx, Evt>;
+
+    Ctx       ctx;
+    RootState root("root", ctx, nullptr);
+    ctx.m_root = &root;
+
+    std::shared_ptr<Spy>  spy = std::make_shared<Spy>();
+    SMTypes::StateMachine be("TestBackend", &root, spy);
+    bool                  init;
+
+    {
+        HeapGuard guard;
+
+        init = be.init();
+
+        be.handleEvent(Evt::SECOND);
+        be.handleEvent(Evt::FIRST);
+        be.handleEvent(Evt::THIRD);
+        be.handleEvent(Evt::FIRST);
+    }
+
+    ASSERT_TRUE(init);
+
+    std::vector<std::string> expected_states = {
+            "OE-root",    "OE-sm11",    "OE-sm112",   "OX-sm112",  "OE-sm111",  "OE-sm1111",
+            "OX-sm1111",  "OX-sm111",   "OX-sm11",    "OE-sm12",   "OE-sm122",  "OE-sm1221",
+            "OE-sm12211", "OX-sm12211", "OX-sm1221",  "OX-sm122",  "OX-sm12",   "OE-sm11",
+            "OE-sm111",   "OE-sm1111",  "OX-sm1111",  "OX-sm111",  "OX-sm11",   "OE-sm12",
+            "OE-sm122",   "OE-sm1221",  "OE-sm12211", "OX-sm12211", "OX-sm1221", "OX-sm122",
+            "OX-sm12",    "OE-sm11",    "OE-sm111",   "OE-sm1111"};
+
+    ASSERT_EQ(spy->trace(), expected_states);
+}
+
+TEST(NoHeapTest, history_test)
+{
+    using namespace simple_history;
+    using Spy = FixedTracingSpy<Ctx, Evt>;
+
+    Ctx       ctx;
+    RootState root("RootState", ctx, nullptr);
+    ctx.m_root = &root;
+
+    std::shared_ptr<Spy>  spy = std::make_shared<Spy>();
+    SMTypes::StateMachine be("TestBackend", &root, spy);
+    bool                  init;
+    bool                  reinit;
+
+    {
+        HeapGuard guard;
+
+        init = be.init();
+
+        // Leave State21 as the history of State2
+        be.handleEvent(Evt::FIRST);
+        be.forceTransitionTo(&root.m_state1);
+        be.handleEvent(Evt::SECOND);
+        be.handleEvent(Evt::FIRST);
+        be.handleEvent(Evt::SECOND);
+        be.handleEvent(Evt::THIRD);
+        be.handleEvent(Evt::SEVENTH);
+        be.handleEvent(Evt::FIFTH);
+
+        // A second init() reuses the arena of the first one
+        reinit = be.init() && be.reset();
+    }
+
+    ASSERT_TRUE(init);
+    ASSERT_TRUE(reinit);
+
+    // Nothing is taken from the arena, which would run out long before the end
+    for (int i = 0; i < 10000; ++i)
+    {
+        ASSERT_EQ(be.getCurrentNodes(), std::vector<std::string>({"State1"}));
+    }
+}
+
+TEST(NoHeapTest, defaults_test)
+{
+    using namespace sm1;
+
+    Ctx       ctx;
+    RootState root("root", ctx, nullptr);
+    ctx.m_root = &root;
+
+    bool init;
+
+    {
+        HeapGuard guard;
+
+        // No spy, the inline queue and the inline arena
+        SMTypes::StateMachine be("TestBackend", &root);
+        init = be.init();
+
+        be.handleEvent(Evt::SECOND);
+        be.handleEvent(Evt::FIRST);
+    }
+
+    ASSERT_TRUE(init);
+}
+
+TEST(NoHeapTest, arena_overflow_test)
+{
+    using namespace sm1;
+    using Spy = FixedTracingSpy<Ctx, Evt>;
+
+    Ctx       ctx;
+    RootState root("root", ctx, nullptr);
+    ctx.m_root = &root;
+
+    std::shared_ptr<Spy>       spy = std::make_shared<Spy>();
+    roost::InlineResource<256> tiny;
+    SMTypes::StateMachine      be("TestBackend", &root, spy, nullptr, &tiny);
+
+    ASSERT_FALSE(be.init());
+    ASSERT_STREQ(spy->firstError(), "Out of memory, increase the size of the resource");
+    ASSERT_LE(tiny.peak(), tiny.capacity());
+}
+
+TEST(NoHeapTest, ring_fifo_test)
+{
+    roost::RingFifo<sm1::Evt, 2> fifo;
+
+    ASSERT_TRUE(fifo.push(sm1::Evt::FIRST));
+    ASSERT_TRUE(fifo.push(sm1::Evt::SECOND));
+    ASSERT_FALSE(fifo.push(sm1::Evt::THIRD));
+
+    ASSERT_EQ(fifo.front(), sm1::Evt::FIRST);
+    fifo.pop_front();
+    ASSERT_TRUE(fifo.push(sm1::Evt::THIRD));
+    ASSERT_EQ(fifo.front(), sm1::Evt::SECOND);
+    fifo.pop_front();
+    ASSERT_EQ(fifo.front(), sm1::Evt::THIRD);
+    fifo.pop_front();
+    ASSERT_TRUE(fifo.empty());
+}
+
+TEST(NoHeapTest, children_overflow_test)
+{
+    using namespace wide;
+    using Spy = FixedTracingSpy<Ctx, Evt>;
+
+    Ctx                   ctx;
+    RootState             root(ctx);
+    std::shared_ptr<Spy>  spy = std::make_shared<Spy>();
+    SMTypes::StateMachine be("TestBackend", &root, spy);
+
+    ASSERT_FALSE(be.init());
+    ASSERT_STREQ(spy->firstError(), "Too many children, increase ROOST_NO_HEAP_MAX_CHILDREN");
+}
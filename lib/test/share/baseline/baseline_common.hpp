@@ -0,0 +1,87 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROOST_BASELINE_COMMON_HPP
+#define ROOST_BASELINE_COMMON_HPP
+
+#include "roost/alias.hpp"
+
+#include <string>
+#include <vector>
+
+namespace baseline
+{
+
+/*!
+ * \brief Recorder is the on-entry/on-exit hook used by the hand-written baseline machines
+ *
+ * When a trace vector is supplied, hooks are recorded with the same OE-/OX- prefixes that the
+ * TracingSpy uses so that the baselines can be compared against their Roost HSM counterparts.
+ * Without a trace vector the hooks only cost a branch, which is the cost we want the benchmarks
+ * to compare against.
+ */
+class Recorder
+{
+public:
+    explicit Recorder(std::vector<std::string>* trace) : m_trace(trace)
+    {
+    }
+
+    void onEntry(const char* node_name)
+    {
+        if (m_trace)
+        {
+            m_trace->push_back(std::string("OE-") + node_name);
+        }
+    }
+
+    void onExit(const char* node_name)
+    {
+        if (m_trace)
+        {
+            m_trace->push_back(std::string("OX-") + node_name);
+        }
+    }
+
+private:
+    std::vector<std::string>* m_trace;
+};  // Class: Recorder
+
+/*!
+ * \brief Step is a single on-entry or on-exit hook within a flattened transition
+ */
+struct Step
+{
+    bool        entry;
+    const char* node_name;
+};  // Struct: Step
+
+/*!
+ * \brief Cell is one (state, event) entry of a flat state x event table
+ *
+ * The hooks executed by the transition are steps[first_step, first_step + num_steps).
+ */
+template <typename S>
+struct Cell
+{
+    S          next;
+    roost::u16 first_step;
+    roost::u16 num_steps;
+    bool       handled;
+    bool       action;
+};  // Struct: Cell
+
+}  // ns: baseline
+
+#endif  // ROOST_BASELINE_COMMON_HPP
@@ -0,0 +1,194 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sm1_baseline.hpp"
+
+#include <iostream>
+
+namespace sm1_baseline
+{
+
+namespace
+{
+
+const char* StateNames[] = {"sm1111", "sm1112", "sm1113"};
+
+const char* name(State s)
+{
+    return StateNames[static_cast<roost::u8>(s)];
+}
+
+const size_t NUM_STATES = 3;
+const size_t NUM_EVENTS = 4;
+
+// clang-format off
+
+const baseline::Step Steps[] = {
+    // Init
+    {true, "root"}, {true, "sm11"}, {true, "sm112"}, {false, "sm112"}, {true, "sm111"}, {true, "sm1111"},
+
+    // FIRST out of sm1111, sm1112 and sm1113 followed by the sm12211 completion transition
+    {false, "sm1111"}, {false, "sm111"}, {false, "sm11"}, {true, "sm12"}, {true, "sm122"},
+    {true, "sm1221"}, {true, "sm12211"}, {false, "sm12211"}, {false, "sm1221"}, {false, "sm122"},
+    {false, "sm12"}, {true, "sm11"}, {true, "sm111"}, {true, "sm1111"},
+
+    {false, "sm1112"}, {false, "sm111"}, {false, "sm11"}, {true, "sm12"}, {true, "sm122"},
+    {true, "sm1221"}, {true, "sm12211"}, {false, "sm12211"}, {false, "sm1221"}, {false, "sm122"},
+    {false, "sm12"}, {true, "sm11"}, {true, "sm111"}, {true, "sm1111"},
+
+    {false, "sm1113"}, {false, "sm111"}, {false, "sm11"}, {true, "sm12"}, {true, "sm122"},
+    {true, "sm1221"}, {true, "sm12211"}, {false, "sm12211"}, {false, "sm1221"}, {false, "sm122"},
+    {false, "sm12"}, {true, "sm11"}, {true, "sm111"}, {true, "sm1111"},
+};
+
+const baseline::Cell<State> Table[NUM_STATES][NUM_EVENTS] = {
+    // ROOST_NONE, FIRST, SECOND, THIRD
+    {{State::SM1111, 0, 0, false, false}, {State::SM1111, 6, 14, true, false},
+     {State::SM1111, 0, 0, true, true}, {State::SM1111, 0, 0, false, false}},
+
+    {{State::SM1112, 0, 0, false, false}, {State::SM1111, 20, 14, true, false},
+     {State::SM1112, 0, 0, true, true}, {State::SM1112, 0, 0, false, false}},
+
+    {{State::SM1113, 0, 0, false, false}, {State::SM1111, 34, 14, true, false},
+     {State::SM1113, 0, 0, true, true}, {State::SM1113, 0, 0, false, false}},
+};
+
+// clang-format on
+
+}  // ns: anonymous
+
+SwitchFsm::SwitchFsm(std::vector<std::string>* trace) : m_hooks(trace), m_state(State::SM1111)
+{
+}
+
+void SwitchFsm::init()
+{
+    m_hooks.onEntry("root");
+    m_hooks.onEntry("sm11");
+    m_hooks.onEntry("sm112");
+
+    // Completion transition sm112 -> sm111
+    m_hooks.onExit("sm112");
+    m_hooks.onEntry("sm111");
+    m_hooks.onEntry("sm1111");
+
+    m_state = State::SM1111;
+}
+
+bool SwitchFsm::handleEvent(sm1::Evt e)
+{
+    switch (m_state)
+    {
+        case State::SM1111:
+        case State::SM1112:
+        case State::SM1113:
+
+            switch (e)
+            {
+                case sm1::Evt::FIRST:
+                    m_hooks.onExit(name(m_state));
+                    m_hooks.onExit("sm111");
+                    m_hooks.onExit("sm11");
+                    m_hooks.onEntry("sm12");
+                    m_hooks.onEntry("sm122");
+                    m_hooks.onEntry("sm1221");
+                    m_hooks.onEntry("sm12211");
+
+                    // Completion transition sm12211 -> sm111
+                    m_hooks.onExit("sm12211");
+                    m_hooks.onExit("sm1221");
+                    m_hooks.onExit("sm122");
+                    m_hooks.onExit("sm12");
+                    m_hooks.onEntry("sm11");
+                    m_hooks.onEntry("sm111");
+                    m_hooks.onEntry("sm1111");
+
+                    m_state = State::SM1111;
+                    return true;
+
+                case sm1::Evt::SECOND:
+                    printSomething();
+                    return true;
+
+                default:
+                    return false;
+            }
+    }
+
+    return false;
+}
+
+std::vector<std::string> SwitchFsm::getCurrentNodes() const
+{
+    return {name(m_state)};
+}
+
+void SwitchFsm::printSomething()
+{
+    std::cout << "Something" << std::endl;
+}
+
+TableFsm::TableFsm(std::vector<std::string>* trace) : m_hooks(trace), m_state(State::SM1111)
+{
+}
+
+void TableFsm::init()
+{
+    for (size_t i = 0; i < 6; ++i)
+    {
+        Steps[i].entry ? m_hooks.onEntry(Steps[i].node_name) : m_hooks.onExit(Steps[i].node_name);
+    }
+
+    m_state = State::SM1111;
+}
+
+bool TableFsm::handleEvent(sm1::Evt e)
+{
+    size_t idx = static_cast<size_t>(e);
+
+    if (idx >= NUM_EVENTS)
+    {
+        return false;
+    }
+
+    const baseline::Cell<State>& cell = Table[static_cast<roost::u8>(m_state)][idx];
+
+    if (cell.action)
+    {
+        printSomething();
+    }
+
+    const baseline::Step* step = &Steps[cell.first_step];
+    const baseline::Step* end  = step + cell.num_steps;
+
+    for (; step != end; ++step)
+    {
+        step->entry ? m_hooks.onEntry(step->node_name) : m_hooks.onExit(step->node_name);
+    }
+
+    m_state = cell.next;
+    return cell.handled;
+}
+
+std::vector<std::string> TableFsm::getCurrentNodes() const
+{
+    return {name(m_state)};
+}
+
+void TableFsm::printSomething()
+{
+    std::cout << "Something" << std::endl;
+}
+
+}  // ns: sm1_baseline
@@ -0,0 +1,84 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROOST_SM1_BASELINE_HPP
+#define ROOST_SM1_BASELINE_HPP
+
+#include "baseline/baseline_common.hpp"
+#include "sm1/sm1_common.hpp"
+
+namespace sm1_baseline
+{
+
+//! The leaf states of sm1 that the machine can rest in
+enum class State : roost::u8
+{
+    SM1111,
+    SM1112,
+    SM1113
+};
+
+/*!
+ * \brief SwitchFsm is a hand-written nested switch implementation of the sm1 machine
+ *
+ * It produces the same on-entry/on-exit sequence and current node as sm1::RootState driven by
+ * a StateMachine, including the completion transitions out of sm112 and sm12211.
+ */
+class SwitchFsm
+{
+public:
+    explicit SwitchFsm(std::vector<std::string>* trace = nullptr);
+
+    void init();
+
+    //! Returns true if the event was handled, otherwise false
+    bool handleEvent(sm1::Evt e);
+
+    std::vector<std::string> getCurrentNodes() const;
+
+private:
+    void printSomething();
+
+    baseline::Recorder m_hooks;
+    State              m_state;
+};  // Class: SwitchFsm
+
+/*!
+ * \brief TableFsm is a flat state x event table implementation of the sm1 machine
+ *
+ * Every cell holds the resulting state and the pre-computed hook sequence of the transition
+ * (completion transitions included), so dispatch is a single table index.
+ */
+class TableFsm
+{
+public:
+    explicit TableFsm(std::vector<std::string>* trace = nullptr);
+
+    void init();
+
+    //! Returns true if the event was handled, otherwise false
+    bool handleEvent(sm1::Evt e);
+
+    std::vector<std::string> getCurrentNodes() const;
+
+private:
+    void printSomething();
+
+    baseline::Recorder m_hooks;
+    State              m_state;
+};  // Class: TableFsm
+
+}  // ns: sm1_baseline
+
+#endif  // ROOST_SM1_BASELINE_HPP
@@ -0,0 +1,764 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sm2_baseline.hpp"
+
+namespace sm2_baseline
+{
+
+namespace
+{
+
+const size_t NUM_CONFIGS = 10;
+const size_t NUM_EVENTS  = 6;
+const size_t MAX_NODES   = 6;
+
+using C = TableFsm::Config;
+
+// clang-format off
+
+const char* ConfigNodes[NUM_CONFIGS][MAX_NODES] = {
+    {"s12"},
+    {"s11", "s1111", "s11211", "sb", "sd", "se"},
+    {"s11", "s11122", "s11211"},
+    {"s13"},
+    {"s11", "s11122", "s11212"},
+    {"s11", "s1111", "s11212", "sb", "sd", "se"},
+    {"s11", "s1111", "s11211", "sb", "sc", "se"},
+    {"s11", "s11121", "s11212"},
+    {"s11", "s1111", "s11212", "sb", "sc", "se"},
+    {"s11", "s11121", "s11211"},
+};
+
+const baseline::Step Steps[] = {
+    // Init
+    {true, "root"}, {true, "s12"},
+
+    // forceTransitionTo(se) from s12
+    {false, "s12"}, {true, "s11"}, {true, "s1121"}, {true, "s11211"}, {true, "s1111"}, {true, "sb"},
+    {true, "sd"}, {true, "se"},
+
+    // OX-s12 OE-s11 OE-s1112 OE-s11122 OE-s1121 OE-s11211
+    {false, "s12"},
+    {true, "s11"},
+    {true, "s1112"},
+    {true, "s11122"},
+    {true, "s1121"},
+    {true, "s11211"},
+    // OX-sb OX-sd OX-se OX-s1111 OX-s11211 OX-s1121 OX-s11 OE-s13
+    {false, "sb"},
+    {false, "sd"},
+    {false, "se"},
+    {false, "s1111"},
+    {false, "s11211"},
+    {false, "s1121"},
+    {false, "s11"},
+    {true, "s13"},
+    // OX-sb OE-sa OX-sa OX-sd OX-se OX-s1111 OE-s1112 OE-s11122 OX-s11211 OE-s11212
+    {false, "sb"},
+    {true, "sa"},
+    {false, "sa"},
+    {false, "sd"},
+    {false, "se"},
+    {false, "s1111"},
+    {true, "s1112"},
+    {true, "s11122"},
+    {false, "s11211"},
+    {true, "s11212"},
+    // OX-sb OE-sa OX-sa OX-sd OX-se OX-s1111 OE-s1112 OE-s11122
+    {false, "sb"},
+    {true, "sa"},
+    {false, "sa"},
+    {false, "sd"},
+    {false, "se"},
+    {false, "s1111"},
+    {true, "s1112"},
+    {true, "s11122"},
+    // OX-sb OX-sd OX-se OX-s1111 OX-s11211 OX-s1121 OX-s11 OE-s11 OE-s1112 OE-s11122 OE-s1121 OE-s11211
+    {false, "sb"},
+    {false, "sd"},
+    {false, "se"},
+    {false, "s1111"},
+    {false, "s11211"},
+    {false, "s1121"},
+    {false, "s11"},
+    {true, "s11"},
+    {true, "s1112"},
+    {true, "s11122"},
+    {true, "s1121"},
+    {true, "s11211"},
+    // OX-s11122 OX-s1112 OX-s11211 OX-s1121 OX-s11 OE-s13
+    {false, "s11122"},
+    {false, "s1112"},
+    {false, "s11211"},
+    {false, "s1121"},
+    {false, "s11"},
+    {true, "s13"},
+    // OX-s11122 OX-s1112 OE-s1111 OE-sb OE-sd OE-se OX-s11211 OE-s11212
+    {false, "s11122"},
+    {false, "s1112"},
+    {true, "s1111"},
+    {true, "sb"},
+    {true, "sd"},
+    {true, "se"},
+    {false, "s11211"},
+    {true, "s11212"},
+    // OX-s11122 OX-s1112 OX-s11211 OX-s1121 OX-s11 OE-s11 OE-s1112 OE-s11122 OE-s1121 OE-s11211
+    {false, "s11122"},
+    {false, "s1112"},
+    {false, "s11211"},
+    {false, "s1121"},
+    {false, "s11"},
+    {true, "s11"},
+    {true, "s1112"},
+    {true, "s11122"},
+    {true, "s1121"},
+    {true, "s11211"},
+    // OX-s13 OE-s11 OE-s1121 OE-s11211 OE-s1111 OE-sb OE-se OE-sc
+    {false, "s13"},
+    {true, "s11"},
+    {true, "s1121"},
+    {true, "s11211"},
+    {true, "s1111"},
+    {true, "sb"},
+    {true, "se"},
+    {true, "sc"},
+    // OX-s13 OE-s11 OE-s1112 OE-s11122 OE-s1121 OE-s11211
+    {false, "s13"},
+    {true, "s11"},
+    {true, "s1112"},
+    {true, "s11122"},
+    {true, "s1121"},
+    {true, "s11211"},
+    // OX-s11122 OX-s1112 OE-s1111 OE-sb OE-sd OE-se
+    {false, "s11122"},
+    {false, "s1112"},
+    {true, "s1111"},
+    {true, "sb"},
+    {true, "sd"},
+    {true, "se"},
+    // OX-s11212 OE-s11211
+    {false, "s11212"},
+    {true, "s11211"},
+    // OX-sb OE-sa OX-sa OX-sd OX-se OX-s1111 OE-s1112 OE-s11122 OX-s11212 OE-s11211
+    {false, "sb"},
+    {true, "sa"},
+    {false, "sa"},
+    {false, "sd"},
+    {false, "se"},
+    {false, "s1111"},
+    {true, "s1112"},
+    {true, "s11122"},
+    {false, "s11212"},
+    {true, "s11211"},
+    // OX-sb OX-sc OX-se OX-s1111 OX-s11211 OX-s1121 OX-s11 OE-s13
+    {false, "sb"},
+    {false, "sc"},
+    {false, "se"},
+    {false, "s1111"},
+    {false, "s11211"},
+    {false, "s1121"},
+    {false, "s11"},
+    {true, "s13"},
+    // OX-sb OE-sa OX-sa OX-sc OX-se OX-s1111 OE-s1112 OE-s11121 OX-s11211 OE-s11212
+    {false, "sb"},
+    {true, "sa"},
+    {false, "sa"},
+    {false, "sc"},
+    {false, "se"},
+    {false, "s1111"},
+    {true, "s1112"},
+    {true, "s11121"},
+    {false, "s11211"},
+    {true, "s11212"},
+    // OX-sb OE-sa OX-sa OX-sc OX-se OX-s1111 OX-s11211 OX-s1121 OX-s11 OE-s13
+    {false, "sb"},
+    {true, "sa"},
+    {false, "sa"},
+    {false, "sc"},
+    {false, "se"},
+    {false, "s1111"},
+    {false, "s11211"},
+    {false, "s1121"},
+    {false, "s11"},
+    {true, "s13"},
+    // OX-sb OX-sc OX-se OX-s1111 OX-s11211 OX-s1121 OX-s11 OE-s11 OE-s1112 OE-s11122 OE-s1121 OE-s11211
+    {false, "sb"},
+    {false, "sc"},
+    {false, "se"},
+    {false, "s1111"},
+    {false, "s11211"},
+    {false, "s1121"},
+    {false, "s11"},
+    {true, "s11"},
+    {true, "s1112"},
+    {true, "s11122"},
+    {true, "s1121"},
+    {true, "s11211"},
+    // OX-s11121 OX-s1112 OE-s1111 OE-sb OE-sd OE-se
+    {false, "s11121"},
+    {false, "s1112"},
+    {true, "s1111"},
+    {true, "sb"},
+    {true, "sd"},
+    {true, "se"},
+    // OX-s11121 OX-s1112 OE-s1111 OE-sb OE-se OE-sc
+    {false, "s11121"},
+    {false, "s1112"},
+    {true, "s1111"},
+    {true, "sb"},
+    {true, "se"},
+    {true, "sc"},
+    // OX-sb OE-sa OX-sa OX-sc OX-se OX-s1111 OE-s1112 OE-s11121
+    {false, "sb"},
+    {true, "sa"},
+    {false, "sa"},
+    {false, "sc"},
+    {false, "se"},
+    {false, "s1111"},
+    {true, "s1112"},
+    {true, "s11121"},
+    // OX-sb OE-sa OX-sa OX-sc OX-se OX-s1111 OX-s11212 OX-s1121 OX-s11 OE-s13
+    {false, "sb"},
+    {true, "sa"},
+    {false, "sa"},
+    {false, "sc"},
+    {false, "se"},
+    {false, "s1111"},
+    {false, "s11212"},
+    {false, "s1121"},
+    {false, "s11"},
+    {true, "s13"},
+    // OX-s11121 OX-s1112 OX-s11211 OX-s1121 OX-s11 OE-s13
+    {false, "s11121"},
+    {false, "s1112"},
+    {false, "s11211"},
+    {false, "s1121"},
+    {false, "s11"},
+    {true, "s13"},
+    // OX-s11121 OX-s1112 OE-s1111 OE-sb OE-sd OE-se OX-s11211 OE-s11212
+    {false, "s11121"},
+    {false, "s1112"},
+    {true, "s1111"},
+    {true, "sb"},
+    {true, "sd"},
+    {true, "se"},
+    {false, "s11211"},
+    {true, "s11212"},
+    // OX-s11121 OX-s1112 OX-s11211 OX-s1121 OX-s11 OE-s11 OE-s1112 OE-s11122 OE-s1121 OE-s11211
+    {false, "s11121"},
+    {false, "s1112"},
+    {false, "s11211"},
+    {false, "s1121"},
+    {false, "s11"},
+    {true, "s11"},
+    {true, "s1112"},
+    {true, "s11122"},
+    {true, "s1121"},
+    {true, "s11211"},
+};
+
+// Each cell is {next, first_step, num_steps, handled, toggle}
+const baseline::Cell<C> Table[NUM_CONFIGS][NUM_EVENTS] = {
+    // ROOST_NONE, FIRST, SECOND, THIRD, FOURTH, FIFTH
+    // S12
+    {{C::S12, 0, 0, false, false},
+     {C::S11_S11122_S11211, 10, 6, true, false},
+     {C::S12, 0, 0, false, false},
+     {C::S12, 0, 0, false, false},
+     {C::S12, 0, 0, false, false},
+     {C::S12, 0, 0, false, false}},
+    // S11_S1111_S11211_SB_SD_SE
+    {{C::S11_S1111_S11211_SB_SD_SE, 0, 0, false, false},
+     {C::S13, 16, 8, true, false},
+     {C::S11_S11122_S11212, 24, 10, true, false},
+     {C::S11_S1111_S11211_SB_SD_SE, 0, 0, false, false},
+     {C::S11_S11122_S11211, 34, 8, true, false},
+     {C::S11_S11122_S11211, 42, 12, true, true}},
+    // S11_S11122_S11211
+    {{C::S11_S11122_S11211, 0, 0, false, false},
+     {C::S13, 54, 6, true, false},
+     {C::S11_S1111_S11212_SB_SD_SE, 60, 8, true, false},
+     {C::S11_S11122_S11211, 0, 0, false, false},
+     {C::S11_S11122_S11211, 0, 0, false, false},
+     {C::S11_S11122_S11211, 68, 10, true, true}},
+    // S13
+    {{C::S13, 0, 0, false, false},
+     {C::S11_S1111_S11211_SB_SC_SE, 78, 8, true, false},
+     {C::S13, 0, 0, false, false},
+     {C::S13, 0, 0, true, false},
+     {C::S11_S11122_S11211, 86, 6, true, false},
+     {C::S13, 0, 0, false, false}},
+    // S11_S11122_S11212
+    {{C::S11_S11122_S11212, 0, 0, false, false},
+     {C::S11_S11122_S11212, 0, 0, false, false},
+     {C::S11_S1111_S11212_SB_SD_SE, 92, 6, true, false},
+     {C::S11_S11122_S11212, 0, 0, false, false},
+     {C::S11_S11122_S11211, 98, 2, true, false},
+     {C::S11_S11122_S11212, 0, 0, false, false}},
+    // S11_S1111_S11212_SB_SD_SE
+    {{C::S11_S1111_S11212_SB_SD_SE, 0, 0, false, false},
+     {C::S11_S1111_S11212_SB_SD_SE, 0, 0, false, false},
+     {C::S11_S11122_S11212, 34, 8, true, false},
+     {C::S11_S1111_S11212_SB_SD_SE, 0, 0, false, false},
+     {C::S11_S11122_S11211, 100, 10, true, false},
+     {C::S11_S1111_S11212_SB_SD_SE, 0, 0, false, false}},
+    // S11_S1111_S11211_SB_SC_SE
+    {{C::S11_S1111_S11211_SB_SC_SE, 0, 0, false, false},
+     {C::S13, 110, 8, true, false},
+     {C::S11_S11121_S11212, 118, 10, true, false},
+     {C::S11_S1111_S11211_SB_SC_SE, 0, 0, false, false},
+     {C::S13, 128, 10, true, false},
+     {C::S11_S11122_S11211, 138, 12, true, true}},
+    // S11_S11121_S11212
+    {{C::S11_S11121_S11212, 0, 0, false, false},
+     {C::S11_S11121_S11212, 0, 0, false, false},
+     {C::S11_S1111_S11212_SB_SD_SE, 150, 6, true, false},
+     {C::S11_S1111_S11212_SB_SC_SE, 156, 6, true, false},
+     {C::S11_S11121_S11211, 98, 2, true, false},
+     {C::S11_S11121_S11212, 0, 0, false, false}},
+    // S11_S1111_S11212_SB_SC_SE
+    {{C::S11_S1111_S11212_SB_SC_SE, 0, 0, false, false},
+     {C::S11_S1111_S11212_SB_SC_SE, 0, 0, false, false},
+     {C::S11_S11121_S11212, 162, 8, true, false},
+     {C::S11_S1111_S11212_SB_SC_SE, 0, 0, false, false},
+     {C::S13, 170, 10, true, false},
+     {C::S11_S1111_S11212_SB_SC_SE, 0, 0, false, false}},
+    // S11_S11121_S11211
+    {{C::S11_S11121_S11211, 0, 0, false, false},
+     {C::S13, 180, 6, true, false},
+     {C::S11_S1111_S11212_SB_SD_SE, 186, 8, true, false},
+     {C::S11_S1111_S11211_SB_SC_SE, 156, 6, true, false},
+     {C::S11_S11121_S11211, 0, 0, false, false},
+     {C::S11_S11122_S11211, 194, 10, true, true}},
+};
+
+// clang-format on
+
+}  // ns: anonymous
+
+SwitchFsm::SwitchFsm(std::vector<std::string>* trace)
+    : m_hooks(trace),
+      m_s1(S1::S12),
+      m_s111(S111::S11122),
+      m_s1121(S1121::S11211),
+      m_sa(false),
+      m_sc(false),
+      m_se(true),
+      m_toggle(false)
+{
+}
+
+void SwitchFsm::init()
+{
+    m_hooks.onEntry("root");
+    m_hooks.onEntry("s12");
+    m_s1 = S1::S12;
+}
+
+void SwitchFsm::forceToSe()
+{
+    switch (m_s1)
+    {
+        case S1::S11:
+            exitS11();
+            break;
+        case S1::S12:
+            m_hooks.onExit("s12");
+            break;
+        case S1::S13:
+            m_hooks.onExit("s13");
+            break;
+    }
+
+    // Entering s11 through region s111 constructs region s112 first
+    m_hooks.onEntry("s11");
+    m_hooks.onEntry("s1121");
+    m_hooks.onEntry("s11211");
+    m_s1121 = S1121::S11211;
+
+    m_hooks.onEntry("s1111");
+    m_hooks.onEntry("sb");
+    m_hooks.onEntry("sd");
+    m_hooks.onEntry("se");
+    m_s111 = S111::S1111;
+    m_sa   = false;
+    m_sc   = false;
+    m_se   = true;
+
+    m_s1 = S1::S11;
+}
+
+bool SwitchFsm::handleEvent(sm2::Evt e)
+{
+    switch (m_s1)
+    {
+        case S1::S12:
+
+            if (e == sm2::Evt::FIRST)
+            {
+                m_hooks.onExit("s12");
+                enterS11();
+                return true;
+            }
+
+            return false;
+
+        case S1::S13:
+
+            switch (e)
+            {
+                case sm2::Evt::FIRST:
+                    // Entering sc in region s11112 constructs the other regions along the way
+                    m_hooks.onExit("s13");
+                    m_hooks.onEntry("s11");
+                    m_hooks.onEntry("s1121");
+                    m_hooks.onEntry("s11211");
+                    m_hooks.onEntry("s1111");
+                    m_hooks.onEntry("sb");
+                    m_hooks.onEntry("se");
+                    m_hooks.onEntry("sc");
+
+                    m_s1    = S1::S11;
+                    m_s1121 = S1121::S11211;
+                    m_s111  = S111::S1111;
+                    m_sa    = false;
+                    m_sc    = true;
+                    m_se    = true;
+                    return true;
+
+                case sm2::Evt::THIRD:
+                    // Internal transition
+                    return true;
+
+                case sm2::Evt::FOURTH:
+                    m_hooks.onExit("s13");
+                    enterS11();
+                    return true;
+
+                default:
+                    return false;
+            }
+
+        case S1::S11:
+            break;
+    }
+
+    // Otherwise we are in the orthogonal state s11.  Region s111 is always handled before
+    // region s112, and within s1111 the regions are handled in the order s11111, s11112, s11113.
+
+    bool handled{false};
+
+    switch (e)
+    {
+        case sm2::Evt::FIRST:
+
+            if (m_s1121 == S1121::S11211)
+            {
+                exitS11();
+                m_hooks.onEntry("s13");
+                m_s1 = S1::S13;
+                return true;
+            }
+
+            return false;
+
+        case sm2::Evt::SECOND:
+
+            if (m_s111 == S111::S1111)
+            {
+                bool sb{!m_sa};
+                bool sc{m_sc};
+                bool se{m_se};
+
+                if (sb)
+                {
+                    m_hooks.onExit("sb");
+                    m_hooks.onEntry("sa");
+                    m_sa = true;
+                }
+
+                // sc and se both leave s1111, so only the first of them is taken
+                if (sc)
+                {
+                    exitS1111();
+                    enterS1112(S111::S11121);
+                }
+                else if (se)
+                {
+                    exitS1111();
+                    enterS1112(S111::S11122);
+                }
+
+                handled = sb || sc || se;
+            }
+            else
+            {
+                exitS1112();
+                enterS1111();
+                handled = true;
+            }
+
+            if (m_s1121 == S1121::S11211)
+            {
+                m_hooks.onExit("s11211");
+                m_hooks.onEntry("s11212");
+                m_s1121 = S1121::S11212;
+                handled = true;
+            }
+
+            return handled;
+
+        case sm2::Evt::THIRD:
+
+            if (m_s111 == S111::S11121)
+            {
+                exitS1112();
+                m_hooks.onEntry("s1111");
+                m_hooks.onEntry("sb");
+                m_hooks.onEntry("se");
+                m_hooks.onEntry("sc");
+
+                m_s111 = S111::S1111;
+                m_sa   = false;
+                m_sc   = true;
+                m_se   = true;
+                return true;
+            }
+
+            return false;
+
+        case sm2::Evt::FOURTH:
+
+            if (m_s111 == S111::S1111)
+            {
+                bool sb{!m_sa};
+                bool sc{m_sc};
+                bool se{m_se};
+
+                if (sb)
+                {
+                    m_hooks.onExit("sb");
+                    m_hooks.onEntry("sa");
+                    m_sa    = true;
+                    handled = true;
+                }
+
+                if (sc)
+                {
+                    // Leaves s11 entirely, which discards every other transition
+                    exitS11();
+                    m_hooks.onEntry("s13");
+                    m_s1 = S1::S13;
+                    return true;
+                }
+
+                if (se)
+                {
+                    exitS1111();
+                    enterS1112(S111::S11122);
+                    handled = true;
+                }
+            }
+
+            if (m_s1121 == S1121::S11212)
+            {
+                m_hooks.onExit("s11212");
+                m_hooks.onEntry("s11211");
+                m_s1121 = S1121::S11211;
+                handled = true;
+            }
+
+            return handled;
+
+        case sm2::Evt::FIFTH:
+
+            if (m_s1121 == S1121::S11211)
+            {
+                // Both FIFTH rows have s11 as their LCA and are turned into a self transition
+                m_toggle = !m_toggle;
+                exitS11();
+                enterS11();
+                return true;
+            }
+
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+std::vector<std::string> SwitchFsm::getCurrentNodes() const
+{
+    static const char* S111Names[]  = {"s1111", "s11121", "s11122"};
+    static const char* S1121Names[] = {"s11211", "s11212"};
+
+    switch (m_s1)
+    {
+        case S1::S12:
+            return {"s12"};
+        case S1::S13:
+            return {"s13"};
+        case S1::S11:
+            break;
+    }
+
+    std::vector<std::string> rval = {"s11",
+                                     S111Names[static_cast<roost::u8>(m_s111)],
+                                     S1121Names[static_cast<roost::u8>(m_s1121)]};
+
+    if (m_s111 == S111::S1111)
+    {
+        rval.push_back(m_sa ? "sa" : "sb");
+        rval.push_back(m_sc ? "sc" : "sd");
+        rval.push_back(m_se ? "se" : "sf");
+    }
+
+    return rval;
+}
+
+void SwitchFsm::enterS11()
+{
+    m_hooks.onEntry("s11");
+    enterS1112(S111::S11122);
+    m_hooks.onEntry("s1121");
+    m_hooks.onEntry("s11211");
+
+    m_s1    = S1::S11;
+    m_s1121 = S1121::S11211;
+}
+
+void SwitchFsm::exitS11()
+{
+    if (m_s111 == S111::S1111)
+    {
+        exitS1111();
+    }
+    else
+    {
+        exitS1112();
+    }
+
+    m_hooks.onExit(m_s1121 == S1121::S11211 ? "s11211" : "s11212");
+    m_hooks.onExit("s1121");
+    m_hooks.onExit("s11");
+}
+
+void SwitchFsm::enterS1111()
+{
+    m_hooks.onEntry("s1111");
+    m_hooks.onEntry("sb");
+    m_hooks.onEntry("sd");
+    m_hooks.onEntry("se");
+
+    m_s111 = S111::S1111;
+    m_sa   = false;
+    m_sc   = false;
+    m_se   = true;
+}
+
+void SwitchFsm::exitS1111()
+{
+    m_hooks.onExit(m_sa ? "sa" : "sb");
+    m_hooks.onExit(m_sc ? "sc" : "sd");
+    m_hooks.onExit(m_se ? "se" : "sf");
+    m_hooks.onExit("s1111");
+}
+
+void SwitchFsm::enterS1112(S111 child)
+{
+    m_hooks.onEntry("s1112");
+    m_hooks.onEntry(child == S111::S11121 ? "s11121" : "s11122");
+    m_s111 = child;
+}
+
+void SwitchFsm::exitS1112()
+{
+    m_hooks.onExit(m_s111 == S111::S11121 ? "s11121" : "s11122");
+    m_hooks.onExit("s1112");
+}
+
+TableFsm::TableFsm(std::vector<std::string>* trace)
+    : m_hooks(trace), m_config(Config::S12), m_toggle(false)
+{
+}
+
+void TableFsm::init()
+{
+    m_hooks.onEntry(Steps[0].node_name);
+    m_hooks.onEntry(Steps[1].node_name);
+    m_config = Config::S12;
+}
+
+void TableFsm::forceToSe()
+{
+    if (m_config != Config::S12)
+    {
+        // Only the forced transition out of the initial configuration is tabled
+        return;
+    }
+
+    for (size_t i = 2; i < 10; ++i)
+    {
+        Steps[i].entry ? m_hooks.onEntry(Steps[i].node_name) : m_hooks.onExit(Steps[i].node_name);
+    }
+
+    m_config = Config::S11_S1111_S11211_SB_SD_SE;
+}
+
+bool TableFsm::handleEvent(sm2::Evt e)
+{
+    size_t idx = static_cast<size_t>(e);
+
+    if (idx >= NUM_EVENTS)
+    {
+        return false;
+    }
+
+    const baseline::Cell<C>& cell = Table[static_cast<roost::u8>(m_config)][idx];
+
+    if (cell.action)
+    {
+        m_toggle = !m_toggle;
+    }
+
+    const baseline::Step* step = &Steps[cell.first_step];
+    const baseline::Step* end  = step + cell.num_steps;
+
+    for (; step != end; ++step)
+    {
+        step->entry ? m_hooks.onEntry(step->node_name) : m_hooks.onExit(step->node_name);
+    }
+
+    m_config = cell.next;
+    return cell.handled;
+}
+
+std::vector<std::string> TableFsm::getCurrentNodes() const
+{
+    std::vector<std::string> rval;
+
+    for (const char* node : ConfigNodes[static_cast<roost::u8>(m_config)])
+    {
+        if (node)
+        {
+            rval.push_back(node);
+        }
+    }
+
+    return rval;
+}
+
+}  // ns: sm2_baseline
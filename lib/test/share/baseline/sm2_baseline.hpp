@@ -0,0 +1,129 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROOST_SM2_BASELINE_HPP
+#define ROOST_SM2_BASELINE_HPP
+
+#include "baseline/baseline_common.hpp"
+#include "sm2/sm2_common.hpp"
+
+namespace sm2_baseline
+{
+
+/*!
+ * \brief SwitchFsm is a hand-written nested switch implementation of the sm2 machine
+ *
+ * Each orthogonal region keeps its own state variable, and each event is handled by a switch
+ * over the active states that applies the same region ordering and transition conflict rules
+ * as the StateMachine.
+ */
+class SwitchFsm
+{
+public:
+    explicit SwitchFsm(std::vector<std::string>* trace = nullptr);
+
+    void init();
+
+    //! Places the machine in the same configuration as StateMachine::forceTransitionTo(se)
+    void forceToSe();
+
+    //! Returns true if the event was handled, otherwise false
+    bool handleEvent(sm2::Evt e);
+
+    std::vector<std::string> getCurrentNodes() const;
+
+private:
+    enum class S1 : roost::u8
+    {
+        S11,
+        S12,
+        S13
+    };
+
+    enum class S111 : roost::u8
+    {
+        S1111,
+        S11121,
+        S11122
+    };
+
+    enum class S1121 : roost::u8
+    {
+        S11211,
+        S11212
+    };
+
+    void enterS11();
+    void exitS11();
+    void enterS1111();
+    void exitS1111();
+    void enterS1112(S111 child);
+    void exitS1112();
+
+    baseline::Recorder m_hooks;
+
+    S1    m_s1;      //!< Active child of the root state
+    S111  m_s111;    //!< Active node of region s111 (s1111 or a child of s1112)
+    S1121 m_s1121;   //!< Active child of s1121 in region s112
+    bool  m_sa;      //!< Region s11111: true for sa, false for sb
+    bool  m_sc;      //!< Region s11112: true for sc, false for sd
+    bool  m_se;      //!< Region s11113: true for se, false for sf
+    bool  m_toggle;  //!< The s11211 toggle used by the FIFTH guards
+};  // Class: SwitchFsm
+
+/*!
+ * \brief TableFsm is a flat configuration x event table implementation of the sm2 machine
+ *
+ * Orthogonal regions are flattened into the reachable configurations of the whole machine, and
+ * every cell holds the next configuration together with its pre-computed hook sequence.
+ */
+class TableFsm
+{
+public:
+    explicit TableFsm(std::vector<std::string>* trace = nullptr);
+
+    void init();
+
+    //! Same as StateMachine::forceTransitionTo(se), only tabled for the initial configuration
+    void forceToSe();
+
+    //! Returns true if the event was handled, otherwise false
+    bool handleEvent(sm2::Evt e);
+
+    std::vector<std::string> getCurrentNodes() const;
+
+    enum class Config : roost::u8
+    {
+        S12,
+        S11_S1111_S11211_SB_SD_SE,
+        S11_S11122_S11211,
+        S13,
+        S11_S11122_S11212,
+        S11_S1111_S11212_SB_SD_SE,
+        S11_S1111_S11211_SB_SC_SE,
+        S11_S11121_S11212,
+        S11_S1111_S11212_SB_SC_SE,
+        S11_S11121_S11211
+    };
+
+private:
+    baseline::Recorder m_hooks;
+
+    Config m_config;
+    bool   m_toggle;
+};  // Class: TableFsm
+
+}  // ns: sm2_baseline
+
+#endif  // ROOST_SM2_BASELINE_HPP
@@ -0,0 +1,126 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROOST_SIMPLE_HISTORY_STATIC_HPP
+#define ROOST_SIMPLE_HISTORY_STATIC_HPP
+
+#include "roost/static_machine.hpp"
+#include "simple_history_common.hpp"
+
+// The simple_history machine declared as types for a StaticMachine, see simple_history.hpp and
+// simple_history.cpp
+
+namespace simple_history_static
+{
+
+using simple_history::Ctx;
+using simple_history::Evt;
+
+using STypes = roost::StaticAlias<Ctx, Evt>;
+
+struct Root;
+struct State1;
+struct State2;
+struct State21;
+struct State211;
+struct State212;
+struct State22;
+
+struct Root : STypes::State<void, State1>
+{
+    static const char* name()
+    {
+        return "root";
+    }
+};
+
+struct State1 : STypes::State<Root>
+{
+    static const char* name()
+    {
+        return "State1";
+    }
+};
+
+struct State2 : STypes::State<Root, State22>
+{
+    static const char* name()
+    {
+        return "State2";
+    }
+};
+
+struct State21 : STypes::State<State2, State211>
+{
+    static const char* name()
+    {
+        return "State21";
+    }
+};
+
+struct State211 : STypes::State<State21>
+{
+    static const char* name()
+    {
+        return "State211";
+    }
+};
+
+struct State212 : STypes::State<State21>
+{
+    static const char* name()
+    {
+        return "State212";
+    }
+};
+
+struct State22 : STypes::State<State2>
+{
+    static const char* name()
+    {
+        return "State22";
+    }
+};
+
+ROOST_STATIC_GUARD(UseShallowHistory, !ctx.use_deep_history);
+ROOST_STATIC_GUARD(UseDeepHistory, ctx.use_deep_history);
+
+using NoActions     = roost::StaticActions<>;
+using ShallowState2 = roost::StaticShallowHistory<State2>;
+using DeepState2    = roost::StaticDeepHistory<State2>;
+
+// clang-format off
+
+using Table = roost::StaticTable<
+        STypes::Row<State1,   Evt::FIRST,   State2>,
+        STypes::Row<State1,   Evt::FIFTH,   ShallowState2, NoActions, UseShallowHistory>,
+        STypes::Row<State1,   Evt::FIFTH,   DeepState2,    NoActions, UseDeepHistory>,
+        STypes::Row<State1,   Evt::SECOND,  State1>,
+        STypes::Row<State22,  Evt::SECOND,  State21>,
+        STypes::Row<State21,  Evt::SIXTH,   State1>,
+        STypes::Row<State211, Evt::THIRD,   State212>,
+        STypes::Row<State212, Evt::FOURTH,  State211>,
+        STypes::Row<State212, Evt::SEVENTH, State1>>;
+
+// clang-format on
+
+using States = roost::StaticStates<Root, State1, State2, State21, State211, State212, State22>;
+
+template <typename SPY = roost::StaticNoSpy>
+using Machine = STypes::Machine<States, Table, SPY>;
+
+}  // ns: simple_history_static
+
+#endif  // ROOST_SIMPLE_HISTORY_STATIC_HPP
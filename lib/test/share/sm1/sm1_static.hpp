@@ -0,0 +1,167 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROOST_SM1_STATIC_HPP
+#define ROOST_SM1_STATIC_HPP
+
+#include "roost/static_machine.hpp"
+#include "sm1_common.hpp"
+
+#include <iostream>
+
+// The sm1 machine declared as types for a StaticMachine, see sm1.hpp and sm1.cpp
+
+namespace sm1_static
+{
+
+using sm1::Ctx;
+using sm1::Evt;
+
+using STypes = roost::StaticAlias<Ctx, Evt>;
+
+struct Root;
+struct SM11;
+struct SM111;
+template <int N>
+struct SM111x;
+struct SM112;
+struct SM12;
+struct SM121;
+struct SM122;
+struct SM1221;
+struct SM12211;
+
+struct Root : STypes::State<void, SM11>
+{
+    static const char* name()
+    {
+        return "root";
+    }
+};
+
+struct SM11 : STypes::State<Root, SM112>
+{
+    static const char* name()
+    {
+        return "sm11";
+    }
+};
+
+struct SM111 : STypes::State<SM11, SM111x<1>>
+{
+    static const char* name()
+    {
+        return "sm111";
+    }
+};
+
+template <int N>
+struct SM111x : STypes::State<SM111>
+{
+    static const char* name()
+    {
+        static const char* names[] = {"sm1111", "sm1112", "sm1113"};
+        return names[N - 1];
+    }
+
+    void printSomething(Evt const&)
+    {
+        std::cout << "Something" << std::endl;
+    }
+};
+
+struct SM112 : STypes::State<SM11>
+{
+    static const char* name()
+    {
+        return "sm112";
+    }
+};
+
+struct SM12 : STypes::State<Root, SM122>
+{
+    static const char* name()
+    {
+        return "sm12";
+    }
+};
+
+struct SM121 : STypes::State<SM12>
+{
+    static const char* name()
+    {
+        return "sm121";
+    }
+};
+
+struct SM122 : STypes::State<SM12, SM1221>
+{
+    static const char* name()
+    {
+        return "sm122";
+    }
+};
+
+struct SM1221 : STypes::State<SM122, SM12211>
+{
+    static const char* name()
+    {
+        return "sm1221";
+    }
+};
+
+struct SM12211 : STypes::State<SM1221>
+{
+    static const char* name()
+    {
+        return "sm12211";
+    }
+};
+
+ROOST_STATIC_ACTION(PrintSomething, printSomething);
+
+// clang-format off
+
+using Table = roost::StaticTable<
+        STypes::Row<SM111x<1>, Evt::FIRST,      SM12>,
+        STypes::Row<SM111x<1>, Evt::SECOND,     void,  roost::StaticActions<PrintSomething>>,
+        STypes::Row<SM111x<2>, Evt::FIRST,      SM12>,
+        STypes::Row<SM111x<2>, Evt::SECOND,     void,  roost::StaticActions<PrintSomething>>,
+        STypes::Row<SM111x<3>, Evt::FIRST,      SM12>,
+        STypes::Row<SM111x<3>, Evt::SECOND,     void,  roost::StaticActions<PrintSomething>>,
+        STypes::Row<SM12211,   Evt::ROOST_NONE, SM111>,
+        STypes::Row<SM112,     Evt::ROOST_NONE, SM111>>;
+
+// clang-format on
+
+using States = roost::StaticStates<Root,
+                                   SM11,
+                                   SM111,
+                                   SM111x<1>,
+                                   SM111x<2>,
+                                   SM111x<3>,
+                                   SM112,
+                                   SM12,
+                                   SM121,
+                                   SM122,
+                                   SM1221,
+                                   SM12211>;
+
+template <typename SPY = roost::StaticNoSpy>
+using Machine = STypes::Machine<States, Table, SPY>;
+
+}  // ns: sm1_static
+
+#endif  // ROOST_SM1_STATIC_HPP
@@ -0,0 +1,89 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include "roost/state_machine.hpp"
+#include "sm1/sm1.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Built with ROOST_STRIP_NAMES, so every name is an id until the symbol table knows it
+
+namespace
+{
+
+std::string placeholder(const char* name)
+{
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "#%08x", static_cast<unsigned>(roost::nameId(name)));
+    return buf;
+}
+
+}  // ns: anonymous
+
+TEST(StripNamesTest, resolve_test)
+{
+    using namespace sm1;
+
+    static_assert(std::is_same<roost::Name, roost::u32>::value, "Names must be ids");
+
+    std::vector<std::string> traces[2];
+    std::string              scxml[2];
+
+    for (int loaded = 0; loaded < 2; ++loaded)
+    {
+        if (loaded)
+        {
+            // What getSymbolFile() outputs from a build without ROOST_STRIP_NAMES
+            std::string path = ::testing::TempDir() + "roost_strip_names.sym";
+
+            {
+                std::ofstream file(path);
+                roost::writeSymbol(file, roost::nameId("root"), "root");
+                roost::writeSymbol(file, roost::nameId("printSomething"), "printSomething");
+            }
+
+            ASSERT_TRUE(roost::loadSymbolFile(path));
+            std::remove(path.c_str());
+        }
+
+        Ctx       ctx;
+        RootState root("root", ctx, nullptr);
+        ctx.m_root = &root;
+
+        std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(traces[loaded]);
+
+        SMTypes::StateMachine be("TestBackend", &root, std::move(spy));
+        ASSERT_TRUE(be.init());
+
+        std::stringstream ss;
+        be.getSCXML(ss);
+        scxml[loaded] = ss.str();
+    }
+
+    ASSERT_EQ(traces[0].front(), "OE-" + placeholder("root"));
+    ASSERT_NE(scxml[0].find(placeholder("printSomething") + "(SECOND);"), std::string::npos);
+
+    // Only the names in the symbol file are resolved
+    ASSERT_EQ(traces[1].front(), "OE-root");
+    ASSERT_EQ(traces[1].back(), "OE-" + placeholder("sm1111"));
+    ASSERT_NE(scxml[1].find("printSomething(SECOND);"), std::string::npos);
+}
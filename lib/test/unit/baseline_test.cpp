@@ -0,0 +1,153 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "baseline/sm1_baseline.hpp"
+#include "baseline/sm2_baseline.hpp"
+#include "roost/state_machine.hpp"
+#include "sm1/sm1.hpp"
+#include "sm2/sm2.hpp"
+
+// The hand-written baselines are only useful for benchmarking if they do the same work as the
+// StateMachine, so every baseline is checked hook for hook against its Roost counterpart.
+
+namespace
+{
+
+const size_t NUM_RANDOM_EVENTS = 2000;
+
+template <typename BASELINE, typename E>
+void compareSm1(std::vector<E> const& events)
+{
+    using namespace sm1;
+
+    Ctx       ctx;
+    RootState root("root", ctx, nullptr);
+    ctx.m_root = &root;
+
+    std::vector<std::string>      actual_states;
+    std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(actual_states);
+
+    SMTypes::StateMachine be("TestBackend", &root, std::move(spy));
+    ASSERT_TRUE(be.init());
+
+    std::vector<std::string> baseline_states;
+    BASELINE                 fsm(&baseline_states);
+    fsm.init();
+
+    ASSERT_EQ(baseline_states, actual_states);
+    ASSERT_EQ(fsm.getCurrentNodes(), be.getCurrentNodes());
+
+    for (auto e : events)
+    {
+        actual_states.clear();
+        baseline_states.clear();
+
+        be.handleEvent(e);
+        fsm.handleEvent(e);
+
+        ASSERT_EQ(baseline_states, actual_states) << "Event: " << e;
+        ASSERT_EQ(fsm.getCurrentNodes(), be.getCurrentNodes()) << "Event: " << e;
+    }
+}
+
+template <typename BASELINE, typename E>
+void compareSm2(std::vector<E> const& events, bool force_to_se)
+{
+    using namespace sm2;
+
+    Ctx       ctx;
+    RootState root("root", ctx, nullptr);
+    ctx.m_root = &root;
+
+    std::vector<std::string>      actual_states;
+    std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(actual_states);
+
+    SMTypes::StateMachine be("TestBackend", &root, std::move(spy));
+    ASSERT_TRUE(be.init());
+
+    std::vector<std::string> baseline_states;
+    BASELINE                 fsm(&baseline_states);
+    fsm.init();
+
+    ASSERT_EQ(baseline_states, actual_states);
+    ASSERT_EQ(fsm.getCurrentNodes(), be.getCurrentNodes());
+
+    if (force_to_se)
+    {
+        actual_states.clear();
+        baseline_states.clear();
+
+        be.forceTransitionTo(&root.m_s11.m_s111.m_s1111.m_s11113.m_se);
+        fsm.forceToSe();
+
+        ASSERT_EQ(baseline_states, actual_states);
+        ASSERT_EQ(fsm.getCurrentNodes(), be.getCurrentNodes());
+    }
+
+    for (auto e : events)
+    {
+        actual_states.clear();
+        baseline_states.clear();
+
+        be.handleEvent(e);
+        fsm.handleEvent(e);
+
+        ASSERT_EQ(baseline_states, actual_states) << "Event: " << e;
+        ASSERT_EQ(fsm.getCurrentNodes(), be.getCurrentNodes()) << "Event: " << e;
+    }
+}
+
+template <typename E>
+std::vector<E> randomEvents(int num_event_types, unsigned seed)
+{
+    std::mt19937                       gen(seed);
+    std::uniform_int_distribution<int> dist(1, num_event_types);
+
+    std::vector<E> rval;
+
+    for (size_t i = 0; i < NUM_RANDOM_EVENTS; ++i)
+    {
+        rval.push_back(static_cast<E>(dist(gen)));
+    }
+
+    return rval;
+}
+
+}  // ns: anonymous
+
+TEST(BaselineTest, sm1_switch_test)
+{
+    compareSm1<sm1_baseline::SwitchFsm>(randomEvents<sm1::Evt>(3, 1));
+}
+
+TEST(BaselineTest, sm1_table_test)
+{
+    compareSm1<sm1_baseline::TableFsm>(randomEvents<sm1::Evt>(3, 1));
+}
+
+TEST(BaselineTest, sm2_switch_test)
+{
+    compareSm2<sm2_baseline::SwitchFsm>(randomEvents<sm2::Evt>(5, 2), false);
+    compareSm2<sm2_baseline::SwitchFsm>(randomEvents<sm2::Evt>(5, 3), true);
+}
+
+TEST(BaselineTest, sm2_table_test)
+{
+    compareSm2<sm2_baseline::TableFsm>(randomEvents<sm2::Evt>(5, 2), false);
+    compareSm2<sm2_baseline::TableFsm>(randomEvents<sm2::Evt>(5, 3), true);
+}
@@ -0,0 +1,510 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "roost/core.hpp"
+#include "roost/topology_cache.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+
+// The core only sees nodes through a TreeAccess, so it is exercised here with a plain struct
+// instead of a typed Node hierarchy.
+
+namespace
+{
+
+using namespace roost;
+
+struct TestNode
+{
+    TestNode(NodeType type, TestNode* parent) : m_type(type), m_parent(parent), m_initial(nullptr)
+    {
+        if (m_parent)
+        {
+            m_parent->m_children.push_back(this);
+
+            if (!m_parent->m_initial)
+            {
+                m_parent->m_initial = this;
+            }
+        }
+    }
+
+    NodeType               m_type;
+    TestNode*              m_parent;
+    TestNode*              m_initial;
+    std::vector<TestNode*> m_children;
+    core::NodeId           m_id{core::INVALID_NODE};
+};  // Struct: TestNode
+
+TestNode* cast(void* node)
+{
+    return static_cast<TestNode*>(node);
+}
+
+const core::TreeAccess Access = {
+        [](void* node) { return cast(node)->m_children.size(); },
+        [](void* node, size_t idx) -> void* { return cast(node)->m_children[idx]; },
+        [](void* node) -> void* { return cast(node)->m_parent; },
+        [](void* node) -> void* {
+            // Orthogonal nodes and leaves have no initial child
+            TestNode* n = cast(node);
+            return (n->m_type == NodeType::REGION || n->m_type == NodeType::COMPOSITE_NODE)
+                           ? n->m_initial
+                           : nullptr;
+        },
+        [](void* node) { return cast(node)->m_type; },
+        [](void* node) { return cast(node)->m_id; },
+        [](void* node, core::NodeId id) { cast(node)->m_id = id; }};
+
+struct Tree
+{
+    // Top -> root -> {a, o -> {r1 -> x, r2 -> y}}
+    TestNode top{NodeType::REGION, nullptr};
+    TestNode root{NodeType::COMPOSITE_NODE, &top};
+    TestNode a{NodeType::LEAF_NODE, &root};
+    TestNode o{NodeType::ORTHOGONAL_NODE, &root};
+    TestNode r1{NodeType::REGION, &o};
+    TestNode x{NodeType::LEAF_NODE, &r1};
+    TestNode r2{NodeType::REGION, &o};
+    TestNode y{NodeType::LEAF_NODE, &r2};
+};  // Struct: Tree
+
+std::string nameOf(core::NodeId id)
+{
+    const char* names[] = {"top", "root", "a", "o", "r1", "x", "r2", "y"};
+    return names[id];
+}
+
+core::Hooks makeHooks(std::vector<std::string>& trace)
+{
+    return {&trace,
+            [](void* ctx, core::NodeId id) {
+                static_cast<std::vector<std::string>*>(ctx)->push_back("OE-" + nameOf(id));
+            },
+            [](void* ctx, core::NodeId id) {
+                static_cast<std::vector<std::string>*>(ctx)->push_back("OX-" + nameOf(id));
+            },
+            [](void* ctx, core::NodeId id, core::History history) {
+                static_cast<std::vector<std::string>*>(ctx)->push_back(
+                        "OE-" + nameOf(id) + "." + core::historyName(history));
+            }};
+}
+
+}  // ns: anonymous
+
+TEST(CoreTest, topology_test)
+{
+    Tree                tree;
+    core::Vector<void*> nodes;
+    core::Topology      topology;
+
+    core::buildTopology(Access, &tree.top, nodes, topology);
+
+    ASSERT_EQ(topology.size(), (size_t)8);
+    ASSERT_EQ(nodes[core::TOP_NODE], &tree.top);
+    ASSERT_EQ(tree.y.m_id, (core::NodeId)7);
+
+    ASSERT_EQ(topology.parent[tree.x.m_id], tree.r1.m_id);
+    ASSERT_EQ(topology.initial_child[tree.root.m_id], tree.a.m_id);
+    ASSERT_EQ(topology.initial_child[tree.o.m_id], core::INVALID_NODE);
+
+    ASSERT_EQ(topology.region[tree.a.m_id], core::TOP_NODE);
+    ASSERT_EQ(topology.region[tree.y.m_id], tree.r2.m_id);
+
+    ASSERT_EQ(topology.level[core::TOP_NODE], (u32)1);
+    ASSERT_EQ(topology.level[tree.r1.m_id], (u32)4);
+    ASSERT_EQ(topology.level[tree.a.m_id], (u32)0);
+
+    ASSERT_EQ(topology.max_depth, (size_t)5);
+    ASSERT_EQ(topology.number_of_regions, (size_t)3);
+
+    std::vector<core::NodeId> children(
+            topology.childrenBegin(tree.o.m_id), topology.childrenEnd(tree.o.m_id));
+    ASSERT_EQ(children, (std::vector<core::NodeId>{tree.r1.m_id, tree.r2.m_id}));
+}
+
+TEST(CoreTest, route_test)
+{
+    Tree                tree;
+    core::Vector<void*> nodes;
+    core::Topology      topology;
+
+    core::buildTopology(Access, &tree.top, nodes, topology);
+
+    ASSERT_EQ(core::findLca(topology, tree.x.m_id, tree.a.m_id), tree.root.m_id);
+    ASSERT_EQ(core::findLca(topology, tree.a.m_id, tree.a.m_id), tree.root.m_id);
+    ASSERT_EQ(core::findLca(topology, tree.a.m_id, core::INVALID_NODE), core::INVALID_NODE);
+    ASSERT_EQ(core::findLca(Access, &tree.x, &tree.y), &tree.o);
+
+    // Between orthogonal regions the route is turned into a self transition of the orthogonal node
+    core::Route route = core::makeRoute(topology, tree.x.m_id, tree.y.m_id);
+    ASSERT_EQ(route.src, tree.o.m_id);
+    ASSERT_EQ(route.destination, tree.o.m_id);
+    ASSERT_EQ(route.lca, tree.root.m_id);
+    ASSERT_EQ(route.lca_region, core::TOP_NODE);
+    ASSERT_EQ(route.src_region, core::TOP_NODE);
+
+    route = core::makeRoute(topology, tree.x.m_id, core::INVALID_NODE);
+    ASSERT_EQ(route.lca, core::INVALID_NODE);
+    ASSERT_EQ(route.src_region, tree.r1.m_id);
+}
+
+TEST(CoreTest, transition_test)
+{
+    Tree                     tree;
+    core::Vector<void*>      nodes;
+    core::Topology           topology;
+    core::Runtime            runtime;
+    std::vector<std::string> trace;
+    core::Hooks              hooks = makeHooks(trace);
+
+    core::buildTopology(Access, &tree.top, nodes, topology);
+    core::markHistory(topology, tree.root.m_id, core::History::SHALLOW);
+    core::reset(topology, runtime);
+    core::construct(topology, runtime, hooks, core::TOP_NODE);
+
+    ASSERT_EQ(trace, (std::vector<std::string>{"OE-root", "OE-a"}));
+
+    trace.clear();
+    core::transition(topology, runtime, hooks, core::makeRoute(topology, tree.a.m_id, tree.y.m_id));
+
+    ASSERT_EQ(trace, (std::vector<std::string>{"OX-a", "OE-o", "OE-x", "OE-y"}));
+
+    core::Vector<core::NodeId> current;
+    core::currentNodes(
+            topology,
+            runtime,
+            core::TOP_NODE,
+            [](void* user, core::NodeId id) {
+                static_cast<core::Vector<core::NodeId>*>(user)->push_back(id);
+            },
+            &current);
+    ASSERT_EQ(current, (core::Vector<core::NodeId>{tree.o.m_id, tree.x.m_id, tree.y.m_id}));
+
+    trace.clear();
+    core::transition(topology, runtime, hooks, core::makeRoute(topology, tree.y.m_id, tree.a.m_id));
+
+    ASSERT_EQ(trace, (std::vector<std::string>{"OX-x", "OX-y", "OX-o", "OE-a"}));
+    ASSERT_EQ(runtime.last_active[tree.root.m_id], tree.o.m_id);
+
+    // Only root has its history recorded
+    ASSERT_EQ(runtime.last_active[tree.r2.m_id], tree.r2.m_initial->m_id);
+    ASSERT_EQ(runtime.last_active[core::TOP_NODE], tree.root.m_id);
+}
+
+TEST(CoreTest, history_test)
+{
+    Tree                     tree;
+    core::Vector<void*>      nodes;
+    core::Topology           topology;
+    core::Runtime            runtime;
+    std::vector<std::string> trace;
+    core::Hooks              hooks = makeHooks(trace);
+
+    core::buildTopology(Access, &tree.top, nodes, topology);
+    core::markHistory(topology, tree.root.m_id, core::History::DEEP);
+    core::reset(topology, runtime);
+    core::construct(topology, runtime, hooks, core::TOP_NODE);
+    core::transition(topology, runtime, hooks, core::makeRoute(topology, tree.a.m_id, tree.y.m_id));
+
+    // The history behaves as a child of root, so root isn't exited
+    core::Route route =
+            core::makeRoute(topology, tree.y.m_id, tree.root.m_id, core::History::SHALLOW);
+
+    ASSERT_EQ(route.destination, tree.root.m_id);
+    ASSERT_EQ(route.lca, tree.root.m_id);
+    ASSERT_EQ(route.history, core::History::SHALLOW);
+
+    trace.clear();
+    core::transition(topology, runtime, hooks, route);
+
+    ASSERT_EQ(
+            trace,
+            (std::vector<std::string>{
+                    "OX-x", "OX-y", "OX-o", "OE-root.ShallowHistory", "OE-o", "OE-x", "OE-y"}));
+
+    // Deep history marks the regions under root too, but not Top
+    ASSERT_EQ(topology.records_history[tree.r1.m_id], (u8)1);
+    ASSERT_EQ(topology.records_history[tree.y.m_id], (u8)0);
+    ASSERT_EQ(topology.records_history[core::TOP_NODE], (u8)0);
+
+    // Even from root itself
+    route = core::makeRoute(topology, tree.root.m_id, tree.root.m_id, core::History::DEEP);
+    ASSERT_EQ(route.lca, tree.root.m_id);
+
+    // Unlike a transition to root itself
+    route = core::makeRoute(topology, tree.root.m_id, tree.root.m_id);
+    ASSERT_EQ(route.lca, core::TOP_NODE);
+}
+
+TEST(CoreTest, lca_index_test)
+{
+    // A large random tree, deep chains included, checked against the pointer walk
+    std::mt19937                           gen(7);
+    std::vector<std::unique_ptr<TestNode>> tree;
+
+    tree.emplace_back(new TestNode(NodeType::REGION, nullptr));
+
+    for (size_t i = 1; i < 3000; ++i)
+    {
+        // Bias towards the most recent nodes so that the tree gets deep
+        size_t lo     = i > 20 ? i - 20 : 0;
+        size_t parent = std::uniform_int_distribution<size_t>(lo, i - 1)(gen);
+
+        tree[parent]->m_type = NodeType::COMPOSITE_NODE;
+        tree.emplace_back(new TestNode(NodeType::LEAF_NODE, tree[parent].get()));
+    }
+
+    tree[0]->m_type = NodeType::REGION;
+
+    core::Vector<void*> nodes;
+    core::Topology      topology;
+    core::buildTopology(Access, tree[0].get(), nodes, topology);
+
+    ASSERT_GT(topology.max_depth, (size_t)100);
+
+    std::uniform_int_distribution<size_t> pick(0, tree.size() - 1);
+
+    for (size_t i = 0; i < 5000; ++i)
+    {
+        TestNode* src = tree[pick(gen)].get();
+        TestNode* dst = tree[pick(gen)].get();
+
+        void* expected = core::findLca(Access, src, dst);
+
+        ASSERT_EQ(
+                core::findLca(topology, src->m_id, dst->m_id),
+                expected ? cast(expected)->m_id : core::INVALID_NODE);
+    }
+}
+
+TEST(CoreTest, topology_cache_test)
+{
+    std::string path = ::testing::TempDir() + "roost_core_test.cache";
+    std::remove(path.c_str());
+
+    Tree                tree;
+    core::Vector<void*> nodes;
+    core::Topology      built;
+    core::RouteLog      log;
+
+    u64 hash = core::hashTree(Access, &tree.top, nodes);
+    core::buildTopology(Access, &tree.top, nodes, built);
+
+    core::Topology loaded;
+    core::RouteLog loaded_log;
+    ASSERT_FALSE(core::loadTopologyCache(path, hash, nodes.size(), loaded, loaded_log));
+
+    core::Route a_to_x = core::makeRoute(built, log, tree.a.m_id, tree.x.m_id);
+    core::Route x_to_y = core::makeRoute(built, log, tree.x.m_id, tree.y.m_id);
+    ASSERT_TRUE(log.dirty);
+    ASSERT_TRUE(core::saveTopologyCache(path, hash, built, log));
+
+    // A different shape has a different hash and never loads
+    Tree     other;
+    TestNode extra{NodeType::LEAF_NODE, &other.root};
+    u64      other_hash = core::hashTree(Access, &other.top, nodes);
+    ASSERT_NE(hash, other_hash);
+    ASSERT_FALSE(core::loadTopologyCache(path, other_hash, nodes.size(), loaded, loaded_log));
+
+    u64 same_hash = core::hashTree(Access, &tree.top, nodes);
+    ASSERT_EQ(hash, same_hash);
+    ASSERT_TRUE(core::loadTopologyCache(path, hash, nodes.size(), loaded, loaded_log));
+
+    ASSERT_EQ(loaded.parent, built.parent);
+    ASSERT_EQ(loaded.initial_child, built.initial_child);
+    ASSERT_EQ(loaded.type, built.type);
+    ASSERT_EQ(loaded.region, built.region);
+    ASSERT_EQ(loaded.level, built.level);
+    ASSERT_EQ(loaded.child_offsets, built.child_offsets);
+    ASSERT_EQ(loaded.children, built.children);
+    ASSERT_EQ(loaded.depth, built.depth);
+    ASSERT_EQ(loaded.ancestors, built.ancestors);
+    ASSERT_EQ(loaded.max_depth, built.max_depth);
+    ASSERT_EQ(loaded.number_of_regions, built.number_of_regions);
+
+    // The first route replays, the second doesn't match and is made again
+    core::Route replayed = core::makeRoute(loaded, loaded_log, tree.a.m_id, tree.x.m_id);
+    ASSERT_EQ(replayed.lca, a_to_x.lca);
+    ASSERT_FALSE(loaded_log.dirty);
+
+    core::Route remade = core::makeRoute(loaded, loaded_log, tree.y.m_id, tree.x.m_id);
+    ASSERT_EQ(remade.lca, x_to_y.lca);
+    ASSERT_TRUE(loaded_log.dirty);
+    ASSERT_EQ(loaded_log.routes.size(), (size_t)2);
+
+    // A truncated file is ignored
+    std::ifstream     in(path, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size() - sizeof(u32));
+    out.close();
+
+    ASSERT_FALSE(core::loadTopologyCache(path, hash, nodes.size(), loaded, loaded_log));
+
+    std::remove(path.c_str());
+}
+
+namespace
+{
+
+//! A topology cache file the test can edit and hash again, see CacheHeader in topology_cache.cpp
+struct CacheFile
+{
+    static const size_t PAYLOAD_HASH_OFFSET = 24;
+
+    std::vector<char> bytes;
+    size_t            payload;  //!< Offset of the first array after the header
+
+    CacheFile(std::string const& path, size_t payload_bytes)
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        payload = bytes.size() - payload_bytes;
+    }
+
+    void set(size_t offset, u32 value)
+    {
+        std::memcpy(&bytes[offset], &value, sizeof(value));
+    }
+
+    void write(std::string const& path)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size());
+    }
+
+    //! Writes the file with payload_hash made to match, so only the structural checks can fail
+    void save(std::string const& path)
+    {
+        u64 hash = 14695981039346656037ULL;
+
+        for (size_t i = payload; i < bytes.size(); ++i)
+        {
+            hash ^= static_cast<unsigned char>(bytes[i]);
+            hash *= 1099511628211ULL;
+        }
+
+        std::memcpy(&bytes[PAYLOAD_HASH_OFFSET], &hash, sizeof(hash));
+        write(path);
+    }
+};  // Struct: CacheFile
+
+}  // ns: anonymous
+
+TEST(CoreTest, topology_cache_corrupt_test)
+{
+    std::string path = ::testing::TempDir() + "roost_core_corrupt_test.cache";
+
+    Tree                tree;
+    core::Vector<void*> nodes;
+    core::Topology      built;
+    core::RouteLog      log;
+
+    u64 hash = core::hashTree(Access, &tree.top, nodes);
+    core::buildTopology(Access, &tree.top, nodes, built);
+    core::makeRoute(built, log, tree.a.m_id, tree.x.m_id);
+    core::makeRoute(built, log, tree.x.m_id, tree.y.m_id);
+    ASSERT_TRUE(core::saveTopologyCache(path, hash, built, log));
+
+    size_t n     = nodes.size();
+    size_t words = 6 * n + (n + 1) + built.children.size() + built.ancestors.size() +
+                   (core::ROUTE_KEY_WORDS + sizeof(core::Route) / sizeof(u32)) * log.routes.size();
+
+    core::Topology loaded;
+    core::RouteLog loaded_log;
+
+    CacheFile original(path, words * sizeof(u32));
+    ASSERT_EQ(original.payload % sizeof(u64), (size_t)0);
+
+    // Resaving an untouched file must load, otherwise the cases below prove nothing
+    CacheFile file = original;
+    file.save(path);
+    ASSERT_TRUE(core::loadTopologyCache(path, hash, n, loaded, loaded_log));
+
+    size_t routes = file.bytes.size() - log.routes.size() * sizeof(core::Route);
+    size_t keys   = routes - log.routes.size() * core::ROUTE_KEY_WORDS * sizeof(u32);
+
+    // The keys are only range checked, so an edit to them is caught by the hash alone
+    file = original;
+    file.set(keys, tree.x.m_id);
+    file.write(path);
+    ASSERT_FALSE(core::loadTopologyCache(path, hash, n, loaded, loaded_log));
+    file.save(path);
+    ASSERT_TRUE(core::loadTopologyCache(path, hash, n, loaded, loaded_log));
+
+    // A node that is its own parent would make every walk up the tree loop forever
+    file = original;
+    file.set(file.payload + tree.o.m_id * sizeof(u32), tree.o.m_id);
+    file.save(path);
+    ASSERT_FALSE(core::loadTopologyCache(path, hash, n, loaded, loaded_log));
+
+    // A depth that disagrees with the parent
+    file = original;
+    file.set(file.payload + (5 * n + tree.x.m_id) * sizeof(u32), 2);
+    file.save(path);
+    ASSERT_FALSE(core::loadTopologyCache(path, hash, n, loaded, loaded_log));
+
+    // The first route goes from a to x, o is not an ancestor of a
+    file = original;
+    file.set(routes + offsetof(core::Route, lca), tree.o.m_id);
+    file.save(path);
+    ASSERT_FALSE(core::loadTopologyCache(path, hash, n, loaded, loaded_log));
+
+    std::remove(path.c_str());
+}
+
+TEST(CoreTest, match_flags_test)
+{
+    std::mt19937                       gen(7);
+    std::uniform_int_distribution<u32> bits(0, 0xF);
+
+    for (int round = 0; round < 100; ++round)
+    {
+        u32 masks[32];
+        u32 expected[32];
+        u32 flags = bits(gen);
+
+        for (u32 i = 0; i < 32; ++i)
+        {
+            masks[i]    = bits(gen);
+            expected[i] = bits(gen) & masks[i];
+        }
+
+        // Every count, so both the vector and the scalar tail are covered
+        for (u32 count = 0; count <= 32; ++count)
+        {
+            u32 matches = core::matchFlags(flags, masks, expected, count);
+
+            for (u32 i = 0; i < 32; ++i)
+            {
+                bool match = i < count && (flags & masks[i]) == expected[i];
+                ASSERT_EQ(((matches >> i) & 1) != 0, match) << "Row " << i << " of " << count;
+            }
+        }
+    }
+
+    ASSERT_EQ(core::lowestBit(1), (u32)0);
+    ASSERT_EQ(core::lowestBit(0x80000000u), (u32)31);
+    ASSERT_EQ(core::lowestBit(0x50), (u32)4);
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "roost/state_machine.hpp"
+
+// Two regions whose leaves target each other on the same event.  A row into a sibling region is
+// taken as a self transition of the orthogonal node, so both rows are selected and neither region
+// may be skipped by the dispatch.
+
+namespace cross_region
+{
+
+enum class Evt
+{
+    ROOST_NONE,  // Enforced by framework
+    SWAP
+};
+
+static const char* EvtStrings[] = {"NONE", "SWAP"};
+
+ROOST_ENUM_PRINT_HELPER(Evt, EvtStrings)
+
+struct Ctx
+{
+    std::vector<std::string> calls;
+};
+
+using SMTypes = roost::NodeAlias<Ctx, Evt>;
+
+class Leaf : public SMTypes::Leaf
+{
+public:
+    Leaf(const char* name, Ctx& ctx, SMTypes::Node* parent)
+        : SMTypes::Leaf(name, ctx, parent), m_target(nullptr)
+    {
+    }
+
+    void createTransitionTable() override
+    {
+        if (m_target)
+        {
+            addRow(Evt::SWAP, m_target, {ROOST_ACTION(swap)}, ROOST_GUARD(allow()));
+        }
+    }
+
+    bool allow()
+    {
+        m_ctx.calls.push_back(std::string("G-") + getName());
+        return true;
+    }
+
+    void swap(Evt const&)
+    {
+        m_ctx.calls.push_back(std::string("A-") + getName());
+    }
+
+    SMTypes::Node* m_target;
+};
+
+class Side : public SMTypes::Region
+{
+public:
+    Side(const char* name, Ctx& ctx, SMTypes::Node* parent, const char* first, const char* second)
+        : SMTypes::Region(name, ctx, parent, &m_first),
+          m_first(first, ctx, this),
+          m_second(second, ctx, this)
+    {
+    }
+
+    Leaf m_first;
+    Leaf m_second;
+};
+
+class Pair : public SMTypes::Orthogonal
+{
+public:
+    Pair(const char* name, Ctx& ctx, SMTypes::Node* parent)
+        : SMTypes::Orthogonal(name, ctx, parent),
+          m_a("a", ctx, this, "a1", "a2"),
+          m_b("b", ctx, this, "b1", "b2")
+    {
+        m_a.m_first.m_target = &m_b.m_second;
+        m_b.m_first.m_target = &m_a.m_second;
+    }
+
+    void createTransitionTable() override
+    {
+    }
+
+    Side m_a;
+    Side m_b;
+};
+
+}  // ns: cross_region
+
+TEST(CrossRegionTest, sibling_rows_both_fire_test)
+{
+    using namespace cross_region;
+
+    for (int cached = 0; cached < 2; ++cached)
+    {
+        Ctx  ctx;
+        Pair pair("pair", ctx, nullptr);
+
+        SMTypes::StateMachine be("TestBackend", &pair, nullptr);
+        be.setDispatchCache(cached == 1);
+        ASSERT_TRUE(be.init());
+
+        be.handleEvent(Evt::SWAP);
+
+        std::vector<std::string> expected_calls = {"G-a1", "G-b1", "A-a1", "A-b1"};
+        ASSERT_EQ(ctx.calls, expected_calls);
+
+        // Both are self transitions of the orthogonal node, so the regions start over
+        std::vector<std::string> expected_nodes = {"pair", "a1", "b1"};
+        ASSERT_EQ(be.getCurrentNodes(), expected_nodes);
+    }
+}
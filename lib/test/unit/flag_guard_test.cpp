@@ -0,0 +1,197 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "roost/state_machine.hpp"
+
+// The rows of an event with flag guards are tested together, so the tests below check that the
+// first row that passes is still the one taken, whatever mix of guards comes before it.
+
+namespace flag_guard
+{
+
+enum class Evt
+{
+    ROOST_NONE,  // Enforced by framework
+    CHECK,
+    MANY,
+    RESET
+};
+
+static const char* EvtStrings[] = {"NONE", "CHECK", "MANY", "RESET"};
+
+ROOST_ENUM_PRINT_HELPER(Evt, EvtStrings)
+
+enum : roost::GuardFlags
+{
+    LINK_UP = 1 << 0,
+    ARMED   = 1 << 1
+};
+
+//! Number of MANY rows, more than fit in one call to core::matchFlags()
+const roost::u32 NUM_MANY_ROWS = 40;
+
+//! Set by the MANY row without a guard
+const roost::u32 NO_MANY_ROW = 99;
+
+class RootState;
+
+struct Ctx
+{
+    RootState*        m_root;
+    bool              pass;
+    roost::u32        taken;
+    roost::GuardFlags flags;
+};
+
+using SMTypes = roost::NodeAlias<Ctx, Evt>;
+
+class Idle : public SMTypes::Leaf
+{
+public:
+    Idle(const char* name, Ctx& ctx, SMTypes::Node* parent) : SMTypes::Leaf(name, ctx, parent)
+    {
+    }
+
+    void createTransitionTable() override;
+};
+
+class Target : public SMTypes::Leaf
+{
+public:
+    Target(const char* name, Ctx& ctx, SMTypes::Node* parent) : SMTypes::Leaf(name, ctx, parent)
+    {
+    }
+
+    void createTransitionTable() override
+    {
+    }
+};
+
+class RootState : public SMTypes::Composite
+{
+public:
+    RootState(const char* name, Ctx& ctx, SMTypes::Node* parent)
+        : SMTypes::Composite(name, ctx, parent, &m_idle),
+          m_idle("idle", ctx, this),
+          m_up("up", ctx, this),
+          m_guarded("guarded", ctx, this),
+          m_armed("armed", ctx, this),
+          m_fallback("fallback", ctx, this)
+    {
+    }
+
+    Idle   m_idle;
+    Target m_up;
+    Target m_guarded;
+    Target m_armed;
+    Target m_fallback;
+
+    void createTransitionTable() override
+    {
+        addRow(Evt::RESET, &m_idle, ROOST_NO_ACTION, ROOST_NO_GUARD);
+    }
+};
+
+// clang-format off
+
+void Idle::createTransitionTable()
+{
+    RootState& rs = *m_ctx.m_root;
+
+    addRow(Evt::CHECK, &rs.m_up,       ROOST_NO_ACTION, ROOST_FLAG_GUARD(LINK_UP | ARMED, LINK_UP));
+    addRow(Evt::CHECK, &rs.m_guarded,  ROOST_NO_ACTION, ROOST_GUARD(m_ctx.pass));
+    addRow(Evt::CHECK, &rs.m_armed,    ROOST_NO_ACTION, ROOST_FLAG_GUARD(ARMED, ARMED));
+    addRow(Evt::CHECK, &rs.m_fallback, ROOST_NO_ACTION, ROOST_NO_GUARD);
+
+    for (roost::u32 i = 0; i < NUM_MANY_ROWS; ++i)
+    {
+        roost::ActionFunctor<Ctx, Evt> take([this, i](Evt const&) { m_ctx.taken = i; }, "take");
+        addRow(Evt::MANY, ROOST_NO_DEST, {take}, ROOST_FLAG_GUARD(0xFFu, i));
+    }
+
+    roost::ActionFunctor<Ctx, Evt> none([this](Evt const&) { m_ctx.taken = NO_MANY_ROW; }, "none");
+    addRow(Evt::MANY, ROOST_NO_DEST, {none}, ROOST_NO_GUARD);
+}
+
+// clang-format on
+
+}  // ns: flag_guard
+
+TEST(FlagGuardTest, first_passing_row_test)
+{
+    using namespace flag_guard;
+
+    // Walked, cached and flattened
+    for (int mode = 0; mode < 3; ++mode)
+    {
+        Ctx       ctx{nullptr, false, 0, 0};
+        RootState root("root", ctx, nullptr);
+        ctx.m_root = &root;
+
+        SMTypes::StateMachine be("TestBackend", &root);
+        be.setDispatchCache(mode == 1);
+        be.setFlatDispatch(mode == 2);
+        ASSERT_TRUE(be.init());
+        ASSERT_EQ(be.hasFlatDispatch(), mode == 2);
+
+        struct Case
+        {
+            bool              set_flags;
+            roost::GuardFlags flags;
+            bool              pass;
+            const char*       expected;
+        };
+
+        const Case cases[] = {
+                {false, LINK_UP, true, "guarded"},  // Without the word every flag reads as 0
+                {true, 0, false, "fallback"},
+                {true, LINK_UP, false, "up"},
+                {true, LINK_UP, true, "up"},
+                {true, LINK_UP | ARMED, true, "guarded"},
+                {true, LINK_UP | ARMED, false, "armed"},
+                {true, ARMED, false, "armed"},
+        };
+
+        for (Case const& c : cases)
+        {
+            be.setGuardFlags(c.set_flags ? &ctx.flags : nullptr);
+            ctx.flags = c.flags;
+            ctx.pass  = c.pass;
+
+            be.handleEvent(Evt::CHECK);
+            ASSERT_EQ(be.getCurrentNodes(), std::vector<std::string>{c.expected})
+                    << "Mode " << mode << ", flags " << c.flags << ", pass " << c.pass;
+
+            be.handleEvent(Evt::RESET);
+            ASSERT_EQ(be.getCurrentNodes(), std::vector<std::string>{"idle"});
+        }
+
+        be.setGuardFlags(&ctx.flags);
+
+        // Rows on both sides of the first 32, and none at all
+        for (roost::GuardFlags flags : {0u, 5u, 31u, 32u, 39u, 40u, 0x80u})
+        {
+            ctx.flags = flags;
+            be.handleEvent(Evt::MANY);
+            ASSERT_EQ(ctx.taken, flags < NUM_MANY_ROWS ? flags : NO_MANY_ROW)
+                    << "Mode " << mode << ", flags " << flags;
+        }
+    }
+}
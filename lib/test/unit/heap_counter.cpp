@@ -0,0 +1,88 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "heap_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::atomic<size_t> g_allocations{0};  //!< Allocations made while a HeapCounter is alive
+std::atomic<int>    g_counters{0};     //!< Number of HeapCounters alive
+
+void* allocate(size_t size)
+{
+    if (g_counters.load(std::memory_order_relaxed) != 0)
+    {
+        ++g_allocations;
+    }
+
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+
+}  // ns: anonymous
+
+HeapCounter::HeapCounter() : m_start(g_allocations.load())
+{
+    ++g_counters;
+}
+
+HeapCounter::~HeapCounter()
+{
+    --g_counters;
+}
+
+size_t HeapCounter::allocations() const
+{
+    return g_allocations.load() - m_start;
+}
+
+void* operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
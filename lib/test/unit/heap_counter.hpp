@@ -0,0 +1,43 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROOST_TEST_UNIT_HEAP_COUNTER_HPP
+#define ROOST_TEST_UNIT_HEAP_COUNTER_HPP
+
+#include <cstddef>
+
+/*!
+ * \brief HeapCounter counts the trips to the global heap made while it is alive
+ *
+ * The unit tests replace the global operator new and delete in heap_counter.cpp, a translation
+ * unit of their own so the replacements can't be inlined into (and mismatched with) callers.
+ */
+class HeapCounter
+{
+public:
+    HeapCounter();
+    ~HeapCounter();
+
+    HeapCounter(HeapCounter const&)            = delete;
+    HeapCounter& operator=(HeapCounter const&) = delete;
+
+    //! Returns the number of allocations made since construction
+    size_t allocations() const;
+
+private:
+    size_t m_start;  //!< The global count when constructed
+};  // Class: HeapCounter
+
+#endif  // ROOST_TEST_UNIT_HEAP_COUNTER_HPP
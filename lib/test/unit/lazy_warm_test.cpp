@@ -0,0 +1,246 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "roost/state_machine.hpp"
+
+// A machine with a node whose table can't be created, warmed on a background thread: the warm
+// thread must leave the node (and its errors) to the thread that enters it, and must only
+// allocate from the resource it was given.
+
+namespace lazy_warm
+{
+
+enum class Evt
+{
+    ROOST_NONE,  // Enforced by framework
+    BREAK
+};
+
+static const char* EvtStrings[] = {"NONE", "BREAK"};
+
+ROOST_ENUM_PRINT_HELPER(Evt, EvtStrings)
+
+struct Ctx
+{
+    std::thread::id  main_thread;
+    std::atomic<int> warm_builds;   //!< Tables of Broken created off the main thread
+    std::atomic<int> spare_builds;  //!< Tables of Spare created off the main thread
+};
+
+using SMTypes = roost::NodeAlias<Ctx, Evt>;
+
+class Outsider : public SMTypes::Leaf
+{
+public:
+    using SMTypes::Leaf::Leaf;
+
+    void createTransitionTable() override
+    {
+    }
+};
+
+class Broken : public SMTypes::Leaf
+{
+public:
+    Broken(const char* name, Ctx& ctx, SMTypes::Node* parent)
+        : SMTypes::Leaf(name, ctx, parent), m_outsider("outsider", ctx, nullptr)
+    {
+    }
+
+    void createTransitionTable() override
+    {
+        if (std::this_thread::get_id() != m_ctx.main_thread)
+        {
+            ++m_ctx.warm_builds;
+        }
+
+        addRow(Evt::BREAK, &m_outsider, {}, ROOST_NO_GUARD);
+    }
+
+    Outsider m_outsider;
+};
+
+class Spare : public SMTypes::Leaf
+{
+public:
+    using SMTypes::Leaf::Leaf;
+
+    void createTransitionTable() override
+    {
+        if (std::this_thread::get_id() != m_ctx.main_thread)
+        {
+            ++m_ctx.spare_builds;
+        }
+
+        addRow(Evt::BREAK, ROOST_NO_DEST, {}, ROOST_NO_GUARD);
+    }
+};
+
+class Idle : public SMTypes::Leaf
+{
+public:
+    Idle(const char* name, Ctx& ctx, SMTypes::Node* parent, Broken* broken)
+        : SMTypes::Leaf(name, ctx, parent), m_broken(broken)
+    {
+    }
+
+    void createTransitionTable() override
+    {
+        addRow(Evt::BREAK, m_broken, {}, ROOST_NO_GUARD);
+    }
+
+    Broken* m_broken;
+};
+
+class Root : public SMTypes::Composite
+{
+public:
+    Root(const char* name, Ctx& ctx, SMTypes::Node* parent)
+        : SMTypes::Composite(name, ctx, parent, &m_idle),
+          m_idle("idle", ctx, this, &m_broken),
+          m_broken("broken", ctx, this),
+          m_spare("spare", ctx, this)
+    {
+    }
+
+    void createTransitionTable() override
+    {
+    }
+
+    Idle   m_idle;
+    Broken m_broken;
+    Spare  m_spare;
+};
+
+//! Records the errors and the thread that reported them
+class ErrorSpy : public roost::IErrorSpy<Ctx, Evt>
+{
+public:
+    void no_transition(const char*, Ctx&, Evt const&) override
+    {
+    }
+
+    void error(const char*, Ctx& ctx, const char* main_error, const char*) override
+    {
+        m_errors.push_back(main_error);
+        m_off_main = m_off_main || std::this_thread::get_id() != ctx.main_thread;
+    }
+
+    void error(const char*, Ctx& ctx, Evt const&, const char* main_error, const char*) override
+    {
+        m_errors.push_back(main_error);
+        m_off_main = m_off_main || std::this_thread::get_id() != ctx.main_thread;
+    }
+
+    std::vector<std::string> m_errors;
+    bool                     m_off_main{false};
+};  // Class: ErrorSpy
+
+}  // ns: lazy_warm
+
+TEST(LazyWarmTest, failed_table_reported_on_entry_test)
+{
+    using namespace lazy_warm;
+
+    Ctx ctx;
+    ctx.main_thread = std::this_thread::get_id();
+    ctx.warm_builds  = 0;
+    ctx.spare_builds = 0;
+
+    Root root("root", ctx, nullptr);
+
+    std::shared_ptr<ErrorSpy> spy = std::make_shared<ErrorSpy>();
+
+    SMTypes::StateMachine be("TestBackend", &root, spy);
+    be.setLazyInit(true, true);
+    ASSERT_TRUE(be.init());
+
+    // The warm thread tries the broken table first and gives it back without a word
+    while (ctx.warm_builds.load() == 0)
+    {
+        std::this_thread::yield();
+    }
+
+    be.handleEvent(Evt::BREAK);
+
+    std::vector<std::string> expected_nodes = {"broken"};
+    ASSERT_EQ(be.getCurrentNodes(), expected_nodes);
+
+    be.uninit();
+
+    std::vector<std::string> expected_errors = {
+            "Destination is not part of the state machine", "Failed Lazy Init"};
+
+    ASSERT_EQ(spy->m_errors, expected_errors);
+    ASSERT_FALSE(spy->m_off_main);
+}
+
+TEST(LazyWarmTest, warm_resource_test)
+{
+    using namespace lazy_warm;
+
+    Ctx ctx;
+    ctx.main_thread  = std::this_thread::get_id();
+    ctx.warm_builds  = 0;
+    ctx.spare_builds = 0;
+
+    Root root("root", ctx, nullptr);
+
+    roost::StatsResource main_resource;
+    roost::StatsResource warm_resource;
+
+    std::shared_ptr<ErrorSpy> spy = std::make_shared<ErrorSpy>();
+
+    {
+        SMTypes::StateMachine be("TestBackend", &root, spy, nullptr, &main_resource);
+
+        // A StatsResource can't be shared with the warm thread, so it isn't started
+        be.setLazyInit(true, true);
+        ASSERT_TRUE(be.init());
+
+        std::vector<std::string> expected_errors = {"Can't warm in background"};
+        ASSERT_EQ(spy->m_errors, expected_errors);
+
+        spy->m_errors.clear();
+
+        be.setLazyInit(true, true, &warm_resource);
+        ASSERT_TRUE(be.init());
+        ASSERT_TRUE(spy->m_errors.empty());
+
+        roost::MemoryStats before = main_resource.stats();
+
+        while (ctx.spare_builds.load() == 0)
+        {
+            std::this_thread::yield();
+        }
+
+        // Joining lets the thread finish the table of Spare, which has a row
+        be.uninit();
+
+        ASSERT_GT(warm_resource.stats().allocations, (size_t)0);
+        ASSERT_EQ(warm_resource.stats().bytes_in_use, (size_t)0);
+        ASSERT_EQ(main_resource.stats().allocations, before.allocations);
+    }
+
+    ASSERT_EQ(main_resource.stats().bytes_in_use, (size_t)0);
+}
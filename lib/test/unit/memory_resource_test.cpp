@@ -0,0 +1,215 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "heap_counter.hpp"
+#include "roost/fixed_storage.hpp"
+#include "roost/memory_resource.hpp"
+#include "roost/state_machine.hpp"
+#include "sm1/sm1.hpp"
+
+#include <cstdint>
+#include <new>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+//! Hands out memory from a fixed buffer and never reuses it, like a per-core arena would
+class ArenaResource final : public roost::MemoryResource
+{
+public:
+    ArenaResource() : m_used(0)
+    {
+    }
+
+protected:
+    void* doAllocate(size_t bytes, size_t alignment) override
+    {
+        uintptr_t base  = reinterpret_cast<uintptr_t>(m_buffer);
+        size_t    start = (base + m_used + alignment - 1) / alignment * alignment - base;
+
+        if (start + bytes > sizeof(m_buffer))
+        {
+            throw std::bad_alloc();
+        }
+
+        m_used = start + bytes;
+        return m_buffer + start;
+    }
+
+    void doDeallocate(void*, size_t, size_t) override
+    {
+    }
+
+private:
+    alignas(std::max_align_t) char m_buffer[1 << 20];
+    size_t m_used;
+};  // Class: ArenaResource
+
+}  // ns: anonymous
+
+TEST(MemoryResourceTest, state_machine_allocates_from_resource_test)
+{
+    using namespace sm1;
+
+    static ArenaResource arena;
+    roost::StatsResource stats(&arena);
+
+    {
+        Ctx       ctx;
+        RootState root("root", ctx, nullptr);
+        ctx.m_root = &root;
+
+        SMTypes::StateMachine be("TestBackend", &root, &stats);
+
+        // The spy and the queue
+        size_t constructed = stats.stats().bytes_in_use;
+        ASSERT_GT(constructed, (size_t)0);
+
+        ASSERT_TRUE(be.init());
+        ASSERT_GT(stats.stats().bytes_in_use, constructed);
+
+        // Counts the trips to the global heap, so none can be made by a StateMachine given a
+        // resource
+        HeapCounter heap;
+        size_t      resource_bytes = stats.stats().total_bytes;
+
+        be.handleEvent(Evt::SECOND);
+        be.handleEvent(Evt::FIRST);
+        be.handleEvent(Evt::THIRD);
+        be.handleEvent(Evt::FIRST);
+        be.reset();
+
+        // The selected transitions point into the tables so nothing is allocated at all
+        ASSERT_EQ(heap.allocations(), (size_t)0);
+        ASSERT_EQ(stats.stats().total_bytes, resource_bytes);
+
+        // Only the returned list is allocated, on the heap
+        for (int i = 0; i < 100; ++i)
+        {
+            ASSERT_EQ(be.getCurrentNodes().size(), (size_t)1);
+        }
+
+        ASSERT_EQ(stats.stats().total_bytes, resource_bytes);
+    }
+
+    // Everything went back to the resource
+    ASSERT_EQ(stats.stats().bytes_in_use, (size_t)0);
+    ASSERT_EQ(stats.stats().allocations, stats.stats().deallocations);
+    ASSERT_GE(stats.stats().peak_bytes, stats.stats().total_bytes / stats.stats().allocations);
+}
+
+TEST(MemoryResourceTest, transition_tables_released_test)
+{
+    using namespace sm1;
+
+    roost::StatsResource stats(roost::defaultResource());
+
+    for (int lazy = 0; lazy < 2; ++lazy)
+    {
+        Ctx       ctx;
+        RootState root("root", ctx, nullptr);
+        ctx.m_root = &root;
+
+        SMTypes::StateMachine be("TestBackend", &root, &stats);
+        be.setLazyInit(lazy == 1);
+
+        ASSERT_TRUE(be.init());
+        be.handleEvent(Evt::SECOND);
+        be.handleEvent(Evt::FIRST);
+
+        // Initializing again frees the previous tables instead of stacking new ones on top
+        size_t in_use = stats.stats().bytes_in_use;
+        ASSERT_TRUE(be.init());
+        be.handleEvent(Evt::SECOND);
+        be.handleEvent(Evt::FIRST);
+        ASSERT_EQ(stats.stats().bytes_in_use, in_use);
+    }
+
+    ASSERT_EQ(stats.stats().bytes_in_use, (size_t)0);
+}
+
+TEST(MemoryResourceTest, memory_report_test)
+{
+    using namespace sm1;
+
+    roost::StatsResource stats(roost::defaultResource());
+
+    for (int lazy = 0; lazy < 2; ++lazy)
+    {
+        Ctx       ctx;
+        RootState root("root", ctx, nullptr);
+        ctx.m_root = &root;
+
+        SMTypes::StateMachine be("TestBackend", &root, &stats);
+        be.setLazyInit(lazy == 1);
+
+        size_t constructed = stats.stats().bytes_in_use;
+        ASSERT_TRUE(be.init());
+        be.warmAll();
+
+        // Whatever init() allocated is accounted for, to the byte
+        roost::MemoryReport report    = be.memoryReport();
+        size_t              allocated = report.table_bytes + report.topology_bytes +
+                               report.history_bytes + report.runtime_bytes +
+                               report.dispatch_bytes + report.scratch_bytes;
+        ASSERT_EQ(stats.stats().bytes_in_use - constructed, allocated);
+
+        ASSERT_GT(report.nodes.size(), (size_t)2);
+        ASSERT_STREQ(report.nodes[0].name, "Top");
+        ASSERT_STREQ(report.nodes[1].name, "root");
+        ASSERT_GT(report.spy_bytes, (size_t)0);
+        ASSERT_GT(report.fifo_bytes, (size_t)0);
+
+        size_t table_bytes = 0;
+        size_t num_rows    = 0;
+
+        for (roost::NodeMemory const& node : report.nodes)
+        {
+            table_bytes += node.tableBytes();
+            num_rows += node.num_rows;
+        }
+
+        ASSERT_EQ(table_bytes, report.table_bytes);
+        ASSERT_GT(num_rows, (size_t)0);
+
+        std::ostringstream os;
+        report.toJSON(os);
+        ASSERT_EQ(os.str().find("{\"total_bytes\":" + std::to_string(report.total_bytes)),
+                  (size_t)0);
+        ASSERT_NE(os.str().find("\"name\":\"root\",\"type\":\"COMPOSITE_NODE\""),
+                  std::string::npos);
+    }
+}
+
+TEST(MemoryResourceTest, cache_line_alignment_test)
+{
+    roost::InlineResource<1024> inline_resource;
+    roost::MemoryResource*      resources[] = {roost::defaultResource(), &inline_resource};
+
+    for (roost::MemoryResource* resource : resources)
+    {
+        // Misaligns the next allocation of the inline resource
+        void* small = resource->allocate(8, 8);
+        void* line  = resource->allocate(100, roost::CACHE_LINE_SIZE);
+
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(line) % roost::CACHE_LINE_SIZE, (uintptr_t)0);
+
+        resource->deallocate(line, 100, roost::CACHE_LINE_SIZE);
+        resource->deallocate(small, 8, 8);
+    }
+}
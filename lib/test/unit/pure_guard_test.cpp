@@ -0,0 +1,167 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "roost/state_machine.hpp"
+
+// Two regions with a gate each: the gates have the same pure guard over their own member, which
+// must not be shared, and the same tagged pure guard over the context, which must be.
+
+namespace pure_guard
+{
+
+enum class Evt
+{
+    ROOST_NONE,  // Enforced by framework
+    CHECK,
+    LINK
+};
+
+static const char* EvtStrings[] = {"NONE", "CHECK", "LINK"};
+
+ROOST_ENUM_PRINT_HELPER(Evt, EvtStrings)
+
+//! Tags the link up guard of every gate
+const roost::u32 LINK_UP_TAG = 1;
+
+struct Ctx
+{
+    bool linkUp()
+    {
+        ++link_calls;
+        return link_up;
+    }
+
+    bool link_up;
+    int  link_calls;
+};
+
+using SMTypes = roost::NodeAlias<Ctx, Evt>;
+
+class Gate : public SMTypes::Leaf
+{
+public:
+    Gate(const char* name, Ctx& ctx, SMTypes::Node* parent)
+        : SMTypes::Leaf(name, ctx, parent), m_open(false), m_passed(0), m_failed(0), m_linked(0)
+    {
+    }
+
+    void createTransitionTable() override;
+
+    void pass(Evt const&)
+    {
+        ++m_passed;
+    }
+
+    void fail(Evt const&)
+    {
+        ++m_failed;
+    }
+
+    void link(Evt const&)
+    {
+        ++m_linked;
+    }
+
+    bool m_open;
+    int  m_passed;
+    int  m_failed;
+    int  m_linked;
+};
+
+class Lane : public SMTypes::Region
+{
+public:
+    Lane(const char* name, Ctx& ctx, SMTypes::Node* parent)
+        : SMTypes::Region(name, ctx, parent, &m_gate), m_gate("gate", ctx, this)
+    {
+    }
+
+    Gate m_gate;
+};
+
+class Lanes : public SMTypes::Orthogonal
+{
+public:
+    Lanes(const char* name, Ctx& ctx, SMTypes::Node* parent)
+        : SMTypes::Orthogonal(name, ctx, parent), m_a("a", ctx, this), m_b("b", ctx, this)
+    {
+    }
+
+    void createTransitionTable() override
+    {
+    }
+
+    Lane m_a;
+    Lane m_b;
+};
+
+// clang-format off
+
+void Gate::createTransitionTable()
+{
+    addRow(Evt::CHECK, ROOST_NO_DEST, {ROOST_ACTION(pass)}, ROOST_PURE_GUARD(m_open));
+    addRow(Evt::CHECK, ROOST_NO_DEST, {ROOST_ACTION(fail)}, ROOST_NO_GUARD);
+    addRow(Evt::LINK,  ROOST_NO_DEST, {ROOST_ACTION(link)}, ROOST_PURE_GUARD_TAG(LINK_UP_TAG, m_ctx.linkUp()));
+}
+
+// clang-format on
+
+}  // ns: pure_guard
+
+TEST(PureGuardTest, owner_and_tag_test)
+{
+    using namespace pure_guard;
+
+    Ctx   ctx{true, 0};
+    Lanes lanes("lanes", ctx, nullptr);
+
+    SMTypes::StateMachine be("TestBackend", &lanes);
+    ASSERT_TRUE(be.init());
+
+    Gate& a = lanes.m_a.m_gate;
+    Gate& b = lanes.m_b.m_gate;
+
+    // Same guard text in two nodes, each gets its own result
+    a.m_open = true;
+    be.handleEvent(Evt::CHECK);
+
+    ASSERT_EQ(a.m_passed, 1);
+    ASSERT_EQ(a.m_failed, 0);
+    ASSERT_EQ(b.m_passed, 0);
+    ASSERT_EQ(b.m_failed, 1);
+    ASSERT_EQ(be.pureGuardStats().misses, (roost::u64)2);
+    ASSERT_EQ(be.pureGuardStats().hits, (roost::u64)0);
+
+    // The tagged guard is called once per dispatch, whatever the number of regions
+    be.handleEvent(Evt::LINK);
+
+    ASSERT_EQ(ctx.link_calls, 1);
+    ASSERT_EQ(a.m_linked, 1);
+    ASSERT_EQ(b.m_linked, 1);
+    ASSERT_EQ(be.pureGuardStats().misses, (roost::u64)3);
+    ASSERT_EQ(be.pureGuardStats().hits, (roost::u64)1);
+
+    ctx.link_up = false;
+    be.handleEvent(Evt::LINK);
+
+    ASSERT_EQ(ctx.link_calls, 2);
+    ASSERT_EQ(a.m_linked, 1);
+    ASSERT_EQ(b.m_linked, 1);
+}
@@ -13,7 +13,11 @@
 // limitations under the License.
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
+#include <random>
+#include <sstream>
 
 #include "join_sm/join_sm.hpp"
 #include "ortho_history/ortho_history.hpp"
@@ -71,6 +75,251 @@ TEST_F(RoostTestFixture, event_test)
     ASSERT_EQ(actual_states, expected_states);
 }
 
+TEST_F(RoostTestFixture, lazy_init_test)
+{
+    using namespace sm1;
+
+    std::vector<std::string> traces[2];
+    std::string              scxml[2];
+
+    for (int lazy = 0; lazy < 2; ++lazy)
+    {
+        Ctx       ctx;
+        RootState root("root", ctx, nullptr);
+        ctx.m_root = &root;
+
+        std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(traces[lazy]);
+
+        SMTypes::StateMachine be("TestBackend", &root, std::move(spy));
+        be.setLazyInit(lazy == 1);
+        ASSERT_TRUE(be.init());
+
+        be.handleEvent(Evt::SECOND);
+        be.handleEvent(Evt::FIRST);
+        be.handleEvent(Evt::THIRD);
+        be.handleEvent(Evt::FIRST);
+
+        // Outputting the transitions has to create the tables that were never entered
+        std::stringstream ss;
+        be.getSCXML(ss);
+        scxml[lazy] = ss.str();
+    }
+
+    ASSERT_EQ(traces[0], traces[1]);
+    ASSERT_EQ(scxml[0], scxml[1]);
+}
+
+TEST_F(RoostTestFixture, lazy_init_then_eager_test)
+{
+    using namespace sm1;
+
+    Ctx       ctx;
+    RootState root("root", ctx, nullptr);
+    ctx.m_root = &root;
+
+    SMTypes::StateMachine eager("TestBackend", &root, nullptr);
+    ASSERT_TRUE(eager.init());
+    roost::MemoryReport expected = eager.memoryReport();
+    eager.uninit();
+
+    SMTypes::StateMachine be("TestBackend", &root, nullptr);
+    be.setLazyInit(true);
+    ASSERT_TRUE(be.init());
+    ASSERT_LT(be.memoryReport().table_bytes, expected.table_bytes);
+    be.uninit();
+
+    // Every table is created by the second init(), none may be skipped as still being created
+    be.setLazyInit(false);
+    ASSERT_TRUE(be.init());
+
+    roost::MemoryReport report = be.memoryReport();
+    ASSERT_EQ(report.table_bytes, expected.table_bytes);
+    ASSERT_EQ(report.nodes.size(), expected.nodes.size());
+
+    for (size_t i = 0; i < report.nodes.size(); ++i)
+    {
+        ASSERT_EQ(report.nodes[i].num_rows, expected.nodes[i].num_rows);
+    }
+
+    be.handleEvent(Evt::SECOND);
+    be.handleEvent(Evt::FIRST);
+    be.handleEvent(Evt::THIRD);
+    be.handleEvent(Evt::FIRST);
+
+    std::vector<std::string> expected_nodes = {"sm1111"};
+    ASSERT_EQ(be.getCurrentNodes(), expected_nodes);
+}
+
+TEST_F(RoostTestFixture, flat_dispatch_test)
+{
+    using namespace simple_history;
+
+    std::vector<std::string> traces[2];
+
+    for (int flat = 0; flat < 2; ++flat)
+    {
+        Ctx       ctx;
+        RootState root("root", ctx, nullptr);
+        ctx.m_root = &root;
+
+        std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(traces[flat]);
+
+        SMTypes::StateMachine be("TestBackend", &root, std::move(spy));
+        be.setFlatDispatch(flat == 1);
+        ASSERT_TRUE(be.init());
+        ASSERT_EQ(be.hasFlatDispatch(), flat == 1);
+
+        // Same events and history rows for both, so the traces must match hook for hook
+        std::mt19937 gen(3);
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            ctx.use_deep_history = gen() % 2 == 0;
+            be.handleEvent(static_cast<Evt>(1 + gen() % 7));
+        }
+
+        traces[flat].push_back(be.getCurrentNodes().front());
+
+        ASSERT_TRUE(be.reset());
+        be.handleEvent(Evt::FIRST);
+    }
+
+    ASSERT_EQ(traces[0], traces[1]);
+
+    // Orthogonal nodes are never flattened
+    sm2::Ctx       ctx;
+    sm2::RootState root("s1", ctx, nullptr);
+    ctx.m_root = &root;
+
+    sm2::SMTypes::StateMachine be("TestBackend", &root);
+    be.setFlatDispatch(true);
+    ASSERT_TRUE(be.init());
+    ASSERT_FALSE(be.hasFlatDispatch());
+}
+
+TEST_F(RoostTestFixture, dispatch_cache_test)
+{
+    using namespace sm2;
+
+    std::vector<std::string>  traces[2];
+    roost::DispatchCacheStats stats[2];
+
+    for (int cached = 0; cached < 2; ++cached)
+    {
+        Ctx       ctx;
+        RootState root("s1", ctx, nullptr);
+        ctx.m_root = &root;
+
+        std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(traces[cached]);
+
+        SMTypes::StateMachine be("TestBackend", &root, std::move(spy));
+        be.setDispatchCache(cached == 1);
+        ASSERT_TRUE(be.init());
+
+        // Runs of the same event, so most dispatches find the region where it was
+        std::mt19937 gen(7);
+
+        for (int i = 0; i < 500; ++i)
+        {
+            Evt e = static_cast<Evt>(1 + gen() % 5);
+
+            for (unsigned repeat = gen() % 4; repeat > 0; --repeat)
+            {
+                be.handleEvent(e);
+            }
+        }
+
+        std::vector<std::string> current_nodes = be.getCurrentNodes();
+        traces[cached].insert(traces[cached].end(), current_nodes.begin(), current_nodes.end());
+
+        stats[cached] = be.dispatchCacheStats();
+    }
+
+    ASSERT_EQ(traces[0], traces[1]);
+
+    ASSERT_EQ(stats[0].hits + stats[0].misses, (roost::u64)0);
+    ASSERT_GT(stats[1].hits, (roost::u64)0);
+    ASSERT_GT(stats[1].misses, (roost::u64)0);
+}
+
+TEST_F(RoostTestFixture, lazy_init_background_test)
+{
+    using namespace simple_history;
+
+    std::vector<std::string> traces[2];
+
+    for (int lazy = 0; lazy < 2; ++lazy)
+    {
+        Ctx       ctx;
+        RootState root("RootState", ctx, nullptr);
+        ctx.m_root = &root;
+
+        std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(traces[lazy]);
+
+        SMTypes::StateMachine be("TestBackend", &root, std::move(spy));
+        be.setLazyInit(lazy == 1, true);
+        ASSERT_TRUE(be.init());
+
+        be.handleEvent(Evt::FIRST);
+        be.forceTransitionTo(&root.m_state1);
+        be.handleEvent(Evt::SECOND);
+        be.handleEvent(Evt::FIRST);
+        be.handleEvent(Evt::SECOND);
+        be.handleEvent(Evt::THIRD);
+        be.handleEvent(Evt::SEVENTH);
+        be.handleEvent(Evt::FIFTH);
+
+        std::vector<std::string> expected_nodes = {"State211"};
+        ASSERT_EQ(be.getCurrentNodes(), expected_nodes);
+
+        // Re-initializing must stop and join the warm thread first
+        be.uninit();
+        ASSERT_TRUE(be.init());
+    }
+
+    ASSERT_EQ(traces[0], traces[1]);
+}
+
+TEST_F(RoostTestFixture, topology_cache_test)
+{
+    using namespace join_sm;
+
+    std::string path = ::testing::TempDir() + "roost_join_sm.cache";
+    std::remove(path.c_str());
+
+    // Builds and writes the cache, then loads it, then loads it again after a re-init
+    std::vector<std::string> traces[3];
+
+    for (int run = 0; run < 3; ++run)
+    {
+        Ctx ctx;
+        S1  s1("s1", ctx, nullptr);
+        ctx.m_s1 = &s1;
+
+        std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(traces[run]);
+
+        SMTypes::StateMachine be("TestBackend", &s1, std::move(spy));
+        be.setTopologyCache(path);
+        ASSERT_TRUE(be.init());
+
+        if (run == 2)
+        {
+            ASSERT_TRUE(be.init());
+            traces[run].clear();
+        }
+
+        be.handleEvent(Evt::FIRST);
+        be.handleEvent(Evt::SECOND);
+        be.handleEvent(Evt::THIRD);
+        be.handleEvent(Evt::FOURTH);
+    }
+
+    ASSERT_EQ(traces[0], traces[1]);
+    ASSERT_EQ(std::vector<std::string>(traces[0].begin() + 5, traces[0].end()), traces[2]);
+
+    std::remove(path.c_str());
+}
+
 TEST_F(RoostTestFixture, depth_test)
 {
     using namespace sm1;
@@ -309,6 +558,55 @@ TEST_F(RoostTestFixture, join_smoke_test)
     ASSERT_EQ(current_nodes, expected_nodes);
 }
 
+namespace
+{
+
+//! Records which guards were called, in order
+class JoinGuardSpy : public join_sm::SMTypes::TracingSpy
+{
+public:
+    JoinGuardSpy(std::vector<std::string>& events, std::vector<std::string>& guards)
+        : join_sm::SMTypes::TracingSpy(events), m_guards(guards)
+    {
+    }
+
+    void guard(const char* node_name, join_sm::Ctx&, join_sm::Evt const&, const char*, bool rval)
+            override
+    {
+        m_guards.push_back(std::string(node_name) + (rval ? " passed" : " failed"));
+    }
+
+private:
+    std::vector<std::string>& m_guards;
+};  // Class: JoinGuardSpy
+
+}  // ns: anonymous
+
+TEST_F(RoostTestFixture, join_exited_regions_test)
+{
+    using namespace join_sm;
+
+    Ctx ctx;
+    S1  s1("s1", ctx, nullptr);
+    ctx.m_s1 = &s1;
+
+    std::vector<std::string>      actual_states;
+    std::vector<std::string>      guards;
+    std::shared_ptr<SMTypes::Spy> spy = std::make_shared<JoinGuardSpy>(actual_states, guards);
+
+    SMTypes::StateMachine be("TestBackend", &s1, std::move(spy));
+    ASSERT_TRUE(be.init());
+
+    be.handleEvent(Evt::FIRST);
+    be.handleEvent(Evt::FOURTH);
+
+    std::vector<std::string> expected_nodes = {"SF"};
+    ASSERT_EQ(be.getCurrentNodes(), expected_nodes);
+
+    // The join of the first region exits Ortho1, so the joins of the others are never asked
+    ASSERT_EQ(guards.back(), "SA_JOIN passed");
+}
+
 TEST_F(RoostTestFixture, join_sm_force_transition_test)
 {
     using namespace join_sm;
@@ -452,6 +750,130 @@ TEST_F(RoostTestFixture, shallow_history_default_history_test)
     ASSERT_EQ(current_nodes, expected_nodes);
 }
 
+TEST_F(RoostTestFixture, reset_test)
+{
+    using namespace simple_history;
+    Ctx       ctx;
+    RootState root("RootState", ctx, nullptr);
+    ctx.m_root = &root;
+
+    std::vector<std::string>      actual_states;
+    std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(actual_states);
+
+    SMTypes::StateMachine be("TestBackend", &root, std::move(spy));
+    ASSERT_FALSE(be.reset());
+    ASSERT_TRUE(be.init());
+
+    // Leave State21 as the history of State2
+    be.handleEvent(Evt::FIRST);
+    be.forceTransitionTo(&root.m_state1);
+    be.handleEvent(Evt::SECOND);
+    be.handleEvent(Evt::FIRST);
+    be.handleEvent(Evt::SECOND);
+    be.handleEvent(Evt::THIRD);
+    be.handleEvent(Evt::SEVENTH);
+    be.handleEvent(Evt::FIFTH);
+
+    std::vector<std::string> current_nodes  = be.getCurrentNodes();
+    std::vector<std::string> expected_nodes = {"State211"};
+    ASSERT_EQ(current_nodes, expected_nodes);
+
+    actual_states.clear();
+    ASSERT_TRUE(be.reset(false));
+
+    std::vector<std::string> expected_states = {"OE-RootState", "OE-State1"};
+    ASSERT_EQ(actual_states, expected_states);
+    actual_states.clear();
+
+    // History is back to the initial child
+    be.handleEvent(Evt::FIFTH);
+
+    expected_states = {"OX-State1", "OE-State2", "OE-ShallowHistory", "OE-State22"};
+    ASSERT_EQ(actual_states, expected_states);
+    actual_states.clear();
+
+    ASSERT_TRUE(be.reset());
+
+    expected_states = {"OX-State22", "OX-State2", "OX-RootState", "OE-RootState", "OE-State1"};
+    ASSERT_EQ(actual_states, expected_states);
+
+    current_nodes  = be.getCurrentNodes();
+    expected_nodes = {"State1"};
+    ASSERT_EQ(current_nodes, expected_nodes);
+}
+
+namespace
+{
+
+//! Fires an event from the entry of a node, like an onEntry() that posts one would
+class PostingSpy : public simple_history::SMTypes::TracingSpy
+{
+public:
+    PostingSpy(std::vector<std::string>& events) : simple_history::SMTypes::TracingSpy(events)
+    {
+    }
+
+    void on_entry(const char* node_name, simple_history::Ctx& ctx) override
+    {
+        simple_history::SMTypes::TracingSpy::on_entry(node_name, ctx);
+
+        if (m_sm && m_post_on == node_name)
+        {
+            m_sm->handleEvent(m_event);
+        }
+    }
+
+    void no_transition(const char*, simple_history::Ctx&, simple_history::Evt const&) override
+    {
+        m_events.push_back("NT");
+    }
+
+    simple_history::SMTypes::StateMachine* m_sm{nullptr};
+    std::string                            m_post_on;
+    simple_history::Evt                    m_event{simple_history::Evt::ROOST_NONE};
+};  // Class: PostingSpy
+
+}  // ns: anonymous
+
+TEST_F(RoostTestFixture, reset_post_on_entry_test)
+{
+    using namespace simple_history;
+    Ctx       ctx;
+    RootState root("RootState", ctx, nullptr);
+    ctx.m_root = &root;
+
+    std::vector<std::string>    actual_states;
+    std::shared_ptr<PostingSpy> spy = std::make_shared<PostingSpy>(actual_states);
+
+    SMTypes::StateMachine be("TestBackend", &root, spy);
+    ASSERT_TRUE(be.init());
+
+    be.handleEvent(Evt::FIFTH);
+
+    // The event is queued until State1 is entered and handled from there
+    spy->m_sm      = &be;
+    spy->m_post_on = "State1";
+    spy->m_event   = Evt::FIFTH;
+
+    actual_states.clear();
+    ASSERT_TRUE(be.reset());
+    spy->m_sm = nullptr;
+
+    std::vector<std::string> expected_states = {"OX-State22",
+                                                "OX-State2",
+                                                "OX-RootState",
+                                                "OE-RootState",
+                                                "OE-State1",
+                                                "OX-State1",
+                                                "OE-State2",
+                                                "OE-ShallowHistory",
+                                                "OE-State22"};
+    ASSERT_EQ(actual_states, expected_states);
+
+    std::vector<std::string> expected_nodes = {"State22"};
+    ASSERT_EQ(be.getCurrentNodes(), expected_nodes);
+}
+
 TEST_F(RoostTestFixture, deep_history_smoke_test)
 {
     using namespace simple_history;
@@ -788,3 +1210,183 @@ TEST_F(RoostTestFixture, ortho_history_deep_test)
     expected_nodes = {"State2", "State6", "State9"};
     ASSERT_EQ(current_nodes, expected_nodes);
 }
+
+TEST_F(RoostTestFixture, symbol_file_test)
+{
+    using namespace sm1;
+
+    Ctx       ctx;
+    RootState root("root", ctx, nullptr);
+    ctx.m_root = &root;
+
+    SMTypes::StateMachine be("TestBackend", &root);
+    ASSERT_TRUE(be.init());
+
+    std::stringstream ss;
+    be.getSymbolFile(ss);
+
+    char root_line[64];
+    char action_line[64];
+    std::snprintf(root_line, sizeof(root_line), "%08x root\n", roost::nameId("root"));
+    std::snprintf(
+            action_line,
+            sizeof(action_line),
+            "%08x printSomething\n",
+            roost::nameId("printSomething"));
+
+    // Each name is output once, even if shared by several rows
+    std::string file = ss.str();
+    ASSERT_NE(file.find(root_line), std::string::npos);
+    ASSERT_EQ(file.find(root_line), file.rfind(root_line));
+    ASSERT_NE(file.find(action_line), std::string::npos);
+}
+
+TEST_F(RoostTestFixture, handle_events_test)
+{
+    using namespace join_sm;
+
+    std::mt19937                       gen(11);
+    std::uniform_int_distribution<int> dist(1, 5);
+    std::vector<Evt>                   events;
+
+    for (int i = 0; i < 500; ++i)
+    {
+        events.push_back(static_cast<Evt>(dist(gen)));
+    }
+
+    // One event at a time, then in batches, the actions post events in between
+    std::vector<std::string> traces[2];
+
+    for (int batched = 0; batched < 2; ++batched)
+    {
+        Ctx ctx;
+        S1  s1("s1", ctx, nullptr);
+        ctx.m_s1 = &s1;
+
+        std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(traces[batched]);
+        SMTypes::StateMachine be("TestBackend", &s1, std::move(spy));
+
+        roost::BatchResult result = be.handleEvents(events.data(), 64);
+        ASSERT_EQ(result.handled, (size_t)0);
+        ASSERT_EQ(result.dropped, (size_t)64);
+
+        ASSERT_TRUE(be.init());
+
+        if (!batched)
+        {
+            for (Evt e : events)
+            {
+                be.handleEvent(e);
+            }
+
+            continue;
+        }
+
+        for (size_t first = 0; first < events.size(); first += 64)
+        {
+            size_t count = std::min<size_t>(64, events.size() - first);
+
+            result = be.handleEvents(events.data() + first, count);
+            ASSERT_EQ(result.handled, count);
+            ASSERT_EQ(result.dropped, (size_t)0);
+        }
+    }
+
+    ASSERT_EQ(traces[1], traces[0]);
+}
+
+namespace
+{
+
+//! Counts the tracing hooks that an error spy would ignore
+class CountingErrorSpy : public sm1::SMTypes::IErrorSpy
+{
+public:
+    void on_entry(const char*, sm1::Ctx&) override
+    {
+        ++m_calls;
+    }
+
+    void on_exit(const char*, sm1::Ctx&) override
+    {
+        ++m_calls;
+    }
+
+    void action(const char*, sm1::Ctx&, sm1::Evt const&, const char*) override
+    {
+        ++m_calls;
+    }
+
+    void guard(const char*, sm1::Ctx&, sm1::Evt const&, const char*, bool) override
+    {
+        ++m_calls;
+    }
+
+    void event(const char*, sm1::Ctx&, sm1::Evt const&) override
+    {
+        ++m_calls;
+    }
+
+    void no_transition(const char*, sm1::Ctx&, sm1::Evt const&) override
+    {
+    }
+
+    void error(const char*, sm1::Ctx&, const char*, const char*) override
+    {
+    }
+
+    void error(const char*, sm1::Ctx&, sm1::Evt const&, const char*, const char*) override
+    {
+    }
+
+    int m_calls{0};
+};  // Class: CountingErrorSpy
+
+}  // ns: anonymous
+
+TEST_F(RoostTestFixture, error_spy_not_traced_test)
+{
+    using namespace sm1;
+
+    Ctx       ctx;
+    RootState root("root", ctx, nullptr);
+    ctx.m_root = &root;
+
+    std::shared_ptr<CountingErrorSpy> spy = std::make_shared<CountingErrorSpy>();
+
+    SMTypes::StateMachine be("TestBackend", &root, spy);
+    ASSERT_TRUE(be.init());
+
+    be.handleEvent(Evt::SECOND);
+    be.handleEvent(Evt::FIRST);
+    be.handleEvent(Evt::THIRD);
+    be.handleEvent(Evt::FIRST);
+
+    // Neither called nor given the names of the nodes, actions and guards
+    ASSERT_EQ(spy->m_calls, 0);
+
+    std::vector<std::string> expected_nodes = {"sm1111"};
+    ASSERT_EQ(be.getCurrentNodes(), expected_nodes);
+}
+
+TEST_F(RoostTestFixture, null_spy_test)
+{
+    using namespace sm1;
+
+    Ctx       ctx;
+    RootState root("root", ctx, nullptr);
+    ctx.m_root = &root;
+
+    // A literal nullptr means no spy, not a null resource
+    SMTypes::StateMachine be("TestBackend", &root, nullptr);
+    ASSERT_TRUE(be.init());
+
+    be.handleEvent(Evt::SECOND);
+    be.handleEvent(Evt::FIRST);
+    be.handleEvent(Evt::THIRD);
+    be.handleEvent(Evt::FIRST);
+
+    std::vector<std::string> expected_nodes = {"sm1111"};
+    ASSERT_EQ(be.getCurrentNodes(), expected_nodes);
+    ASSERT_EQ(be.memoryReport().spy_bytes, (size_t)0);
+}
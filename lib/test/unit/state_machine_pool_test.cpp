@@ -0,0 +1,160 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "roost/state_machine.hpp"
+#include "roost/state_machine_pool.hpp"
+#include "simple_history/simple_history.hpp"
+
+#include <functional>
+
+namespace
+{
+
+using namespace simple_history;
+
+using EntryHook = std::function<void(std::string const&)>;
+
+//! Calls a hook on every entry, so a test can act from inside a session like an onEntry() could
+class EntryHookSpy : public SMTypes::TracingSpy
+{
+public:
+    EntryHookSpy(std::vector<std::string>& events, EntryHook* hook)
+        : SMTypes::TracingSpy(events), m_hook(hook)
+    {
+    }
+
+    void on_entry(const char* node_name, Ctx& ctx) override
+    {
+        SMTypes::TracingSpy::on_entry(node_name, ctx);
+
+        if (m_hook && *m_hook)
+        {
+            (*m_hook)(node_name);
+        }
+    }
+
+private:
+    EntryHook* m_hook;
+};  // Class: EntryHookSpy
+
+struct Session
+{
+    explicit Session(std::vector<std::string>* trace, EntryHook* hook = nullptr)
+        : m_ctx(),
+          m_root("RootState", m_ctx, nullptr),
+          m_sm("Session", &m_root, std::make_shared<EntryHookSpy>(*trace, hook))
+    {
+        m_ctx.m_root = &m_root;
+    }
+
+    SMTypes::StateMachine& stateMachine()
+    {
+        return m_sm;
+    }
+
+    Ctx                   m_ctx;
+    RootState             m_root;
+    SMTypes::StateMachine m_sm;
+};  // Struct: Session
+
+using Pool = roost::StateMachinePool<Session>;
+
+}  // ns: anonymous
+
+TEST(StateMachinePoolTest, acquire_release_test)
+{
+    std::vector<std::string> trace;
+    Pool                     pool(2, &trace);
+
+    ASSERT_EQ(pool.acquire(), nullptr);
+    ASSERT_TRUE(pool.init());
+    ASSERT_EQ(pool.available(), (size_t)2);
+
+    std::vector<std::string> initial_nodes = {"State1"};
+
+    Pool::Handle first = pool.acquire();
+    ASSERT_NE(first, nullptr);
+    ASSERT_EQ(first->stateMachine().getCurrentNodes(), initial_nodes);
+
+    first->stateMachine().handleEvent(Evt::FIRST);
+    ASSERT_NE(first->stateMachine().getCurrentNodes(), initial_nodes);
+
+    {
+        Pool::Handle second = pool.acquire();
+        ASSERT_NE(second, nullptr);
+        ASSERT_NE(second.get(), first.get());
+        ASSERT_EQ(pool.acquire(), nullptr);
+    }
+
+    ASSERT_EQ(pool.available(), (size_t)1);
+
+    // A released session is exited and re-entered, so it is handed out in its initial state
+    Session* session = first.get();
+    trace.clear();
+    first.reset();
+
+    ASSERT_EQ(trace.front(), "OX-State22");
+    ASSERT_EQ(trace.back(), "OE-State1");
+    ASSERT_EQ(pool.available(), (size_t)2);
+
+    pool.setExitHooksOnRelease(false);
+
+    Pool::Handle again = pool.acquire();
+    ASSERT_EQ(again.get(), session);
+    ASSERT_EQ(again->stateMachine().getCurrentNodes(), initial_nodes);
+
+    again->stateMachine().handleEvent(Evt::FIRST);
+    trace.clear();
+    again.reset();
+
+    ASSERT_EQ(trace.front(), "OE-RootState");
+}
+
+TEST(StateMachinePoolTest, release_while_busy_test)
+{
+    std::vector<std::string> trace;
+    EntryHook                hook;
+    Pool                     pool(1, &trace, &hook);
+
+    ASSERT_TRUE(pool.init());
+
+    Pool::Handle handle  = pool.acquire();
+    Session*     session = handle.get();
+
+    // Dropped while the session is handling an event, so it can't be reset yet
+    hook = [&handle](std::string const& node) {
+        if (node == "State22")
+        {
+            handle.reset();
+        }
+    };
+
+    session->stateMachine().handleEvent(Evt::FIFTH);
+    hook = nullptr;
+
+    ASSERT_EQ(handle, nullptr);
+    ASSERT_EQ(pool.available(), (size_t)1);
+
+    std::vector<std::string> nodes = {"State22"};
+    ASSERT_EQ(session->stateMachine().getCurrentNodes(), nodes);
+
+    // Reset on the way out
+    Pool::Handle again = pool.acquire();
+    ASSERT_EQ(again.get(), session);
+
+    nodes = {"State1"};
+    ASSERT_EQ(again->stateMachine().getCurrentNodes(), nodes);
+}
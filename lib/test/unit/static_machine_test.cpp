@@ -0,0 +1,227 @@
+// Copyright (c) 2023. Akiscode
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+
+#include "roost/state_machine.hpp"
+#include "roost/static_machine.hpp"
+#include "simple_history/simple_history.hpp"
+#include "simple_history/simple_history_static.hpp"
+#include "sm1/sm1.hpp"
+#include "sm1/sm1_static.hpp"
+
+// A StaticMachine must behave exactly like a StateMachine built from the same machine, so both
+// are driven with the same events and compared hook for hook.
+
+namespace
+{
+
+const size_t NUM_RANDOM_EVENTS = 2000;
+
+template <typename E>
+std::vector<E> randomEvents(int num_event_types, unsigned seed)
+{
+    std::mt19937                       gen(seed);
+    std::uniform_int_distribution<int> dist(1, num_event_types);
+
+    std::vector<E> rval;
+
+    for (size_t i = 0; i < NUM_RANDOM_EVENTS; ++i)
+    {
+        rval.push_back(static_cast<E>(dist(gen)));
+    }
+
+    return rval;
+}
+
+//! Calls a function on every entry, which may fire an event like an onEntry() could
+class EntrySpy : public simple_history::SMTypes::TracingSpy
+{
+public:
+    EntrySpy(std::vector<std::string>& events, std::function<void(std::string const&)>& on_entry)
+        : simple_history::SMTypes::TracingSpy(events), m_on_entry(&on_entry)
+    {
+    }
+
+    void on_entry(const char* node_name, simple_history::Ctx& ctx) override
+    {
+        simple_history::SMTypes::TracingSpy::on_entry(node_name, ctx);
+
+        if (*m_on_entry)
+        {
+            (*m_on_entry)(node_name);
+        }
+    }
+
+private:
+    std::function<void(std::string const&)>* m_on_entry;
+};  // Class: EntrySpy
+
+}  // ns: anonymous
+
+TEST(StaticMachineTest, no_vtable_test)
+{
+    ASSERT_FALSE(std::is_polymorphic<sm1_static::Machine<>>::value);
+    ASSERT_FALSE(std::is_polymorphic<simple_history_static::Machine<>>::value);
+}
+
+TEST(StaticMachineTest, sm1_test)
+{
+    using namespace sm1;
+
+    Ctx       ctx;
+    RootState root("root", ctx, nullptr);
+    ctx.m_root = &root;
+
+    std::vector<std::string>      actual_states;
+    std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(actual_states);
+
+    SMTypes::StateMachine be("TestBackend", &root, std::move(spy));
+    ASSERT_TRUE(be.init());
+
+    Ctx                                      static_ctx;
+    std::vector<std::string>                 static_states;
+    sm1_static::Machine<SMTypes::TracingSpy> fsm(
+            "TestBackend", static_ctx, SMTypes::TracingSpy(static_states));
+    ASSERT_TRUE(fsm.init());
+
+    ASSERT_EQ(static_states, actual_states);
+    ASSERT_EQ(fsm.getCurrentNodes(), be.getCurrentNodes());
+
+    for (auto e : randomEvents<Evt>(3, 1))
+    {
+        actual_states.clear();
+        static_states.clear();
+
+        be.handleEvent(e);
+        fsm.handleEvent(e);
+
+        ASSERT_EQ(static_states, actual_states) << "Event: " << e;
+        ASSERT_EQ(fsm.getCurrentNodes(), be.getCurrentNodes()) << "Event: " << e;
+    }
+
+    actual_states.clear();
+    static_states.clear();
+
+    be.forceTransitionTo(&root.m_sm12.m_sm121);
+    fsm.forceTransitionTo<sm1_static::SM121>();
+
+    ASSERT_EQ(static_states, actual_states);
+    ASSERT_TRUE(fsm.isCurrent<sm1_static::SM121>());
+    ASSERT_EQ(fsm.getCurrentNodes(), be.getCurrentNodes());
+
+    actual_states.clear();
+    static_states.clear();
+
+    ASSERT_TRUE(be.reset());
+    ASSERT_TRUE(fsm.reset());
+
+    ASSERT_EQ(static_states, actual_states);
+    ASSERT_EQ(fsm.getCurrentNodes(), be.getCurrentNodes());
+}
+
+TEST(StaticMachineTest, simple_history_test)
+{
+    using namespace simple_history;
+
+    Ctx       ctx;
+    RootState root("root", ctx, nullptr);
+    ctx.m_root = &root;
+
+    std::vector<std::string>      actual_states;
+    std::shared_ptr<SMTypes::Spy> spy = std::make_shared<SMTypes::TracingSpy>(actual_states);
+
+    SMTypes::StateMachine be("TestBackend", &root, std::move(spy));
+    ASSERT_TRUE(be.init());
+
+    Ctx                                                 static_ctx;
+    std::vector<std::string>                            static_states;
+    simple_history_static::Machine<SMTypes::TracingSpy> fsm(
+            "TestBackend", static_ctx, SMTypes::TracingSpy(static_states));
+    ASSERT_TRUE(fsm.init());
+
+    ASSERT_EQ(static_states, actual_states);
+    ASSERT_EQ(fsm.getCurrentNodes(), be.getCurrentNodes());
+
+    std::mt19937 gen(5);
+    size_t       history_entries = 0;
+
+    for (auto e : randomEvents<Evt>(7, 4))
+    {
+        actual_states.clear();
+        static_states.clear();
+
+        // Switches between the shallow and the deep history rows
+        ctx.use_deep_history        = gen() % 2 == 0;
+        static_ctx.use_deep_history = ctx.use_deep_history;
+
+        be.handleEvent(e);
+        fsm.handleEvent(e);
+
+        ASSERT_EQ(static_states, actual_states) << "Event: " << e;
+        ASSERT_EQ(fsm.getCurrentNodes(), be.getCurrentNodes()) << "Event: " << e;
+
+        history_entries += std::count(
+                static_states.begin(), static_states.end(), std::string("OE-DeepHistory"));
+        history_entries += std::count(
+                static_states.begin(), static_states.end(), std::string("OE-ShallowHistory"));
+    }
+
+    ASSERT_GT(history_entries, (size_t)0);
+}
+
+TEST(StaticMachineTest, reset_post_on_entry_test)
+{
+    using namespace simple_history;
+
+    Ctx                                     ctx;
+    std::vector<std::string>                states;
+    std::function<void(std::string const&)> on_entry;
+
+    simple_history_static::Machine<EntrySpy> fsm("TestBackend", ctx, EntrySpy(states, on_entry));
+    ASSERT_TRUE(fsm.init());
+
+    fsm.handleEvent(Evt::FIFTH);
+
+    // The event is queued until State1 is entered and handled from there
+    on_entry = [&fsm](std::string const& node) {
+        if (node == "State1")
+        {
+            fsm.handleEvent(Evt::FIFTH);
+        }
+    };
+
+    states.clear();
+    ASSERT_TRUE(fsm.reset());
+    on_entry = nullptr;
+
+    std::vector<std::string> expected_states = {"OX-State22",
+                                                "OX-State2",
+                                                "OX-root",
+                                                "OE-root",
+                                                "OE-State1",
+                                                "OX-State1",
+                                                "OE-State2",
+                                                "OE-ShallowHistory",
+                                                "OE-State22"};
+    ASSERT_EQ(states, expected_states);
+
+    std::vector<std::string> expected_nodes = {"State22"};
+    ASSERT_EQ(fsm.getCurrentNodes(), expected_nodes);
+}